@@ -0,0 +1,76 @@
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG -= qt
+
+TARGET = hana_bench
+
+LIBS += -lz
+
+INCLUDEPATH = ../shared ../extract/src ../draft/src ../partition/src ../ordering/src ../orientation/src
+
+SOURCES += \
+    ../shared/hmr_algorithm.cpp \
+    ../shared/hmr_args.cpp \
+    ../shared/hmr_bam.cpp \
+    ../shared/hmr_bgzf.cpp \
+    ../shared/hmr_bin_file.cpp \
+    ../shared/hmr_bin_queue.cpp \
+    ../shared/hmr_contig_graph.cpp \
+    ../shared/hmr_enzyme.cpp \
+    ../shared/hmr_fasta.cpp \
+    ../shared/hmr_gz.cpp \
+    ../shared/hmr_path.cpp \
+    ../shared/hmr_seq.cpp \
+    ../shared/hmr_stats.cpp \
+    ../shared/hmr_text_file.cpp \
+    ../shared/hmr_ui.cpp \
+    ../extract/src/extract_fasta.cpp \
+    ../draft/src/draft_stream.cpp \
+    ../partition/src/partition.cpp \
+    ../ordering/src/ordering_ea.cpp \
+    ../ordering/src/ordering_links.cpp \
+    ../ordering/src/ordering_loader.cpp \
+    ../orientation/src/orientation.cpp \
+    src/args_bench.cpp \
+    src/bench_gen.cpp \
+    src/bench_stage.cpp \
+    src/main.cpp
+
+HEADERS += \
+    ../shared/hmr_algorithm.hpp \
+    ../shared/hmr_args.hpp \
+    ../shared/hmr_args_types.hpp \
+    ../shared/hmr_bam.hpp \
+    ../shared/hmr_bgzf.hpp \
+    ../shared/hmr_bin_file.hpp \
+    ../shared/hmr_bin_queue.hpp \
+    ../shared/hmr_char.hpp \
+    ../shared/hmr_contig_graph.hpp \
+    ../shared/hmr_contig_graph_type.hpp \
+    ../shared/hmr_enzyme.hpp \
+    ../shared/hmr_fasta.hpp \
+    ../shared/hmr_global.hpp \
+    ../shared/hmr_gz.hpp \
+    ../shared/hmr_path.hpp \
+    ../shared/hmr_seq.hpp \
+    ../shared/hmr_stats.hpp \
+    ../shared/hmr_text_file.hpp \
+    ../shared/hmr_task_scheduler.hpp \
+    ../shared/hmr_ui.hpp \
+    ../extract/src/extract_fasta.hpp \
+    ../extract/src/extract_fasta_type.hpp \
+    ../extract/src/extract_mapping.hpp \
+    ../extract/src/extract_mapping_type.hpp \
+    ../draft/src/draft_mappings_type.hpp \
+    ../draft/src/draft_stream.hpp \
+    ../partition/src/partition.hpp \
+    ../partition/src/partition_type.hpp \
+    ../ordering/src/ordering_ea.hpp \
+    ../ordering/src/ordering_links.hpp \
+    ../ordering/src/ordering_loader.hpp \
+    ../ordering/src/ordering_type.hpp \
+    ../orientation/src/orientation.hpp \
+    src/args_bench.hpp \
+    src/bench_gen.hpp \
+    src/bench_stage.hpp
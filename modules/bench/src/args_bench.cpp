@@ -0,0 +1,23 @@
+#include <cstdlib>
+
+#include "args_bench.hpp"
+
+#include "hmr_args_types.hpp"
+
+HMR_ARGS opts;
+
+HMR_ARG_PARSER args_parser = {
+    { {"-o", "--output"}, "OUTPUT", "Synthetic data file prefix", LAMBDA_PARSE_ARG {opts.output = arg[0]; }},
+    { {"-s", "--seed"}, "SEED", "Random seed of the synthetic data (default: 806)", LAMBDA_PARSE_ARG {opts.seed = atoll(arg[0]); }},
+    { {"-c", "--chromosomes"}, "CHROMOSOMES", "Number of chromosomes (default: 4)", LAMBDA_PARSE_ARG {opts.chromosomes = atoi(arg[0]); }},
+    { {"-l", "--length"}, "LENGTH", "Chromosome length (unit: K, default: 4000)", LAMBDA_PARSE_ARG {opts.chromosome_length = atoi(arg[0]); }},
+    { {"-p", "--pairs"}, "PAIRS", "Number of Hi-C read pairs (unit: K, default: 1000)", LAMBDA_PARSE_ARG {opts.pairs = atoi(arg[0]); }},
+    { {"-e", "--enzyme"}, "ENZYME", "Enzyme site planted in the genome (default: GATC)", LAMBDA_PARSE_ARG {opts.enzyme = arg[0]; }},
+    { {"-t", "--threads"}, "THREADS", "Number of threads (default: 1)", LAMBDA_PARSE_ARG { opts.threads = atoi(arg[0]); }},
+    { {"--contig-min"}, "CONTIG_MIN", "Minimum contig length (unit: K, default: 20)", LAMBDA_PARSE_ARG {opts.contig_min = atoi(arg[0]); }},
+    { {"--contig-max"}, "CONTIG_MAX", "Maximum contig length (unit: K, default: 200)", LAMBDA_PARSE_ARG {opts.contig_max = atoi(arg[0]); }},
+    { {"--site-gap"}, "SITE_GAP", "Average distance between the planted enzyme sites (default: 400)", LAMBDA_PARSE_ARG {opts.site_gap = atoi(arg[0]); }},
+    { {"--noise"}, "NOISE", "Ratio of the random pairs out of the distance decay (default: 0.05)", LAMBDA_PARSE_ARG {opts.noise = atof(arg[0]); }},
+    { {"--ngen"}, "NUM_OF_GENERATION", "Generations of the evaluation algorithm benchmark (default: 200)", LAMBDA_PARSE_ARG {opts.ngen = atoi(arg[0]); }},
+    { {"--stats"}, "STATS", "Save the stage timings, counters and peak memory as JSON", LAMBDA_PARSE_ARG {opts.stats = arg[0]; }},
+};
@@ -0,0 +1,19 @@
+#ifndef ARGS_BENCH_H
+#define ARGS_BENCH_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+
+typedef struct HMR_ARGS
+{
+    const char* output = NULL;
+    const char* enzyme = "GATC";
+    const char* stats = NULL;
+    double noise = 0.05;
+    int chromosomes = 4, chromosome_length = 4000, contig_min = 20, contig_max = 200, site_gap = 400, pairs = 1000;
+    int threads = 1, ngen = 200;
+    uint64_t seed = 806;
+} HMR_ARGS;
+
+#endif // ARGS_BENCH_H
@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "hmr_bgzf.hpp"
+#include "hmr_bin_file.hpp"
+#include "hmr_text_file.hpp"
+#include "hmr_ui.hpp"
+
+#include "bench_gen.hpp"
+
+//Length of the simulated reads.
+constexpr int32_t BENCH_READ_LENGTH = 150;
+//Maximum offset of a read start to its enzyme site.
+constexpr int32_t BENCH_SITE_JITTER = 100;
+//Shortest distance of the distance decay contacts.
+constexpr double BENCH_MIN_DISTANCE = 1000.0;
+//FASTA line width.
+constexpr size_t BENCH_FASTA_LINE = 60;
+
+typedef struct BENCH_BAM_WRITER
+{
+    FILE* bam_file;
+    std::vector<char> data;
+    std::vector<char> block;
+} BENCH_BAM_WRITER;
+
+typedef struct BENCH_READ
+{
+    const BENCH_CONTIG* contig;
+    int32_t pos; // Leftmost position on the contig, 0-based.
+} BENCH_READ;
+
+std::string bench_path_fasta(const char* prefix)
+{
+    return std::string(prefix) + ".fasta";
+}
+
+std::string bench_path_bam(const char* prefix)
+{
+    return std::string(prefix) + ".bam";
+}
+
+std::string bench_path_pairs(const char* prefix)
+{
+    return std::string(prefix) + ".pairs";
+}
+
+std::string bench_path_truth(const char* prefix)
+{
+    return std::string(prefix) + ".truth";
+}
+
+inline char bench_base_complement(char base)
+{
+    switch (base)
+    {
+    case 'A': return 'T';
+    case 'C': return 'G';
+    case 'G': return 'C';
+    case 'T': return 'A';
+    default: return 'N';
+    }
+}
+
+inline char bench_contig_base(const std::vector<std::string>& genome, const BENCH_CONTIG& contig, int32_t pos)
+{
+    const std::string& seq = genome[contig.chromosome];
+    return contig.reversed ? bench_base_complement(seq[contig.start + contig.length - 1 - pos]) : seq[contig.start + pos];
+}
+
+void bench_bam_flush(BENCH_BAM_WRITER& writer, size_t data_size)
+{
+    size_t block_size = hmr_bgzf_deflate_block(writer.data.data(), data_size, writer.block.data());
+    fwrite(writer.block.data(), 1, block_size, writer.bam_file);
+    writer.data.erase(writer.data.begin(), writer.data.begin() + data_size);
+}
+
+void bench_bam_write(BENCH_BAM_WRITER& writer, const void* data, size_t data_size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    writer.data.insert(writer.data.end(), bytes, bytes + data_size);
+    while (writer.data.size() >= HMR_BGZF_BLOCK_DATA)
+    {
+        bench_bam_flush(writer, HMR_BGZF_BLOCK_DATA);
+    }
+}
+
+template <typename T>
+inline void bench_bam_write_value(BENCH_BAM_WRITER& writer, T value)
+{
+    bench_bam_write(writer, &value, sizeof(T));
+}
+
+inline uint16_t bench_bam_bin(int32_t start, int32_t end)
+{
+    //Smallest bin contains the range, the same as the SAM specification.
+    --end;
+    if (start >> 14 == end >> 14) return static_cast<uint16_t>(((1 << 15) - 1) / 7 + (start >> 14));
+    if (start >> 17 == end >> 17) return static_cast<uint16_t>(((1 << 12) - 1) / 7 + (start >> 17));
+    if (start >> 20 == end >> 20) return static_cast<uint16_t>(((1 << 9) - 1) / 7 + (start >> 20));
+    if (start >> 23 == end >> 23) return static_cast<uint16_t>(((1 << 6) - 1) / 7 + (start >> 23));
+    if (start >> 26 == end >> 26) return static_cast<uint16_t>(((1 << 3) - 1) / 7 + (start >> 26));
+    return 0;
+}
+
+void bench_bam_record(BENCH_BAM_WRITER& writer, const std::vector<std::string>& genome, const char* name, const BENCH_READ& read, const BENCH_READ& mate, uint16_t flag)
+{
+    static const char* BAM_BASES = "=ACMGRSVTWYHKDBN";
+    const uint8_t name_size = static_cast<uint8_t>(strlen(name) + 1);
+    const uint32_t seq_bytes = (BENCH_READ_LENGTH + 1) >> 1;
+    const int32_t tlen = read.contig == mate.contig ? mate.pos - read.pos + (mate.pos >= read.pos ? BENCH_READ_LENGTH : -BENCH_READ_LENGTH) : 0;
+    //The block size does not include itself.
+    bench_bam_write_value<uint32_t>(writer, 32 + name_size + 4 + seq_bytes + BENCH_READ_LENGTH);
+    bench_bam_write_value<int32_t>(writer, read.contig->id);
+    bench_bam_write_value<int32_t>(writer, read.pos);
+    bench_bam_write_value<uint8_t>(writer, name_size);
+    bench_bam_write_value<uint8_t>(writer, 60);
+    bench_bam_write_value<uint16_t>(writer, bench_bam_bin(read.pos, read.pos + BENCH_READ_LENGTH));
+    bench_bam_write_value<uint16_t>(writer, 1);
+    bench_bam_write_value<uint16_t>(writer, flag);
+    bench_bam_write_value<uint32_t>(writer, BENCH_READ_LENGTH);
+    bench_bam_write_value<int32_t>(writer, mate.contig->id);
+    bench_bam_write_value<int32_t>(writer, mate.pos);
+    bench_bam_write_value<int32_t>(writer, tlen);
+    bench_bam_write(writer, name, name_size);
+    //A single match CIGAR.
+    bench_bam_write_value<uint32_t>(writer, static_cast<uint32_t>(BENCH_READ_LENGTH) << 4);
+    //The 4-bit bases of the contig, then the qualities.
+    char seq[(BENCH_READ_LENGTH + 1) >> 1], qual[BENCH_READ_LENGTH];
+    memset(seq, 0, sizeof(seq));
+    for (int32_t i = 0; i < BENCH_READ_LENGTH; ++i)
+    {
+        char base = bench_contig_base(genome, *read.contig, read.pos + i);
+        uint8_t code = static_cast<uint8_t>(strchr(BAM_BASES, base) - BAM_BASES);
+        seq[i >> 1] |= static_cast<char>((i & 1) ? code : (code << 4));
+    }
+    memset(qual, 30, sizeof(qual));
+    bench_bam_write(writer, seq, seq_bytes);
+    bench_bam_write(writer, qual, sizeof(qual));
+}
+
+inline int32_t bench_site_read(BENCH_RNG& rng, const std::vector<int32_t>& sites, int32_t target, int32_t length)
+{
+    //Snap to the nearest enzyme site, then jitter the read start around it.
+    auto iter = std::lower_bound(sites.begin(), sites.end(), target);
+    int32_t site;
+    if (iter == sites.end())
+    {
+        site = sites.back();
+    }
+    else if (iter != sites.begin() && target - *(iter - 1) < *iter - target)
+    {
+        site = *(iter - 1);
+    }
+    else
+    {
+        site = *iter;
+    }
+    int32_t pos = site + static_cast<int32_t>(bench_rng_range(rng, 2 * BENCH_SITE_JITTER + 1)) - BENCH_SITE_JITTER;
+    return std::min(std::max(pos, 0), length - BENCH_READ_LENGTH);
+}
+
+inline BENCH_READ bench_read_locate(const BENCH_TRUTH& contigs, const std::vector<int32_t>& first_contigs, int32_t chromosome, int32_t pos)
+{
+    //Find the contig covers the read start in the chromosome.
+    int32_t left = first_contigs[chromosome], right = first_contigs[chromosome + 1] - 1;
+    while (left < right)
+    {
+        int32_t mid = (left + right + 1) >> 1;
+        if (contigs[mid].start <= pos)
+        {
+            left = mid;
+        }
+        else
+        {
+            right = mid - 1;
+        }
+    }
+    const BENCH_CONTIG& contig = contigs[left];
+    int32_t offset = pos - contig.start;
+    if (contig.reversed)
+    {
+        offset = contig.length - offset - BENCH_READ_LENGTH;
+    }
+    //Keep the read inside the contig.
+    offset = std::min(std::max(offset, 0), contig.length - BENCH_READ_LENGTH);
+    return BENCH_READ{ &contig, offset };
+}
+
+void bench_generate(const char* prefix, const BENCH_GEN_CONFIG& config)
+{
+    BENCH_RNG rng{ config.seed };
+    const int32_t enzyme_length = static_cast<int32_t>(strlen(config.enzyme)), length = config.chromosome_length;
+    if (config.contig_min < BENCH_READ_LENGTH || config.contig_max < config.contig_min || length < config.contig_min)
+    {
+        time_error(-1, "Invalid contig length range %d-%d for chromosome length %d.", config.contig_min, config.contig_max, length);
+    }
+    //Random bases with the enzyme sites planted.
+    time_print("Generating %d chromosome(s) of %d bp...", config.chromosomes, length);
+    std::vector<std::string> genome(config.chromosomes);
+    std::vector<std::vector<int32_t> > sites(config.chromosomes);
+    size_t total_sites = 0;
+    for (int32_t c = 0; c < config.chromosomes; ++c)
+    {
+        std::string& seq = genome[c];
+        seq.resize(length);
+        for (int32_t i = 0; i < length;)
+        {
+            uint64_t bits = bench_rng_next(rng);
+            for (int32_t k = 0; k < 32 && i < length; ++k, ++i)
+            {
+                seq[i] = "ACGT"[bits & 3];
+                bits >>= 2;
+            }
+        }
+        for (int64_t pos = static_cast<int64_t>(bench_rng_range(rng, 2 * config.site_gap + 1)); pos + enzyme_length <= length;
+            pos += enzyme_length + static_cast<int64_t>(bench_rng_range(rng, 2 * config.site_gap + 1)))
+        {
+            memcpy(&seq[pos], config.enzyme, enzyme_length);
+            sites[c].push_back(static_cast<int32_t>(pos));
+        }
+        if (sites[c].empty())
+        {
+            time_error(-1, "No enzyme site could be planted in chromosome %d.", c + 1);
+        }
+        total_sites += sites[c].size();
+    }
+    time_print("%zu enzyme site(s) planted.", total_sites);
+    //Cut the chromosomes into contigs, some of them are reversed.
+    BENCH_TRUTH contigs;
+    std::vector<int32_t> first_contigs;
+    for (int32_t c = 0; c < config.chromosomes; ++c)
+    {
+        first_contigs.push_back(static_cast<int32_t>(contigs.size()));
+        for (int32_t start = 0; start < length;)
+        {
+            int32_t contig_length = config.contig_min + static_cast<int32_t>(bench_rng_range(rng, config.contig_max - config.contig_min + 1));
+            if (length - start - contig_length < config.contig_min)
+            {
+                contig_length = length - start;
+            }
+            contigs.push_back(BENCH_CONTIG{ -1, c, start, contig_length, static_cast<int32_t>(bench_rng_range(rng, 2)) });
+            start += contig_length;
+        }
+    }
+    first_contigs.push_back(static_cast<int32_t>(contigs.size()));
+    //Shuffle the contigs in the FASTA.
+    int32_t num_of_contigs = static_cast<int32_t>(contigs.size());
+    std::vector<int32_t> fasta_order(num_of_contigs);
+    for (int32_t i = 0; i < num_of_contigs; ++i)
+    {
+        fasta_order[i] = i;
+    }
+    for (int32_t i = num_of_contigs - 1; i > 0; --i)
+    {
+        std::swap(fasta_order[i], fasta_order[bench_rng_range(rng, i + 1)]);
+    }
+    std::vector<std::string> names(num_of_contigs);
+    for (int32_t i = 0; i < num_of_contigs; ++i)
+    {
+        contigs[fasta_order[i]].id = i;
+        names[i] = "ctg" + std::to_string(i + 1);
+    }
+    //Write the FASTA.
+    std::string fasta_path = bench_path_fasta(prefix);
+    time_print("Writing %d contig(s) to %s", num_of_contigs, fasta_path.c_str());
+    FILE* fasta_file;
+    if (!text_open_write(fasta_path.c_str(), &fasta_file))
+    {
+        time_error(-1, "Failed to create FASTA file %s", fasta_path.c_str());
+    }
+    std::string line;
+    for (int32_t i = 0; i < num_of_contigs; ++i)
+    {
+        const BENCH_CONTIG& contig = contigs[fasta_order[i]];
+        fprintf(fasta_file, ">%s\n", names[i].c_str());
+        for (int32_t pos = 0; pos < contig.length; pos += static_cast<int32_t>(BENCH_FASTA_LINE))
+        {
+            line.clear();
+            for (int32_t j = pos; j < contig.length && j < pos + static_cast<int32_t>(BENCH_FASTA_LINE); ++j)
+            {
+                line.push_back(bench_contig_base(genome, contig, j));
+            }
+            line.push_back('\n');
+            fwrite(line.data(), 1, line.size(), fasta_file);
+        }
+    }
+    fclose(fasta_file);
+    //Write the truth layout.
+    std::string truth_path = bench_path_truth(prefix);
+    time_print("Writing contig layout to %s", truth_path.c_str());
+    FILE* truth_file;
+    if (!text_open_write(truth_path.c_str(), &truth_file))
+    {
+        time_error(-1, "Failed to create truth file %s", truth_path.c_str());
+    }
+    fprintf(truth_file, "#id\tchromosome\tstart\tlength\treversed\n");
+    for (const BENCH_CONTIG& contig : contigs)
+    {
+        fprintf(truth_file, "%d\t%d\t%d\t%d\t%d\n", contig.id, contig.chromosome, contig.start, contig.length, contig.reversed);
+    }
+    fclose(truth_file);
+    //Prepare the BAM and the pairs headers.
+    std::string bam_path = bench_path_bam(prefix), pairs_path = bench_path_pairs(prefix);
+    BENCH_BAM_WRITER bam_writer;
+    if (!bin_open(bam_path.c_str(), &bam_writer.bam_file, "wb"))
+    {
+        time_error(-1, "Failed to create BAM file %s", bam_path.c_str());
+    }
+    bam_writer.block.resize(HMR_BGZF_BLOCK_MAX);
+    FILE* pairs_file;
+    if (!text_open_write(pairs_path.c_str(), &pairs_file))
+    {
+        time_error(-1, "Failed to create pairs file %s", pairs_path.c_str());
+    }
+    std::string header_text = "@HD\tVN:1.6\tSO:unsorted\n";
+    fprintf(pairs_file, "## pairs format v1.0\n");
+    for (int32_t i = 0; i < num_of_contigs; ++i)
+    {
+        int32_t contig_length = contigs[fasta_order[i]].length;
+        header_text += "@SQ\tSN:" + names[i] + "\tLN:" + std::to_string(contig_length) + "\n";
+        fprintf(pairs_file, "#chromsize: %s %d\n", names[i].c_str(), contig_length);
+    }
+    fprintf(pairs_file, "#columns: readID chrom1 pos1 chrom2 pos2 strand1 strand2 pair_type\n");
+    bench_bam_write(bam_writer, "BAM\1", 4);
+    bench_bam_write_value<uint32_t>(bam_writer, static_cast<uint32_t>(header_text.size()));
+    bench_bam_write(bam_writer, header_text.data(), header_text.size());
+    bench_bam_write_value<uint32_t>(bam_writer, static_cast<uint32_t>(num_of_contigs));
+    for (int32_t i = 0; i < num_of_contigs; ++i)
+    {
+        bench_bam_write_value<uint32_t>(bam_writer, static_cast<uint32_t>(names[i].size() + 1));
+        bench_bam_write(bam_writer, names[i].c_str(), names[i].size() + 1);
+        bench_bam_write_value<uint32_t>(bam_writer, static_cast<uint32_t>(contigs[fasta_order[i]].length));
+    }
+    //Simulate the pairs, the contact probability decays as 1/distance.
+    time_print("Simulating %llu Hi-C read pair(s)...", static_cast<unsigned long long>(config.pairs));
+    const double log_span = log(static_cast<double>(length) / BENCH_MIN_DISTANCE);
+    char read_name[32];
+    for (uint64_t i = 0; i < config.pairs; ++i)
+    {
+        int32_t chromosome = static_cast<int32_t>(bench_rng_range(rng, config.chromosomes)), mate_chromosome = chromosome;
+        const std::vector<int32_t>& read_sites = sites[chromosome];
+        int32_t pos = bench_site_read(rng, read_sites, read_sites[bench_rng_range(rng, read_sites.size())], length), mate_target;
+        if (bench_rng_real(rng) < config.noise)
+        {
+            mate_chromosome = static_cast<int32_t>(bench_rng_range(rng, config.chromosomes));
+            mate_target = static_cast<int32_t>(bench_rng_range(rng, length));
+        }
+        else
+        {
+            int64_t distance = static_cast<int64_t>(BENCH_MIN_DISTANCE * exp(log_span * bench_rng_real(rng)));
+            int64_t target = bench_rng_range(rng, 2) ? pos + distance : pos - distance;
+            //Reflect the mate back into the chromosome.
+            if (target < 0 || target >= length)
+            {
+                target = 2 * static_cast<int64_t>(pos) - target;
+            }
+            mate_target = (target < 0 || target >= length) ? static_cast<int32_t>(bench_rng_range(rng, length)) : static_cast<int32_t>(target);
+        }
+        int32_t mate_pos = bench_site_read(rng, sites[mate_chromosome], mate_target, length);
+        BENCH_READ read = bench_read_locate(contigs, first_contigs, chromosome, pos),
+            mate = bench_read_locate(contigs, first_contigs, mate_chromosome, mate_pos);
+        //The first read is on the forward strand of the chromosome, the mate is on the reverse strand.
+        bool read_reverse = read.contig->reversed != 0, mate_reverse = mate.contig->reversed == 0;
+        snprintf(read_name, sizeof(read_name), "r%llu", static_cast<unsigned long long>(i));
+        bench_bam_record(bam_writer, genome, read_name, read, mate, static_cast<uint16_t>(0x41 | (read_reverse ? 0x10 : 0) | (mate_reverse ? 0x20 : 0)));
+        bench_bam_record(bam_writer, genome, read_name, mate, read, static_cast<uint16_t>(0x81 | (mate_reverse ? 0x10 : 0) | (read_reverse ? 0x20 : 0)));
+        //The pairs positions are the 5' ends, 1-based.
+        fprintf(pairs_file, "%s\t%s\t%d\t%s\t%d\t%c\t%c\tUU\n", read_name,
+            names[read.contig->id].c_str(), read_reverse ? read.pos + BENCH_READ_LENGTH : read.pos + 1,
+            names[mate.contig->id].c_str(), mate_reverse ? mate.pos + BENCH_READ_LENGTH : mate.pos + 1,
+            read_reverse ? '-' : '+', mate_reverse ? '-' : '+');
+    }
+    if (!bam_writer.data.empty())
+    {
+        bench_bam_flush(bam_writer, bam_writer.data.size());
+    }
+    hmr_bgzf_write_eof(bam_writer.bam_file);
+    fclose(bam_writer.bam_file);
+    fclose(pairs_file);
+    time_print("Hi-C reads saved to %s and %s", bam_path.c_str(), pairs_path.c_str());
+}
+
+void bench_truth_load(const char* filepath, BENCH_TRUTH& truth)
+{
+    TEXT_LINE_HANDLE line_handle;
+    if (!text_open_read_line(filepath, &line_handle))
+    {
+        time_error(-1, "Failed to read truth file %s", filepath);
+    }
+    char* line = NULL;
+    size_t len = 0;
+    ssize_t line_size;
+    truth.clear();
+    while ((line_size = line_handle.parser(&line, &len, &line_handle.buf, line_handle.file_handle)) != -1)
+    {
+        if (line_size < 1 || line[0] == '#')
+        {
+            continue;
+        }
+        BENCH_CONTIG contig;
+        char* field = line;
+        contig.id = static_cast<int32_t>(strtol(field, &field, 10));
+        contig.chromosome = static_cast<int32_t>(strtol(field, &field, 10));
+        contig.start = static_cast<int32_t>(strtol(field, &field, 10));
+        contig.length = static_cast<int32_t>(strtol(field, &field, 10));
+        contig.reversed = static_cast<int32_t>(strtol(field, &field, 10));
+        truth.push_back(contig);
+    }
+    text_close_read_line(&line_handle);
+}
@@ -0,0 +1,67 @@
+#ifndef BENCH_GEN_H
+#define BENCH_GEN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Splitmix64 generator, the synthetic data is the same for the same seed on all the platforms */
+typedef struct BENCH_RNG
+{
+    uint64_t state;
+} BENCH_RNG;
+
+inline uint64_t bench_rng_next(BENCH_RNG& rng)
+{
+    uint64_t z = (rng.state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+inline uint64_t bench_rng_range(BENCH_RNG& rng, uint64_t range)
+{
+    return bench_rng_next(rng) % range;
+}
+
+inline double bench_rng_real(BENCH_RNG& rng)
+{
+    return static_cast<double>(bench_rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+typedef struct BENCH_GEN_CONFIG
+{
+    uint64_t seed;
+    int32_t chromosomes;
+    int32_t chromosome_length;
+    int32_t contig_min, contig_max;
+    int32_t site_gap; // Average distance between the planted enzyme sites.
+    const char* enzyme;
+    uint64_t pairs;
+    double noise; // Ratio of the pairs placed at random sites of the genome.
+} BENCH_GEN_CONFIG;
+
+/* Contig of the synthetic genome, the id is the index of the contig in the FASTA */
+typedef struct BENCH_CONTIG
+{
+    int32_t id;
+    int32_t chromosome;
+    int32_t start;
+    int32_t length;
+    int32_t reversed; // The contig is the reverse complement of the chromosome range.
+} BENCH_CONTIG;
+
+/* Contigs in the chromosome order */
+typedef std::vector<BENCH_CONTIG> BENCH_TRUTH;
+
+/* Synthetic data paths */
+std::string bench_path_fasta(const char* prefix);
+std::string bench_path_bam(const char* prefix);
+std::string bench_path_pairs(const char* prefix);
+std::string bench_path_truth(const char* prefix);
+
+/* Generate the genome FASTA, the Hi-C reads as BAM and pairs, and the truth layout of the contigs */
+void bench_generate(const char* prefix, const BENCH_GEN_CONFIG& config);
+void bench_truth_load(const char* filepath, BENCH_TRUTH& truth);
+
+#endif // BENCH_GEN_H
@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "hmr_algorithm.hpp"
+#include "hmr_bam.hpp"
+#include "hmr_bgzf.hpp"
+#include "hmr_contig_graph.hpp"
+#include "hmr_enzyme.hpp"
+#include "hmr_fasta.hpp"
+#include "hmr_global.hpp"
+#include "hmr_stats.hpp"
+#include "hmr_task_scheduler.hpp"
+#include "hmr_ui.hpp"
+
+#include "extract_fasta.hpp"
+#include "extract_mapping.hpp"
+#include "draft_stream.hpp"
+#include "partition.hpp"
+#include "ordering_ea.hpp"
+#include "ordering_links.hpp"
+#include "ordering_loader.hpp"
+#include "orientation.hpp"
+
+#include "bench_gen.hpp"
+#include "bench_stage.hpp"
+
+//The same defaults as the pipeline programs.
+constexpr int32_t BENCH_ENZYME_RANGE = 500;
+constexpr int32_t BENCH_FASTA_POOL = 32;
+constexpr int32_t BENCH_READ_BUFFER = 512 << 10;
+constexpr uint8_t BENCH_MAPQ = 40;
+constexpr int32_t BENCH_MIN_LINKS = 3;
+constexpr int32_t BENCH_NPOP = 100;
+constexpr double BENCH_MUTAPB = 0.2;
+constexpr uint64_t BENCH_EA_SEED = 806;
+
+typedef struct BENCH_RESULT
+{
+    const char* stage;
+    const char* unit;
+    uint64_t items;
+    double seconds;
+    double scale; // Items per unit.
+    const char* quality_name; // NULL when the stage has no quality measurement.
+    double quality;
+} BENCH_RESULT;
+
+typedef struct BENCH_CONTEXT
+{
+    explicit BENCH_CONTEXT(const BENCH_RUN_CONFIG& run_config) :
+        config(run_config),
+        num_of_chromosomes(0)
+    {
+    }
+
+    const BENCH_RUN_CONFIG& config;
+    BENCH_TRUTH truth;
+    std::vector<int32_t> contig_chromosomes; // Contig id to its chromosome.
+    int32_t num_of_chromosomes;
+    HMR_NODES nodes;
+    std::vector<HMR_MAPPING> mappings;
+    std::string edge_path;
+    std::vector<BENCH_RESULT> results;
+} BENCH_CONTEXT;
+
+typedef struct BENCH_BAM_USER
+{
+    std::vector<HMR_MAPPING>& mappings;
+    uint64_t records;
+} BENCH_BAM_USER;
+
+void bench_record(BENCH_CONTEXT& context, BENCH_RESULT result)
+{
+    std::string stats_name = std::string("bench.") + result.stage;
+    hmr_stats_stage_time(stats_name.c_str(), result.seconds);
+    hmr_stats_count((stats_name + ".items").c_str(), result.items);
+    double throughput = result.seconds > 0.0 ? static_cast<double>(result.items) / result.scale / result.seconds : 0.0;
+    if (result.quality_name)
+    {
+        time_print("[%s] %llu item(s) in %.3lf second(s), %.2lf %s, %s %.4lf", result.stage, static_cast<unsigned long long>(result.items),
+            result.seconds, throughput, result.unit, result.quality_name, result.quality);
+    }
+    else
+    {
+        time_print("[%s] %llu item(s) in %.3lf second(s), %.2lf %s", result.stage, static_cast<unsigned long long>(result.items),
+            result.seconds, throughput, result.unit);
+    }
+    context.results.push_back(result);
+}
+
+void bench_bgzf(BENCH_CONTEXT& context)
+{
+    //Decompress the BAM without parsing the records.
+    std::string bam_path = bench_path_bam(context.config.prefix);
+    double start = hmr_stats_now();
+    HMR_BGZF_HANDLER* bgzf_handler = hmr_bgzf_open(bam_path.c_str(), context.config.threads);
+    uint64_t bytes = 0;
+    while (true)
+    {
+        HMR_BIN_SLICE slice = hmr_bin_queue_pop(bgzf_handler->queue);
+        if (!slice.data)
+        {
+            break;
+        }
+        bytes += slice.data_size;
+        hmr_bin_queue_release(bgzf_handler->queue, slice);
+    }
+    hmr_bgzf_close(bgzf_handler);
+    bench_record(context, BENCH_RESULT{ "bgzf", "MB/s", bytes, hmr_stats_now() - start, 1048576.0, NULL, 0.0 });
+}
+
+void bench_bam_n_contig(uint32_t, void*)
+{
+}
+
+void bench_bam_contig(uint32_t, char*, uint32_t, void*)
+{
+}
+
+void bench_bam_align(size_t, const BAM_BLOCK_HEADER* bam_block, void* user)
+{
+    BENCH_BAM_USER* bam_user = static_cast<BENCH_BAM_USER*>(user);
+    ++bam_user->records;
+    //The filter of the extract, except the enzyme range check.
+    if (!extract_bam_mapping_valid(bam_block->refID, bam_block->next_refID, bam_block->mapq, bam_block->flag, BENCH_MAPQ, CHECK_FLAG_FLAG))
+    {
+        return;
+    }
+    bam_user->mappings.push_back(HMR_MAPPING{ bam_block->refID, bam_block->pos, bam_block->next_refID, bam_block->next_pos });
+}
+
+void bench_bam(BENCH_CONTEXT& context)
+{
+    std::string bam_path = bench_path_bam(context.config.prefix);
+    BENCH_BAM_USER bam_user{ context.mappings, 0 };
+    double start = hmr_stats_now();
+    hmr_bam_read(bam_path.c_str(), BAM_MAPPING_PROC{ bench_bam_n_contig, bench_bam_contig, bench_bam_align }, &bam_user, context.config.threads);
+    bench_record(context, BENCH_RESULT{ "bam", "M records/s", bam_user.records, hmr_stats_now() - start, 1e6, NULL, 0.0 });
+    time_print("%zu inter-contig mapping(s) collected.", context.mappings.size());
+}
+
+void bench_enzyme(BENCH_CONTEXT& context)
+{
+    std::vector<char*> enzyme_names(1, const_cast<char*>(context.config.enzyme));
+    ENZYME_VEC enzymes = hmr_enzyme_formalize(enzyme_names);
+    CANDIDATE_ENZYMES search_range, search_calc;
+    extract_enzyme_search_start(enzymes, search_range);
+    CONTIG_CHAIN node_chain;
+    CONTIG_NAME_CHAIN node_name_chain;
+    CONTIG_RANGE_RESULTS node_ranges;
+    std::string fasta_path = bench_path_fasta(context.config.prefix);
+    double start = hmr_stats_now();
+    {
+        hmr::task_scheduler scheduler(context.config.threads);
+        hmr::task_group search_group(scheduler);
+        EXTRACT_FASTA_USER node_build_user{ search_range, search_calc, node_chain, node_name_chain, search_group, static_cast<int64_t>(context.config.threads) * BENCH_FASTA_POOL, BENCH_ENZYME_RANGE, node_ranges };
+        hmr_fasta_read(fasta_path.c_str(), extract_fasta_search_proc, &node_build_user);
+        search_group.wait();
+    }
+    double seconds = hmr_stats_now() - start;
+    extract_enzyme_search_end(search_range);
+    hDequeListToVector(node_chain, context.nodes);
+    for (const CONTIG_RANGE_RESULT& node_range : node_ranges)
+    {
+        context.nodes[node_range.contig_index].enzyme_count = node_range.counter + 1;
+    }
+    for (HMR_NODE_NAME& node_name : node_name_chain)
+    {
+        free(node_name.name);
+    }
+    uint64_t bases = 0;
+    for (const HMR_NODE& node : context.nodes)
+    {
+        bases += static_cast<uint64_t>(node.length);
+    }
+    if (context.nodes.size() != context.truth.size())
+    {
+        time_error(-1, "%zu contig(s) found in FASTA, while %zu contig(s) in the truth layout.", context.nodes.size(), context.truth.size());
+    }
+    bench_record(context, BENCH_RESULT{ "enzyme", "Mbp/s", bases, seconds, 1e6, NULL, 0.0 });
+}
+
+void bench_draft(BENCH_CONTEXT& context)
+{
+    int32_t num_of_contigs = static_cast<int32_t>(context.nodes.size()), max_enzyme_count = 0;
+    for (const HMR_NODE& node : context.nodes)
+    {
+        max_enzyme_count = hMax(max_enzyme_count, node.enzyme_count);
+    }
+    context.edge_path = hmr_graph_path_edge((std::string(context.config.prefix) + ".bench").c_str());
+    double start = hmr_stats_now();
+    //Sort the mappings to edge runs, in the buffer size of the reads loader.
+    DRAFT_EDGE_SORTER sorter;
+    draft_stream_init(sorter, context.edge_path.c_str(), (static_cast<size_t>(1024) << 20) / (sizeof(uint64_t) * 2 + sizeof(DRAFT_EDGE_COUNT)));
+    for (size_t offset = 0; offset < context.mappings.size(); offset += BENCH_READ_BUFFER)
+    {
+        size_t buf_size = hMin(context.mappings.size() - offset, static_cast<size_t>(BENCH_READ_BUFFER));
+        draft_stream_sort_proc(context.mappings.data() + offset, static_cast<int32_t>(buf_size), &sorter);
+    }
+    //Weight the edges, then adjust them by the node factors.
+    std::vector<double> node_factors(num_of_contigs, 0.0);
+    std::string weight_path = context.edge_path + ".tmp";
+    DRAFT_EDGE_WEIGHTS weights;
+    weights.nodes = &context.nodes;
+    weights.min_links = BENCH_MIN_LINKS;
+    weights.max_re_square = hSquare(static_cast<int64_t>(max_enzyme_count));
+    weights.node_factors = node_factors.data();
+    weights.links_average = 0.0;
+    weights.edge_size = 0;
+    hmr_graph_undirected_edges_open(weight_path.c_str(), &weights.edge_file);
+    draft_stream_merge(sorter, draft_stream_weight_proc, &weights);
+    draft_stream_weight_flush(weights);
+    hmr_graph_undirected_edges_close(weights.edge_file, weights.edge_size);
+    double links_average = 2.0 * weights.links_average / static_cast<double>(num_of_contigs);
+    for (double& factor : node_factors)
+    {
+        factor /= links_average;
+    }
+    hmr_graph_undirected_edges_open(context.edge_path.c_str(), &weights.edge_file);
+    weights.edge_size = 0;
+    hmr_graph_load_undirected_edges(weight_path.c_str(), BENCH_READ_BUFFER, draft_stream_edge_size_proc, draft_stream_adjust_proc, &weights);
+    hmr_graph_undirected_edges_close(weights.edge_file, weights.edge_size);
+    remove(weight_path.c_str());
+    double seconds = hmr_stats_now() - start;
+    time_print("%zu undirected edge(s) generated.", static_cast<size_t>(weights.edge_size));
+    bench_record(context, BENCH_RESULT{ "draft", "M mappings/s", context.mappings.size(), seconds, 1e6, NULL, 0.0 });
+}
+
+void bench_partition(BENCH_CONTEXT& context)
+{
+    HMR_CONTIG_ID_VEC invalid_nodes;
+    CLUSTER_INFO partition_info;
+    partition_init_clusters(context.nodes, invalid_nodes, partition_info);
+    double start = hmr_stats_now();
+    hmr_graph_load_undirected_edges(context.edge_path.c_str(), BENCH_READ_BUFFER, partition_undirected_edge_size_proc, partition_undirected_edge_proc, &partition_info);
+    CLUSTER_DENDROGRAM dendrogram;
+    dendrogram.min_groups = context.num_of_chromosomes;
+    dendrogram.max_groups = context.num_of_chromosomes;
+    partition_dendrogram_init(partition_info, dendrogram);
+    partition_cluster(partition_info, dendrogram, NULL, NULL);
+    double seconds = hmr_stats_now() - start;
+    //Cut the dendrogram at the chromosome number, check the clusters against the truth.
+    for (size_t i = 0; i < partition_info.cluster_size; ++i)
+    {
+        delete partition_info.clusters[i];
+    }
+    partition_info.cluster_size = 0;
+    std::vector<HMR_CONTIG_ID_VEC*> clusters;
+    partition_dendrogram_cut(dendrogram, context.num_of_chromosomes, partition_info, clusters);
+    size_t clustered = 0, majority = 0;
+    for (HMR_CONTIG_ID_VEC* cluster : clusters)
+    {
+        std::vector<size_t> chromosome_counts(context.num_of_chromosomes, 0);
+        for (int32_t contig_id : *cluster)
+        {
+            ++chromosome_counts[context.contig_chromosomes[contig_id]];
+        }
+        clustered += cluster->size();
+        majority += *std::max_element(chromosome_counts.begin(), chromosome_counts.end());
+        delete cluster;
+    }
+    partition_free_clusters(partition_info);
+    bench_record(context, BENCH_RESULT{ "partition", "K merges/s", dendrogram.steps.size(), seconds, 1e3,
+        "purity", clustered ? static_cast<double>(majority) / static_cast<double>(clustered) : 0.0 });
+}
+
+void bench_ordering(BENCH_CONTEXT& context)
+{
+    //Order the chromosome with the most contigs.
+    std::vector<HMR_CONTIG_ID_VEC> chromosome_ids(context.num_of_chromosomes);
+    for (const BENCH_CONTIG& contig : context.truth)
+    {
+        chromosome_ids[contig.chromosome].push_back(contig.id);
+    }
+    int32_t target = 0;
+    for (int32_t i = 1; i < context.num_of_chromosomes; ++i)
+    {
+        if (chromosome_ids[i].size() > chromosome_ids[target].size())
+        {
+            target = i;
+        }
+    }
+    const HMR_CONTIG_ID_VEC& truth_order = chromosome_ids[target];
+    ORDERING_INFO info;
+    info.contig_ids = truth_order;
+    std::sort(info.contig_ids.begin(), info.contig_ids.end());
+    info.contig_size = static_cast<int32_t>(info.contig_ids.size());
+    HMR_CONTIG_ID_VEC group_ids(context.nodes.size(), -1), local_ids(context.nodes.size(), -1);
+    for (int32_t i = 0; i < info.contig_size; ++i)
+    {
+        group_ids[info.contig_ids[i]] = 0;
+        local_ids[info.contig_ids[i]] = i;
+    }
+    std::vector<std::vector<ORDERING_LINK> > group_edges(1);
+    ORDERING_EDGE_LOADER loader{ group_ids, local_ids, group_edges };
+    hmr_graph_load_undirected_edges(context.edge_path.c_str(), BENCH_READ_BUFFER, ordering_edge_map_size_proc, ordering_undirected_edge_map_data_proc, &loader);
+    ordering_links_init(info.edges, info.contig_size, group_edges[0]);
+    //Start from a shuffled order, the idle limit equals the generations so the count is fixed.
+    HMR_CONTIG_ID_VEC contig_group = info.contig_ids;
+    std::mt19937_64 rng(BENCH_EA_SEED);
+    std::shuffle(contig_group.begin(), contig_group.end(), rng);
+    info.init_genome = static_cast<ORDERING_TIG*>(malloc(sizeof(ORDERING_TIG) * info.contig_size));
+    if (!info.init_genome)
+    {
+        time_error(-1, "Failed to allocate memory for initial order sequence.");
+    }
+    ordering_ea_init(contig_group, context.nodes, info);
+    double start = hmr_stats_now();
+    contig_group = ordering_ea_optimize(1, BENCH_NPOP, context.config.ngen, static_cast<uint64_t>(context.config.ngen), BENCH_MUTAPB, info, rng, context.config.threads, 0);
+    double seconds = hmr_stats_now() - start;
+    free(info.init_genome);
+    //Count the truth neighbours which are still next to each other.
+    std::vector<int32_t> positions(context.nodes.size(), -1);
+    for (size_t i = 0; i < contig_group.size(); ++i)
+    {
+        positions[contig_group[i]] = static_cast<int32_t>(i);
+    }
+    size_t adjacent = 0;
+    for (size_t i = 1; i < truth_order.size(); ++i)
+    {
+        adjacent += abs(positions[truth_order[i]] - positions[truth_order[i - 1]]) == 1;
+    }
+    time_print("Ordered %d contig(s) of chromosome %d.", info.contig_size, target + 1);
+    bench_record(context, BENCH_RESULT{ "ordering", "generations/s", static_cast<uint64_t>(context.config.ngen), seconds, 1.0,
+        "adjacency", truth_order.size() > 1 ? static_cast<double>(adjacent) / static_cast<double>(truth_order.size() - 1) : 0.0 });
+}
+
+void bench_orientation(BENCH_CONTEXT& context)
+{
+    //The sequences are in the truth order, only the directions are measured.
+    std::vector<HMR_CONTIG_ID_VEC> chromosome_ids(context.num_of_chromosomes);
+    std::vector<int32_t> reversed(context.nodes.size(), 0);
+    for (const BENCH_CONTIG& contig : context.truth)
+    {
+        chromosome_ids[contig.chromosome].push_back(contig.id);
+        reversed[contig.id] = contig.reversed;
+    }
+    std::vector<std::string> seq_path_names;
+    std::vector<char*> seq_paths;
+    for (int32_t i = 0; i < context.num_of_chromosomes; ++i)
+    {
+        seq_path_names.push_back(std::string(context.config.prefix) + ".bench_" + std::to_string(i + 1) + ".hmr_seq");
+        hmr_graph_save_contig_ids(seq_path_names.back().c_str(), chromosome_ids[i]);
+    }
+    for (std::string& seq_path : seq_path_names)
+    {
+        seq_paths.push_back(&seq_path[0]);
+    }
+    ORIENTATION_INFO info;
+    orientation_init(seq_paths, context.nodes, context.config.threads, false, info);
+    double start = hmr_stats_now();
+    for (size_t offset = 0; offset < context.mappings.size(); offset += BENCH_READ_BUFFER)
+    {
+        size_t buf_size = hMin(context.mappings.size() - offset, static_cast<size_t>(BENCH_READ_BUFFER));
+        orientation_calc_gradient(context.mappings.data() + offset, static_cast<int32_t>(buf_size), &info);
+    }
+    orientation_reduce(info);
+    size_t matched = 0, total = 0;
+    for (const ORIENTATION_SEQUENCE& sequence : info.sequences)
+    {
+        CHROMOSOME_CONTIGS chromosome = orientation_extract(sequence);
+        for (const HMR_DIRECTED_CONTIG& contig : chromosome)
+        {
+            matched += (contig.direction == DIRECTION_NEGATIVE) == (reversed[contig.id] != 0);
+            ++total;
+        }
+    }
+    double seconds = hmr_stats_now() - start;
+    for (const std::string& seq_path : seq_path_names)
+    {
+        remove(seq_path.c_str());
+    }
+    bench_record(context, BENCH_RESULT{ "orientation", "M mappings/s", context.mappings.size(), seconds, 1e6,
+        "direction", total ? static_cast<double>(matched) / static_cast<double>(total) : 0.0 });
+}
+
+void bench_run(const BENCH_RUN_CONFIG& config)
+{
+    BENCH_CONTEXT context(config);
+    std::string truth_path = bench_path_truth(config.prefix);
+    time_print("Loading contig layout from %s", truth_path.c_str());
+    bench_truth_load(truth_path.c_str(), context.truth);
+    context.contig_chromosomes.resize(context.truth.size(), 0);
+    for (const BENCH_CONTIG& contig : context.truth)
+    {
+        context.contig_chromosomes[contig.id] = contig.chromosome;
+        context.num_of_chromosomes = hMax(context.num_of_chromosomes, contig.chromosome + 1);
+    }
+    time_print("%zu contig(s) in %d chromosome(s) loaded.", context.truth.size(), context.num_of_chromosomes);
+    bench_bgzf(context);
+    bench_bam(context);
+    bench_enzyme(context);
+    bench_draft(context);
+    bench_partition(context);
+    bench_ordering(context);
+    bench_orientation(context);
+    remove(context.edge_path.c_str());
+    //Print the summary table, the throughput is comparable across the commits on the same data.
+    printf("%-12s %14s %10s %14s  %-14s %s\n", "stage", "items", "seconds", "throughput", "unit", "quality");
+    for (const BENCH_RESULT& result : context.results)
+    {
+        double throughput = result.seconds > 0.0 ? static_cast<double>(result.items) / result.scale / result.seconds : 0.0;
+        printf("%-12s %14llu %10.3lf %14.2lf  %-14s", result.stage, static_cast<unsigned long long>(result.items), result.seconds, throughput, result.unit);
+        if (result.quality_name)
+        {
+            printf(" %s=%.4lf", result.quality_name, result.quality);
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+}
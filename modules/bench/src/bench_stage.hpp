@@ -0,0 +1,17 @@
+#ifndef BENCH_STAGE_H
+#define BENCH_STAGE_H
+
+#include <cstdint>
+
+typedef struct BENCH_RUN_CONFIG
+{
+    const char* prefix;
+    const char* enzyme; // Enzyme planted by the generator.
+    int32_t threads;
+    int32_t ngen; // Fixed generations of the evaluation algorithm.
+} BENCH_RUN_CONFIG;
+
+/* Run the stage microbenchmarks on the synthetic data, the throughput of each stage is printed as a table */
+void bench_run(const BENCH_RUN_CONFIG& config);
+
+#endif // BENCH_STAGE_H
@@ -0,0 +1,92 @@
+#include <unordered_map>
+
+#include "hmr_args.hpp"
+#include "hmr_stats.hpp"
+#include "hmr_ui.hpp"
+
+#include "args_bench.hpp"
+#include "bench_gen.hpp"
+#include "bench_stage.hpp"
+
+typedef int (*BENCH_PROC)(int, char* []);
+
+extern HMR_ARGS opts;
+
+int bench_proc_gen(int argc, char* argv[])
+{
+    parse_arguments(argc, argv);
+    if (opts.stats) { hmr_stats_enable("hana_bench_gen", opts.stats); }
+    if (!opts.output) { help_exit(-1, "Missing synthetic data file prefix."); }
+    if (opts.chromosomes < 1) { time_error(-1, "Invalid number of chromosomes %d.", opts.chromosomes); }
+    if (opts.pairs < 1) { time_error(-1, "Invalid number of read pairs %dK.", opts.pairs); }
+    if (opts.site_gap < 1) { time_error(-1, "Invalid enzyme site gap %d.", opts.site_gap); }
+    if (opts.noise < 0.0 || opts.noise > 1.0) { time_error(-1, "Invalid noise ratio %.2lf.", opts.noise); }
+    time_print("Execution configuration:");
+    time_print("\tRandom seed: %llu", static_cast<unsigned long long>(opts.seed));
+    time_print("\tChromosomes: %d x %dK", opts.chromosomes, opts.chromosome_length);
+    time_print("\tContig length: %dK-%dK", opts.contig_min, opts.contig_max);
+    time_print("\tEnzyme: %s, every %d bp on average", opts.enzyme, opts.site_gap);
+    time_print("\tRead pairs: %dK, noise %.2lf", opts.pairs, opts.noise);
+    BENCH_GEN_CONFIG config;
+    config.seed = opts.seed;
+    config.chromosomes = opts.chromosomes;
+    config.chromosome_length = opts.chromosome_length * 1000;
+    config.contig_min = opts.contig_min * 1000;
+    config.contig_max = opts.contig_max * 1000;
+    config.site_gap = opts.site_gap;
+    config.enzyme = opts.enzyme;
+    config.pairs = static_cast<uint64_t>(opts.pairs) * 1000;
+    config.noise = opts.noise;
+    bench_generate(opts.output, config);
+    time_print("Generate complete.");
+    return 0;
+}
+
+int bench_proc_run(int argc, char* argv[])
+{
+    parse_arguments(argc, argv);
+    if (opts.stats) { hmr_stats_enable("hana_bench_run", opts.stats); }
+    if (!opts.output) { help_exit(-1, "Missing synthetic data file prefix."); }
+    if (opts.ngen < 1) { time_error(-1, "Invalid number of generations %d.", opts.ngen); }
+    time_print("Execution configuration:");
+    time_print("\tSynthetic data: %s", opts.output);
+    time_print("\tEnzyme: %s", opts.enzyme);
+    time_print("\tThreads: %d", opts.threads);
+    time_print("\tEvaluation algorithm generations: %d", opts.ngen);
+    bench_run(BENCH_RUN_CONFIG{ opts.output, opts.enzyme, opts.threads, opts.ngen });
+    time_print("Benchmark complete.");
+    return 0;
+}
+
+std::unordered_map<std::string, BENCH_PROC> bench_proc_map = {
+    {"gen", bench_proc_gen},
+    {"run", bench_proc_run},
+};
+
+void help_exit()
+{
+    printf("usage: op [param]\n");
+    printf("Supported operations:\n");
+    for (const auto& iter : bench_proc_map)
+    {
+        printf("    %s\n", iter.first.c_str());
+    }
+    exit(-1);
+}
+
+int main(int argc, char* argv[])
+{
+    //Check the operations.
+    if (argc < 2)
+    {
+        help_exit();
+    }
+    std::string op = argv[1];
+    const auto iter = bench_proc_map.find(op);
+    if (iter == bench_proc_map.end())
+    {
+        printf("Unknown operation '%s'\n", op.c_str());
+        help_exit();
+    }
+    return iter->second(argc - 1, argv + 1);
+}
@@ -11,6 +11,7 @@ INCLUDEPATH = ../shared
 
 SOURCES += \
     ../shared/hmr_args.cpp \
+    ../shared/hmr_bgzf.cpp \
     ../shared/hmr_bin_file.cpp \
     ../shared/hmr_bin_queue.cpp \
     ../shared/hmr_contig_graph.cpp \
@@ -18,13 +19,17 @@ SOURCES += \
     ../shared/hmr_gz.cpp \
     ../shared/hmr_path.cpp \
     ../shared/hmr_seq.cpp \
+    ../shared/hmr_stats.cpp \
     ../shared/hmr_text_file.cpp \
     ../shared/hmr_ui.cpp \
     src/args_build.cpp \
+    src/build_chromosome.cpp \
+    src/build_writer.cpp \
     src/main.cpp
 
 HEADERS += \
     ../shared/hmr_args.hpp \
+    ../shared/hmr_bgzf.hpp \
     ../shared/hmr_args_types.hpp \
     ../shared/hmr_bin_file.hpp \
     ../shared/hmr_bin_queue.hpp \
@@ -34,6 +39,10 @@ HEADERS += \
     ../shared/hmr_gz.hpp \
     ../shared/hmr_path.hpp \
     ../shared/hmr_seq.hpp \
+    ../shared/hmr_stats.hpp \
+    ../shared/hmr_task_scheduler.hpp \
     ../shared/hmr_text_file.hpp \
     ../shared/hmr_ui.hpp \
-    src/args_build.hpp
+    src/args_build.hpp \
+    src/build_chromosome.hpp \
+    src/build_writer.hpp
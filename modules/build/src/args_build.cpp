@@ -10,4 +10,15 @@ HMR_ARG_PARSER args_parser = {
     { {"-f", "--fasta"}, "FASTA", "Contig FASTA file (.fasta/.fasta.gz)", LAMBDA_PARSE_ARG {opts.fasta = arg[0]; }},
     { {"-c", "--chromosome"}, "CHROMO 1, CHROMO 2...", "Hi-C reads mapping files (.bam/.hmr_mapping)", LAMBDA_PARSE_ARG { opts.chromosomes = arg; }},
     { {"-o", "--output"}, "OUTPUT", "Output build file prefix", LAMBDA_PARSE_ARG {opts.output = arg[0]; }},
+    { {"-t", "--threads"}, "THREADS", "Number of threads building the chromosomes (default: 1)", LAMBDA_PARSE_ARG { opts.threads = atoi(arg[0]); }},
+    { {"--bgzip"}, "", "Write the BGZF compressed FASTA with its .fai and .gzi index", LAMBDA_PARSE_ARG { (void)arg; opts.bgzip = true; }},
+    { {"--complete"}, "", "Complete build, write the unplaced contigs as scaffolds and fill the gaps with N", LAMBDA_PARSE_ARG { (void)arg; opts.complete = true; }},
+    { {"--gap-length"}, "GAP_LENGTH", "Length of the gaps between the contigs, 100 is an unknown gap (default: 100)", LAMBDA_PARSE_ARG { opts.gap_length = atoi(arg[0]); }},
+    { {"--gap-type"}, "GAP_TYPE", "AGP gap type (default: contig)", LAMBDA_PARSE_ARG { opts.gap_type = arg[0]; }},
+    { {"--gap-evidence"}, "GAP_EVIDENCE", "AGP linkage evidence, na for no linkage (default: map)", LAMBDA_PARSE_ARG { opts.gap_evidence = arg[0]; }},
+    { {"--stream"}, "", "Stream the contigs from the uncompressed FASTA by its index instead of loading the whole FASTA", LAMBDA_PARSE_ARG { (void)arg; opts.stream = true; }},
+    { {"-i", "--index"}, "INDEX", "FASTA index file for streaming (default: FASTA.fai, built when missing)", LAMBDA_PARSE_ARG {opts.index = arg[0]; }},
+    { {"-w", "--line-width"}, "LINE_WIDTH", "Output FASTA line width, 0 for a single line (default: 0)", LAMBDA_PARSE_ARG {opts.line_width = atoi(arg[0]); }},
+    { {"--write-buffer"}, "WRITE_BUFFER", "Output FASTA write buffer size (unit: M, default: 16)", LAMBDA_PARSE_ARG {opts.write_buffer = atoi(arg[0]); }},
+    { {"--stats"}, "STATS", "Save the stage timings, counters and peak memory as JSON", LAMBDA_PARSE_ARG {opts.stats = arg[0]; }},
 };
@@ -9,6 +9,12 @@ typedef struct HMR_ARGS
     const char* fasta = NULL;
     std::vector<char*> chromosomes;
     const char* output = NULL;
+    const char* index = NULL;
+    const char* stats = NULL;
+    const char* gap_type = "contig";
+    const char* gap_evidence = "map";
+    bool stream = false, bgzip = false, complete = false;
+    int threads = 1, line_width = 0, write_buffer = 16, gap_length = 100;
 } HMR_ARGS;
 
 #endif // ARGS_BUILD_H
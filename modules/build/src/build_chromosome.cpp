@@ -0,0 +1,264 @@
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include "hmr_bin_file.hpp"
+#include "hmr_global.hpp"
+#include "hmr_path.hpp"
+#include "hmr_task_scheduler.hpp"
+#include "hmr_text_file.hpp"
+#include "hmr_ui.hpp"
+
+#include "build_chromosome.hpp"
+
+//Number of bases read from the FASTA at once in the streaming mode.
+constexpr uint64_t BUILD_STREAM_BASES = 4 << 20;
+
+typedef std::deque<CONTIG_SEQ> CONTIG_DICT_LIST;
+
+typedef struct BUILD_STREAM
+{
+    FILE* fasta_file;
+    std::vector<char> buffer;
+} BUILD_STREAM;
+
+void build_fasta_loader(int32_t seq_index, char *name, size_t name_len, char *seq_data, size_t seq_data_len, void *user)
+{
+    CONTIG_DICT_LIST *contigs = reinterpret_cast<CONTIG_DICT_LIST*>(user);
+    //Construct the contig building dictionary.
+    contigs->push_back(CONTIG_SEQ{ name, seq_data, name_len, seq_data_len });
+}
+
+void build_source_load(const char* fasta_path, bool stream, const char* index_path, BUILD_SOURCE& source)
+{
+    source.fasta_path = fasta_path;
+    source.stream = stream;
+    if (!stream)
+    {
+        //Load the FASTA and cache all the sequence.
+        CONTIG_DICT_LIST contig_list;
+        time_print("Constructing FASTA sequence index from %s", fasta_path);
+        hmr_fasta_read(fasta_path, build_fasta_loader, &contig_list);
+        hDequeListToVector(contig_list, source.contigs);
+        time_print("%zu sequences loaded.", contig_list.size());
+        return;
+    }
+    //Load the FASTA index, build it when it is missing.
+    if (path_ends_with(fasta_path, ".gz")) { time_error(-1, "Streaming mode needs an uncompressed FASTA file."); }
+    std::string fai_path = index_path ? std::string(index_path) : hmr_fasta_index_path(fasta_path);
+    if (path_can_read(fai_path.c_str()))
+    {
+        time_print("Loading FASTA index from %s", fai_path.c_str());
+        hmr_fasta_index_load(fai_path.c_str(), source.index);
+    }
+    else
+    {
+        time_print("Constructing FASTA index from %s", fasta_path);
+        hmr_fasta_index_build(fasta_path, source.index);
+        if (hmr_fasta_index_save(fai_path.c_str(), source.index))
+        {
+            time_print("FASTA index saved to %s", fai_path.c_str());
+        }
+    }
+    //Empty records are skipped as the FASTA loader does, the contig ids are the same.
+    HMR_FASTA_INDEX valid_index;
+    valid_index.reserve(source.index.size());
+    for (const auto& item : source.index)
+    {
+        if (item.length > 0)
+        {
+            valid_index.push_back(item);
+        }
+    }
+    source.index.swap(valid_index);
+    source.contigs.reserve(source.index.size());
+    for (const auto& item : source.index)
+    {
+        source.contigs.push_back(CONTIG_SEQ{ item.name.c_str(), NULL, item.name.size(), static_cast<size_t>(item.length) });
+    }
+    time_print("%zu sequences indexed.", source.index.size());
+}
+
+inline void build_fasta_seek(FILE* fasta_file, uint64_t offset)
+{
+#ifdef _MSC_VER
+    _fseeki64(fasta_file, static_cast<__int64>(offset), SEEK_SET);
+#else
+    fseeko64(fasta_file, static_cast<off64_t>(offset), SEEK_SET);
+#endif
+}
+
+void build_stream_contig(const HMR_DIRECTED_CONTIG& contig_info, const BUILD_SOURCE& source, BUILD_STREAM& stream, BUILD_WRITER& writer)
+{
+    const HMR_FASTA_INDEX_ITEM& item = source.index[contig_info.id];
+    std::vector<char>& buffer = stream.buffer;
+    //Read the bases by blocks, the reversed contig is read from the last block.
+    uint64_t block_count = (item.length + BUILD_STREAM_BASES - 1) / BUILD_STREAM_BASES;
+    for (uint64_t i = 0; i < block_count; ++i)
+    {
+        uint64_t block_id = contig_info.direction ? block_count - 1 - i : i,
+                 start = block_id * BUILD_STREAM_BASES,
+                 end = start + BUILD_STREAM_BASES < item.length ? start + BUILD_STREAM_BASES : item.length;
+        uint64_t file_start = hmr_fasta_index_offset(item, start),
+                 file_size = hmr_fasta_index_offset(item, end - 1) + 1 - file_start;
+        if (buffer.size() < file_size)
+        {
+            buffer.resize(file_size);
+        }
+        build_fasta_seek(stream.fasta_file, file_start);
+        if (fread(buffer.data(), 1, file_size, stream.fasta_file) != file_size)
+        {
+            time_error(-1, "Failed to read sequence %s from the FASTA file.", item.name.c_str());
+        }
+        //Remove the line breaks from the block.
+        size_t bases = 0;
+        for (size_t j = 0; j < file_size; ++j)
+        {
+            if (buffer[j] != '\n' && buffer[j] != '\r')
+            {
+                buffer[bases++] = buffer[j];
+            }
+        }
+        if (bases != end - start)
+        {
+            time_error(-1, "Sequence %s does not match the FASTA index, please rebuild the index.", item.name.c_str());
+        }
+        if (contig_info.direction)
+        {
+            build_writer_seq_reverse(writer, buffer.data(), bases);
+        }
+        else
+        {
+            build_writer_seq(writer, buffer.data(), bases);
+        }
+    }
+}
+
+void build_contig(const HMR_DIRECTED_CONTIG &contig_info, const BUILD_SOURCE& source, BUILD_STREAM& stream, BUILD_WRITER& writer)
+{
+    if (source.stream)
+    {
+        build_stream_contig(contig_info, source, stream, writer);
+        return;
+    }
+    //Extract the sequence from the directory.
+    const CONTIG_SEQ &contig = source.contigs[contig_info.id];
+    //Check the direction.
+    if(contig_info.direction)
+    {
+        //It is reversed.
+        build_writer_seq_reverse(writer, contig.seq, contig.seq_size);
+    }
+    else
+    {
+        //Just simply write the sequence.
+        build_writer_seq(writer, contig.seq, contig.seq_size);
+    }
+}
+
+void build_task_run(const BUILD_SOURCE& source, const BUILD_CONFIG& config, BUILD_TASK& task, FILE* output, FILE* agp_output, BUILD_STREAM& stream)
+{
+    BUILD_WRITER writer;
+    build_writer_init(writer, output, config.write_buffer, config.line_width, config.bgzf);
+    //Unknown gaps are 100 bp by the AGP specification, the other lengths are known gaps.
+    const char gap_component = config.gap_length == 100 ? 'U' : 'N';
+    const char* gap_linkage = strcmp(config.gap_evidence, "na") ? "yes" : "no";
+    for (BUILD_RECORD& record : task.records)
+    {
+        //Write the name of the record.
+        std::string title = ">" + record.name + "\n";
+        build_writer_text(writer, title.data(), title.size());
+        record.seq_offset = writer.raw_size + writer.used;
+        record.seq_size = 0;
+        //The AGP records are written along with the sequence, from the same offsets.
+        size_t offset = 1, part_counter = 1;
+        for (size_t i = 0; i < record.contigs.size(); ++i)
+        {
+            const HMR_DIRECTED_CONTIG& contig_info = record.contigs[i];
+            if (i > 0)
+            {
+                if (config.fill_gaps)
+                {
+                    build_writer_seq_fill(writer, 'N', config.gap_length);
+                    record.seq_size += config.gap_length;
+                }
+                fprintf(agp_output, "%s\t%zu\t%zu\t%zu\t%c\t%zu\t%s\t%s\t%s\n", record.name.c_str(), offset, offset + config.gap_length - 1, part_counter,
+                        gap_component, config.gap_length, config.gap_type, gap_linkage, config.gap_evidence);
+                offset += config.gap_length;
+                ++part_counter;
+            }
+            const CONTIG_SEQ& contig = source.contigs[contig_info.id];
+            build_contig(contig_info, source, stream, writer);
+            record.seq_size += contig.seq_size;
+            fprintf(agp_output, "%s\t%zu\t%zu\t%zu\tW\t%s\t1\t%zu\t%c\n", record.name.c_str(), offset, offset + contig.seq_size - 1, part_counter,
+                    contig.name, contig.seq_size, contig_info.direction ? '-' : '+');
+            offset += contig.seq_size;
+            ++part_counter;
+        }
+        build_writer_seq_end(writer);
+    }
+    build_writer_flush(writer);
+    task.raw_size = writer.raw_size;
+    task.file_size = writer.file_size;
+    task.blocks.swap(writer.blocks);
+    build_writer_free(writer);
+}
+
+void build_stream_open(const BUILD_SOURCE& source, BUILD_STREAM& stream)
+{
+    stream.fasta_file = NULL;
+    if (source.stream && !bin_open(source.fasta_path, &stream.fasta_file, "rb"))
+    {
+        time_error(-1, "Failed to read FASTA file %s", source.fasta_path);
+    }
+}
+
+void build_stream_close(BUILD_STREAM& stream)
+{
+    if (stream.fasta_file)
+    {
+        fclose(stream.fasta_file);
+    }
+}
+
+void build_task_worker(const BUILD_SOURCE& source, const BUILD_CONFIG& config, BUILD_TASK& task)
+{
+    //Each task has its own FASTA handle and temporary files.
+    BUILD_STREAM stream;
+    build_stream_open(source, stream);
+    FILE* task_file, * agp_file;
+    if (!bin_open(task.temp_path.c_str(), &task_file, "wb") || !bin_open(task.agp_temp_path.c_str(), &agp_file, "wb"))
+    {
+        time_error(-1, "Failed to create the temporary files of %s", task.temp_path.c_str());
+    }
+    //The writer flushes its own buffer, skip the stdio buffer before the first write.
+    setvbuf(task_file, NULL, _IONBF, 0);
+    build_task_run(source, config, task, task_file, agp_file, stream);
+    fclose(task_file);
+    fclose(agp_file);
+    build_stream_close(stream);
+}
+
+void build_tasks(const BUILD_SOURCE& source, const BUILD_CONFIG& config, std::vector<BUILD_TASK>& tasks, FILE* output, FILE* agp_output, int32_t threads)
+{
+    if (threads < 2)
+    {
+        BUILD_STREAM stream;
+        build_stream_open(source, stream);
+        for (BUILD_TASK& task : tasks)
+        {
+            build_task_run(source, config, task, output, agp_output, stream);
+        }
+        build_stream_close(stream);
+        return;
+    }
+    //The tasks are submitted in order, so the large chromosomes start first.
+    hmr::task_scheduler scheduler(threads);
+    hmr::task_group build_group(scheduler);
+    for (BUILD_TASK& task : tasks)
+    {
+        BUILD_TASK* task_ptr = &task;
+        build_group.run([&source, &config, task_ptr] { build_task_worker(source, config, *task_ptr); });
+    }
+    build_group.wait();
+}
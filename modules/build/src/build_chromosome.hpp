@@ -0,0 +1,63 @@
+#ifndef BUILD_CHROMOSOME_H
+#define BUILD_CHROMOSOME_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "hmr_contig_graph_type.hpp"
+#include "hmr_fasta.hpp"
+
+#include "build_writer.hpp"
+
+typedef struct CONTIG_SEQ
+{
+    const char* name;
+    char* seq;
+    size_t name_size, seq_size;
+} CONTIG_SEQ;
+
+typedef std::vector<CONTIG_SEQ> CONTIG_DICT;
+
+typedef struct BUILD_SOURCE
+{
+    const char* fasta_path;
+    CONTIG_DICT contigs;
+    //Streaming mode, the sequences are read from the FASTA by the index.
+    bool stream;
+    HMR_FASTA_INDEX index;
+} BUILD_SOURCE;
+
+typedef struct BUILD_CONFIG
+{
+    size_t write_buffer, line_width;
+    bool bgzf;
+    //Gaps between the contigs of a record, they are filled with N in the FASTA when required.
+    size_t gap_length;
+    const char* gap_type;
+    const char* gap_evidence;
+    bool fill_gaps;
+} BUILD_CONFIG;
+
+typedef struct BUILD_RECORD
+{
+    std::string name;
+    CHROMOSOME_CONTIGS contigs;
+    uint64_t seq_offset; // Offset of the first base in the uncompressed task output.
+    uint64_t seq_size;
+} BUILD_RECORD;
+
+/* A group of records written to one file, the task files are concatenated in order */
+typedef struct BUILD_TASK
+{
+    std::vector<BUILD_RECORD> records;
+    std::string temp_path, agp_temp_path;
+    uint64_t raw_size, file_size;
+    std::vector<BUILD_BGZF_BLOCK> blocks;
+} BUILD_TASK;
+
+void build_source_load(const char* fasta_path, bool stream, const char* index_path, BUILD_SOURCE& source);
+/* Build the tasks, a single thread writes the output directly, the threads write the task temporary files */
+void build_tasks(const BUILD_SOURCE& source, const BUILD_CONFIG& config, std::vector<BUILD_TASK>& tasks, FILE* output, FILE* agp_output, int32_t threads);
+
+#endif // BUILD_CHROMOSOME_H
@@ -0,0 +1,270 @@
+#include <cstdlib>
+#include <cstring>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "hmr_bgzf.hpp"
+#include "hmr_bin_file.hpp"
+#include "hmr_ui.hpp"
+
+#include "build_writer.hpp"
+
+//Complement bases of the letters, the other letters are kept.
+static char complement_bp[26] = {
+    'T', // 'A',
+    'B',
+    'G', //'C',
+    'D',
+    'E',
+    'F',
+    'C', //'G',
+    'H',
+    'I',
+    'J',
+    'K',
+    'L',
+    'M',
+    'N',
+    'O',
+    'P',
+    'Q',
+    'R',
+    'S',
+    'A', //'T',
+    'U',
+    'V',
+    'W',
+    'X',
+    'Y',
+    'Z',
+};
+
+static struct BUILD_COMPLEMENT_TABLE
+{
+    char table[256];
+    BUILD_COMPLEMENT_TABLE()
+    {
+        for (int32_t i = 0; i < 256; ++i)
+        {
+            table[i] = static_cast<char>(i);
+        }
+        for (int32_t i = 0; i < 26; ++i)
+        {
+            table['A' + i] = complement_bp[i];
+            table['a' + i] = static_cast<char>(complement_bp[i] - 'A' + 'a');
+        }
+    }
+} complement_table;
+
+void build_writer_init(BUILD_WRITER& writer, FILE* file, size_t buffer_size, size_t line_width, bool bgzf)
+{
+    writer.file = file;
+    writer.buffer_size = (buffer_size + BUILD_WRITER_ALIGN - 1) / BUILD_WRITER_ALIGN * BUILD_WRITER_ALIGN;
+    if (writer.buffer_size == 0)
+    {
+        writer.buffer_size = BUILD_WRITER_ALIGN;
+    }
+    writer.buffer_raw = static_cast<char*>(malloc(writer.buffer_size + BUILD_WRITER_ALIGN));
+    if (!writer.buffer_raw)
+    {
+        time_error(-1, "Failed to allocate memory for the output buffer.");
+    }
+    writer.buffer = writer.buffer_raw + (BUILD_WRITER_ALIGN - reinterpret_cast<uintptr_t>(writer.buffer_raw) % BUILD_WRITER_ALIGN) % BUILD_WRITER_ALIGN;
+    writer.used = 0;
+    writer.line_width = line_width;
+    writer.line_pos = 0;
+    writer.raw_size = 0;
+    writer.file_size = 0;
+    writer.bgzf = bgzf;
+    writer.block = NULL;
+    writer.blocks.clear();
+    if (bgzf)
+    {
+        writer.block = static_cast<char*>(malloc(HMR_BGZF_BLOCK_MAX));
+        if (!writer.block)
+        {
+            time_error(-1, "Failed to allocate memory for the BGZF block.");
+        }
+    }
+}
+
+inline void build_writer_output(BUILD_WRITER& writer, const char* data, size_t size)
+{
+    if (size > 0 && fwrite(data, 1, size, writer.file) != size)
+    {
+        time_error(-1, "Failed to write the output file.");
+    }
+    writer.file_size += size;
+}
+
+void build_writer_dump(BUILD_WRITER& writer, bool final = false)
+{
+    if (!writer.bgzf)
+    {
+        build_writer_output(writer, writer.buffer, writer.used);
+        writer.raw_size += writer.used;
+        writer.used = 0;
+        return;
+    }
+    //Compress the full blocks, the rest is kept until the final dump.
+    size_t offset = 0;
+    while (writer.used - offset >= HMR_BGZF_BLOCK_DATA || (final && offset < writer.used))
+    {
+        size_t data_size = writer.used - offset < HMR_BGZF_BLOCK_DATA ? writer.used - offset : HMR_BGZF_BLOCK_DATA;
+        size_t block_size = hmr_bgzf_deflate_block(writer.buffer + offset, data_size, writer.block);
+        build_writer_output(writer, writer.block, block_size);
+        writer.blocks.push_back(BUILD_BGZF_BLOCK{ static_cast<uint32_t>(block_size), static_cast<uint32_t>(data_size) });
+        writer.raw_size += data_size;
+        offset += data_size;
+    }
+    memmove(writer.buffer, writer.buffer + offset, writer.used - offset);
+    writer.used -= offset;
+}
+
+inline void build_writer_put(BUILD_WRITER& writer, char c)
+{
+    if (writer.used == writer.buffer_size)
+    {
+        build_writer_dump(writer);
+    }
+    writer.buffer[writer.used++] = c;
+}
+
+void build_writer_text(BUILD_WRITER& writer, const char* text, size_t size)
+{
+    while (size > 0)
+    {
+        if (writer.used == writer.buffer_size)
+        {
+            build_writer_dump(writer);
+        }
+        size_t copy_size = writer.buffer_size - writer.used;
+        copy_size = copy_size < size ? copy_size : size;
+        memcpy(writer.buffer + writer.used, text, copy_size);
+        writer.used += copy_size;
+        text += copy_size;
+        size -= copy_size;
+    }
+}
+
+inline size_t build_writer_seq_space(BUILD_WRITER& writer, size_t size)
+{
+    //Break the line when it is full.
+    if (writer.line_width > 0 && writer.line_pos == writer.line_width)
+    {
+        build_writer_put(writer, '\n');
+        writer.line_pos = 0;
+    }
+    if (writer.used == writer.buffer_size)
+    {
+        build_writer_dump(writer);
+    }
+    size_t space = writer.buffer_size - writer.used;
+    if (writer.line_width > 0 && writer.line_width - writer.line_pos < space)
+    {
+        space = writer.line_width - writer.line_pos;
+    }
+    return space < size ? space : size;
+}
+
+void build_writer_seq(BUILD_WRITER& writer, const char* seq, size_t size)
+{
+    while (size > 0)
+    {
+        size_t copy_size = build_writer_seq_space(writer, size);
+        memcpy(writer.buffer + writer.used, seq, copy_size);
+        writer.used += copy_size;
+        writer.line_pos += copy_size;
+        seq += copy_size;
+        size -= copy_size;
+    }
+}
+
+void build_writer_seq_reverse(BUILD_WRITER& writer, const char* seq, size_t size)
+{
+    const char* table = complement_table.table;
+    while (size > 0)
+    {
+        size_t copy_size = build_writer_seq_space(writer, size);
+        char* target = writer.buffer + writer.used;
+        for (size_t i = 0; i < copy_size; ++i)
+        {
+            target[i] = table[static_cast<uint8_t>(seq[size - 1 - i])];
+        }
+        writer.used += copy_size;
+        writer.line_pos += copy_size;
+        size -= copy_size;
+    }
+}
+
+void build_writer_seq_fill(BUILD_WRITER& writer, char base, size_t size)
+{
+    while (size > 0)
+    {
+        size_t copy_size = build_writer_seq_space(writer, size);
+        memset(writer.buffer + writer.used, base, copy_size);
+        writer.used += copy_size;
+        writer.line_pos += copy_size;
+        size -= copy_size;
+    }
+}
+
+void build_writer_seq_end(BUILD_WRITER& writer)
+{
+    build_writer_put(writer, '\n');
+    writer.line_pos = 0;
+}
+
+void build_writer_flush(BUILD_WRITER& writer)
+{
+    build_writer_dump(writer, true);
+    fflush(writer.file);
+}
+
+void build_writer_free(BUILD_WRITER& writer)
+{
+    build_writer_flush(writer);
+    free(writer.buffer_raw);
+    free(writer.block);
+    writer.buffer_raw = NULL;
+    writer.buffer = NULL;
+    writer.block = NULL;
+}
+
+void build_file_append(FILE* target, const char* source_path)
+{
+    FILE* source;
+    if (!bin_open(source_path, &source, "rb"))
+    {
+        time_error(-1, "Failed to read the temporary file %s", source_path);
+    }
+    fflush(target);
+#ifdef __linux__
+    //Copy inside the kernel when possible.
+    int source_fd = fileno(source), target_fd = fileno(target);
+    ssize_t copied;
+    while ((copied = copy_file_range(source_fd, NULL, target_fd, NULL, 1 << 30, 0)) > 0)
+    {
+    }
+    if (copied == 0)
+    {
+        fclose(source);
+        return;
+    }
+    //Fall back to the user space copy from the current position.
+    lseek(target_fd, 0, SEEK_END);
+    fseek(target, 0, SEEK_END);
+#endif
+    std::vector<char> buffer(4 << 20);
+    size_t read_size;
+    while ((read_size = fread(buffer.data(), 1, buffer.size(), source)) > 0)
+    {
+        if (fwrite(buffer.data(), 1, read_size, target) != read_size)
+        {
+            time_error(-1, "Failed to write the output file.");
+        }
+    }
+    fclose(source);
+}
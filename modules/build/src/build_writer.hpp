@@ -0,0 +1,47 @@
+#ifndef BUILD_WRITER_H
+#define BUILD_WRITER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+//The write buffer is aligned to the page size, only whole buffers are written before the flush.
+constexpr size_t BUILD_WRITER_ALIGN = 4096;
+
+typedef struct BUILD_BGZF_BLOCK
+{
+    uint32_t block_size;
+    uint32_t data_size;
+} BUILD_BGZF_BLOCK;
+
+typedef struct BUILD_WRITER
+{
+    FILE* file;
+    char* buffer_raw;
+    char* buffer;
+    size_t buffer_size, used;
+    size_t line_width, line_pos; // Sequence line wrapping width, 0 for a single line.
+    uint64_t raw_size, file_size; // Bytes before and after the compression.
+    //BGZF output, the blocks are recorded for the index.
+    bool bgzf;
+    char* block;
+    std::vector<BUILD_BGZF_BLOCK> blocks;
+} BUILD_WRITER;
+
+void build_writer_init(BUILD_WRITER& writer, FILE* file, size_t buffer_size, size_t line_width, bool bgzf);
+void build_writer_text(BUILD_WRITER& writer, const char* text, size_t size);
+void build_writer_seq(BUILD_WRITER& writer, const char* seq, size_t size);
+/* Write the reverse complement of the sequence */
+void build_writer_seq_reverse(BUILD_WRITER& writer, const char* seq, size_t size);
+/* Write a run of the same base, e.g. the N of the gaps */
+void build_writer_seq_fill(BUILD_WRITER& writer, char base, size_t size);
+/* End the sequence line of the current record */
+void build_writer_seq_end(BUILD_WRITER& writer);
+/* Write all the buffered data, the BGZF output ends the last block */
+void build_writer_flush(BUILD_WRITER& writer);
+void build_writer_free(BUILD_WRITER& writer);
+
+/* Append the whole source file to the end of the target file */
+void build_file_append(FILE* target, const char* source_path);
+
+#endif // BUILD_WRITER_H
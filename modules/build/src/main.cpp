@@ -2,179 +2,201 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
-#include <list>
 #include <vector>
 
 #include "hmr_args.hpp"
+#include "hmr_bgzf.hpp"
+#include "hmr_bin_file.hpp"
 #include "hmr_contig_graph.hpp"
 #include "hmr_fasta.hpp"
 #include "hmr_path.hpp"
-#include "hmr_global.hpp"
+#include "hmr_stats.hpp"
 #include "hmr_text_file.hpp"
 #include "hmr_ui.hpp"
 
 #include "args_build.hpp"
+#include "build_chromosome.hpp"
+#include "build_writer.hpp"
 
 extern HMR_ARGS opts;
 
-typedef struct CONTIG_SEQ
-{
-    char* name, * seq;
-    size_t name_size, seq_size;
-} CONTIG_SEQ;
-
-typedef std::vector<CONTIG_SEQ> CONTIG_DICT;
-typedef std::deque<CONTIG_SEQ> CONTIG_DICT_LIST;
-
-
-static char reverse_bp[26] = {
-    'T', // 'A',
-    'B',
-    'G', //'C',
-    'D',
-    'E',
-    'F',
-    'C', //'G',
-    'H',
-    'I',
-    'J',
-    'K',
-    'L',
-    'M',
-    'N',
-    'O',
-    'P',
-    'Q',
-    'R',
-    'S',
-    'A', //'T',
-    'U',
-    'V',
-    'W',
-    'X',
-    'Y',
-    'Z',
-};
-
-void build_fasta_loader(int32_t seq_index, char *name, size_t name_len, char *seq_data, size_t seq_data_len, void *user)
-{
-    CONTIG_DICT_LIST *contigs = reinterpret_cast<CONTIG_DICT_LIST*>(user);
-    //Construct the contig building dictionary.
-    contigs->push_back(CONTIG_SEQ{ name, seq_data, name_len, seq_data_len });
-}
-
-typedef struct CHROMOSOME_BUILD
-{
-    CONTIG_DICT contigs;
-    FILE *output_fasta, *output_agp;
-} CHROMOSOME_BUILD;
-
-void build_chromosome(const HMR_DIRECTED_CONTIG &contig_info, CHROMOSOME_BUILD& builder)
-{
-    CONTIG_DICT& contigs = builder.contigs;
-    //Extract the sequence from the directory.
-    CONTIG_SEQ &contig = contigs[contig_info.id];
-    //Check the direction.
-    if(contig_info.direction)
-    {
-        //It is reversed.
-        char *rev_buffer = static_cast<char *>(malloc(contig.seq_size + 1)),
-                *seq = contig.seq;
-        assert(rev_buffer);
-        size_t i_max = contig.seq_size;
-        for(size_t i=0; i<i_max; ++i)
-        {
-            size_t rev_idx = i_max - i - 1;
-            if(seq[rev_idx] >= 'A' && seq[rev_idx] <= 'Z')
-            {
-                rev_buffer[i] = reverse_bp[seq[rev_idx] - 'A'];
-            }
-        }
-        fwrite(rev_buffer, i_max, 1, builder.output_fasta);
-        free(rev_buffer);
-    }
-    else
-    {
-        //Just simply write the sequence.
-        fwrite(contig.seq, contig.seq_size, 1, builder.output_fasta);
-    }
-}
-
-size_t build_agp(size_t offset, std::string title, const HMR_DIRECTED_CONTIG& contig_info, CHROMOSOME_BUILD& builder, size_t *counter)
-{
-    //Extract the sequence from the directory.
-    const CONTIG_SEQ& contig = builder.contigs[contig_info.id];
-    size_t next_offset = offset + contig.seq_size;
-    fprintf(builder.output_agp, "%s\t%zu\t%zu\t%zu\tW\t%s\t1\t%zu\t%c\n", title.c_str(), offset, next_offset - 1, *counter, contig.name, contig.seq_size, contig_info.direction ? '-' : '+');
-    ++(*counter);
-    return next_offset;
-}
+//Bases of the unplaced contigs in one build task.
+constexpr size_t BUILD_UNPLACED_TASK_BASES = 64 << 20;
 
 int main(int argc, char *argv[])
 {
     //Parse the arguments.
     parse_arguments(argc, argv);
+    if (opts.stats) { hmr_stats_enable("hana_build", opts.stats); }
     //Check the arguments are meet the requirements.
     if (!opts.fasta) { help_exit(-1, "Missing FASTA file path."); }
     if (!path_can_read(opts.fasta)) { time_error(-1, "Cannot read FASTA file %s", opts.fasta); }
     if (opts.chromosomes.empty()) { help_exit(-1, "Missing chromosome sequence file paths."); }
     if (!opts.output) { help_exit(-1, "Missing output fasta file path."); }
-    //Load the FASTA and cache all the sequence.
-    CHROMOSOME_BUILD builder;
+    time_print("Execution configuration:");
+    time_print("\tThreads: %d", opts.threads);
+    time_print("\tStreaming mode: %s", opts.stream ? "Yes" : "No");
+    time_print("\tBGZF output: %s", opts.bgzip ? "Yes" : "No");
+    time_print("\tLine width: %d", opts.line_width);
+    time_print("\tWrite buffer: %dM", opts.write_buffer);
+    time_print("\tComplete build: %s", opts.complete ? "Yes" : "No");
+    time_print("\tGap: %d bp, type %s, evidence %s", opts.gap_length, opts.gap_type, opts.gap_evidence);
+    if (opts.gap_length < 1) { time_error(-1, "Invalid gap length %d.", opts.gap_length); }
+    BUILD_SOURCE source;
     {
-        CONTIG_DICT_LIST contig_list;
-        time_print("Constructing FASTA sequence index from %s", opts.fasta);
-        hmr_fasta_read(opts.fasta, build_fasta_loader, &contig_list);
-        hDequeListToVector(contig_list, builder.contigs);
-        time_print("%zu sequences loaded.", contig_list.size());
+        HMR_STATS_SCOPE load_scope("build.load_source");
+        build_source_load(opts.fasta, opts.stream, opts.index, source);
     }
     //Open the output file to write data.
     assert(opts.output);
-    std::string fasta_path = std::string(opts.output) + "_build.fasta";
+    std::string fasta_path = std::string(opts.output) + (opts.bgzip ? "_build.fasta.gz" : "_build.fasta");
     std::string agp_path = std::string(opts.output) + "_build.agp";
+    FILE* output_fasta, * output_agp;
     time_print("Opening output FASTA file %s", fasta_path.c_str());
-    if(!text_open_write(fasta_path.c_str(), &builder.output_fasta))
+    if (!bin_open(fasta_path.c_str(), &output_fasta, "wb"))
     {
         time_error(-1, "Failed to open the output FASTA file.");
     }
+    //The writers flush their own buffers, skip the stdio buffer before the first write.
+    setvbuf(output_fasta, NULL, _IONBF, 0);
     time_print("Opening output AGP file %s", agp_path.c_str());
-    if (!text_open_write(agp_path.c_str(), &builder.output_agp))
+    if (!text_open_write(agp_path.c_str(), &output_agp))
     {
         time_error(-1, "Failed to open the output AGP file.");
     }
-    for(size_t i=0; i<opts.chromosomes.size(); ++i)
+    //Each chromosome is a task, the threads build the tasks into the temporary files.
+    std::vector<BUILD_TASK> tasks;
+    std::vector<bool> placed(source.contigs.size(), false);
+    for (size_t i = 0; i < opts.chromosomes.size(); ++i)
     {
-        char *chromo_path = opts.chromosomes[i];
-        time_print("Constructing chromosome %zu from %s", i+1, chromo_path);
-        //Write the name of the chromosome.
-        std::string group_name = "Group_" + std::to_string(i + 1);
-        fprintf(builder.output_fasta, ">%s\n", group_name.c_str());
-        CHROMOSOME_CONTIGS seq;
-        hmr_graph_load_chromosome(chromo_path, seq);
-        if (seq.empty())
+        char* chromo_path = opts.chromosomes[i];
+        time_print("Loading chromosome %zu from %s", i + 1, chromo_path);
+        BUILD_RECORD record;
+        record.name = "Group_" + std::to_string(i + 1);
+        hmr_graph_load_chromosome(chromo_path, record.contigs);
+        if (record.contigs.empty())
         {
             continue;
         }
-        for (const auto &contig_info: seq)
+        for (const auto& contig_info : record.contigs)
         {
-            build_chromosome(contig_info, builder);
+            placed[contig_info.id] = true;
+        }
+        BUILD_TASK task;
+        task.records.push_back(record);
+        tasks.push_back(task);
+    }
+    if (opts.complete)
+    {
+        //The unplaced contigs are written as scaffolds by themselves, they are grouped into tasks by length.
+        size_t unplaced = 0, unplaced_bp = 0, task_bp = 0;
+        for (size_t i = 0; i < source.contigs.size(); ++i)
+        {
+            //Empty records have no bases to write, and their AGP line would end before it starts.
+            if (placed[i] || source.contigs[i].seq_size == 0)
+            {
+                continue;
+            }
+            if (unplaced == 0 || task_bp >= BUILD_UNPLACED_TASK_BASES)
+            {
+                tasks.push_back(BUILD_TASK());
+                task_bp = 0;
+            }
+            BUILD_RECORD record;
+            record.name = std::string(source.contigs[i].name, source.contigs[i].name_size);
+            record.contigs.push_back(HMR_DIRECTED_CONTIG{ static_cast<int32_t>(i), 0 });
+            tasks.back().records.push_back(record);
+            task_bp += source.contigs[i].seq_size;
+            unplaced_bp += source.contigs[i].seq_size;
+            ++unplaced;
+        }
+        time_print("%zu unplaced contig(s), %zu bp in total.", unplaced, unplaced_bp);
+    }
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        tasks[i].temp_path = fasta_path + "." + std::to_string(i) + ".tmp";
+        tasks[i].agp_temp_path = agp_path + "." + std::to_string(i) + ".tmp";
+    }
+    int32_t threads = opts.threads < 1 ? 1 : opts.threads;
+    if (threads > static_cast<int32_t>(tasks.size()))
+    {
+        threads = static_cast<int32_t>(tasks.size());
+    }
+    BUILD_CONFIG config{ static_cast<size_t>(opts.write_buffer < 1 ? 1 : opts.write_buffer) << 20, static_cast<size_t>(opts.line_width < 0 ? 0 : opts.line_width), opts.bgzip,
+                         static_cast<size_t>(opts.gap_length), opts.gap_type, opts.gap_evidence, opts.complete };
+    if (opts.complete)
+    {
+        fprintf(output_agp, "##agp-version\t2.1\n");
+    }
+    time_print("Constructing %zu task(s) with %d thread(s)...", tasks.size(), threads);
+    {
+        HMR_STATS_SCOPE task_scope("build.tasks");
+        build_tasks(source, config, tasks, output_fasta, output_agp, threads);
+    }
+    if (threads > 1)
+    {
+        HMR_STATS_SCOPE concat_scope("build.concatenate");
+        //Concatenate the task files in order.
+        time_print("Concatenating task files...");
+        for (const BUILD_TASK& task : tasks)
+        {
+            build_file_append(output_fasta, task.temp_path.c_str());
+            build_file_append(output_agp, task.agp_temp_path.c_str());
+            remove(task.temp_path.c_str());
+            remove(task.agp_temp_path.c_str());
+        }
+    }
+    if (opts.bgzip)
+    {
+        hmr_bgzf_write_eof(output_fasta);
+    }
+    fclose(output_fasta);
+    //Write the AGP and the FASTA index of the output.
+    HMR_FASTA_INDEX output_index;
+    uint64_t raw_offset = 0;
+    for (const BUILD_TASK& task : tasks)
+    {
+        for (const BUILD_RECORD& record : task.records)
+        {
+            uint64_t line_bases = opts.line_width > 0 ? static_cast<uint64_t>(opts.line_width) : record.seq_size;
+            output_index.push_back(HMR_FASTA_INDEX_ITEM{ record.name, record.seq_size, raw_offset + record.seq_offset, line_bases, line_bases + 1 });
+        }
+        raw_offset += task.raw_size;
+    }
+    fclose(output_agp);
+    std::string fai_path = hmr_fasta_index_path(fasta_path.c_str());
+    time_print("Saving output FASTA index to %s", fai_path.c_str());
+    hmr_fasta_index_save(fai_path.c_str(), output_index);
+    if (opts.bgzip)
+    {
+        //The BGZF index keeps the compressed and the uncompressed offsets of every block except the first one.
+        std::string gzi_path = fasta_path + ".gzi";
+        time_print("Saving output BGZF index to %s", gzi_path.c_str());
+        std::vector<uint64_t> offsets;
+        uint64_t file_offset = 0, data_offset = 0;
+        for (const BUILD_TASK& task : tasks)
+        {
+            for (const BUILD_BGZF_BLOCK& block : task.blocks)
+            {
+                if (file_offset > 0)
+                {
+                    offsets.push_back(file_offset);
+                    offsets.push_back(data_offset);
+                }
+                file_offset += block.block_size;
+                data_offset += block.data_size;
+            }
         }
-        fprintf(builder.output_fasta, "\n");
-        //Build AGP file.
-        size_t offset = 1, contig_counter = 1;
-        //Output the first contig.
-        offset = build_agp(offset, group_name, seq[0], builder, &contig_counter);
-        for (size_t info_id = 1; info_id < seq.size(); ++info_id)
+        FILE* gzi_file;
+        if (!bin_open(gzi_path.c_str(), &gzi_file, "wb"))
         {
-            //Write a 100 gap.
-            size_t next_offset = offset + 100;
-            fprintf(builder.output_agp, "%s\t%zu\t%zu\t%zu\tU\t100\tcontig\tyes\tmap\n", group_name.c_str(), offset, next_offset - 1, contig_counter);
-            ++contig_counter;
-            offset = build_agp(next_offset, group_name, seq[info_id], builder, &contig_counter);
+            time_error(-1, "Failed to open the output BGZF index file.");
         }
+        uint64_t entries = offsets.size() >> 1;
+        fwrite(&entries, sizeof(uint64_t), 1, gzi_file);
+        fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), gzi_file);
+        fclose(gzi_file);
     }
-    fclose(builder.output_fasta);
-    fclose(builder.output_agp);
     time_print("Build complete.");
     return 0;
 }
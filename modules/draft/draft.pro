@@ -13,9 +13,12 @@ SOURCES += \
     ../shared/hmr_bin_file.cpp \
     ../shared/hmr_contig_graph.cpp \
     ../shared/hmr_path.cpp \
+    ../shared/hmr_stats.cpp \
     ../shared/hmr_ui.cpp \
     src/args_draft.cpp \
     src/draft_mappings.cpp \
+    src/draft_stream.cpp \
+    src/draft_summary.cpp \
     src/main.cpp
 
 HEADERS += \
@@ -27,7 +30,11 @@ HEADERS += \
     ../shared/hmr_contig_graph.hpp \
     ../shared/hmr_contig_graph_type.hpp \
     ../shared/hmr_path.hpp \
+    ../shared/hmr_stats.hpp \
+    ../shared/hmr_task_scheduler.hpp \
     ../shared/hmr_ui.hpp \
     src/args_draft.hpp \
     src/draft_mappings.hpp \
-    src/draft_mappings_type.hpp
+    src/draft_mappings_type.hpp \
+    src/draft_stream.hpp \
+    src/draft_summary.hpp
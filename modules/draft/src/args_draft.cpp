@@ -11,8 +11,12 @@ HMR_ARG_PARSER args_parser = {
     { {"-r", "--reads"}, "READS", "HMR paired-reads file (.hmr_reads)", LAMBDA_PARSE_ARG { opts.reads = arg[0]; }},
     { {"-a", "--allele-table"}, "ALLELE_TABLE", "Allele contig table (.hmr_allele_table)", LAMBDA_PARSE_ARG {opts.allele_table = arg[0]; }},
     { {"-o", "--output"}, "OUTPUT", "Output graph prefix", LAMBDA_PARSE_ARG {opts.output = arg[0]; }},
+    { {"-t", "--threads"}, "THREADS", "Number of threads (default: 1)", LAMBDA_PARSE_ARG { opts.threads = atoi(arg[0]); }},
     { {"-b", "--buffer-size"}, "BUFFER_SIZE", "HMR paired-reads buffer size (unit: K, default: 512)", LAMBDA_PARSE_ARG {opts.read_buffer_size = atoi(arg[0]); }},
+    { {"--sort-memory"}, "SORT_MEMORY", "Memory for sorting paired-reads edges before spilling to disk (unit: M, default: 1024)", LAMBDA_PARSE_ARG {opts.sort_memory = atoi(arg[0]); }},
     { {"--min-links"}, "MIN_LINKS", "Minimum number of links for contig pair (default: 3)", LAMBDA_PARSE_ARG {opts.min_links = atoi(arg[0]); }},
     { {"--min-re"}, "MIN_RE", "Minimum number of RE sites in a contig (default: 10)", LAMBDA_PARSE_ARG {opts.min_re = atoi(arg[0]); }},
     { {"--max-link-density"}, "MAX_DENSITY", "Maximum allowed link density (default: 2)", LAMBDA_PARSE_ARG {opts.max_density = atof(arg[0]); }},
+    { {"--summary"}, "", "Save the paired-reads summary (.hmr_summary) for the later stages in the same reads pass", LAMBDA_PARSE_ARG { (void)arg; opts.summary = true; }},
+    { {"--stats"}, "STATS", "Save the stage timings, counters and peak memory as JSON", LAMBDA_PARSE_ARG {opts.stats = arg[0]; }},
 };
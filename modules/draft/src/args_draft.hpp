@@ -10,8 +10,10 @@ typedef struct HMR_ARGS
     const char* reads = NULL;
     const char* allele_table = NULL;
     const char* output = NULL;
+    const char* stats = NULL;
     double max_density = 2.0;
-    int min_links = 3, min_re = 10, read_buffer_size = 512;
+    int min_links = 3, min_re = 10, threads = 1, read_buffer_size = 512, sort_memory = 1024;
+    bool summary = false;
 } HMR_ARGS;
 
 #endif // ARGS_DRAFT_H
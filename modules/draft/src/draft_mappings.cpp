@@ -1,83 +1,187 @@
+#include <algorithm>
+
 #include "hmr_algorithm.hpp"
 #include "hmr_contig_graph.hpp"
+#include "hmr_task_scheduler.hpp"
 
 #include "draft_mappings.hpp"
 
-void draft_mappings_build_edges(HMR_MAPPING* mapping, int32_t buf_size, void* user)
+void draft_mappings_build_edge_map(const DRAFT_EDGE_COUNT* counts, size_t count_size, void* user)
 {
-    EDGE_COUNTER* edges = static_cast<EDGE_COUNTER*>(user);
-    //Loop for all the mapping info.
-    for (int32_t i = 0; i < buf_size; ++i)
+    EDGE_COUNT_MAP* edge_map = static_cast<EDGE_COUNT_MAP*>(user);
+    int32_t node_start, node_end;
+    //Loop for the all the sorted edge counts.
+    for (size_t i = 0; i < count_size; ++i)
     {
-        const HMR_MAPPING& mapping_info = mapping[i];
-        //Only care about inter-connected edges.
-        if(mapping_info.refID == mapping_info.next_refID)
-        {
-            continue;
-        }
-        //Increase the counter on the edge.
-        uint64_t edge = hmr_graph_edge_data(mapping_info.refID, mapping_info.next_refID);
-        const auto iter = edges->find(edge);
-        if (iter == edges->end())
-        {
-            edges->insert(std::make_pair(edge, 1));
-        }
-        else
-        {
-            ++iter->second;
-        }
+        //Count the edge for both nodes.
+        hmr_graph_edge_pos(counts[i].edge, node_start, node_end);
+        int32_t edge_count = static_cast<int32_t>(counts[i].count);
+        (*edge_map)[node_start].insert(std::make_pair(node_end, edge_count));
+        (*edge_map)[node_end].insert(std::make_pair(node_start, edge_count));
     }
 }
 
-inline void count_edge(EDGE_COUNT_MAP* edge_map, int32_t node_start, int32_t node_end)
+inline bool remove_edge(EDGE_COUNT_MAP& edge_map, int32_t node_start, int32_t node_end)
 {
-    auto &node_map = (*edge_map)[node_start];
-    //Find the end node in the target map.
+    auto &node_map = edge_map[node_start];
     const auto node_iter = node_map.find(node_end);
     if(node_iter == node_map.end())
     {
-        node_map.insert(std::make_pair(node_end, 1));
+        return false;
     }
-    else
+    node_map.erase(node_iter);
+    return true;
+}
+
+void draft_mappings_remove_edge(EDGE_COUNT_MAP &edge_map, int32_t node_a, int32_t node_b)
+{
+    if(remove_edge(edge_map, node_a, node_b))
     {
-        ++node_iter->second;
+        remove_edge(edge_map, node_b, node_a);
     }
 }
 
-void draft_mappings_build_edge_counter(HMR_MAPPING *mapping, int32_t buf_size, void *user)
+typedef struct ALLELE_ROW_PAIR
 {
-    EDGE_COUNT_MAP* edge_map = static_cast<EDGE_COUNT_MAP*>(user);
-    //Loop for the all the mapping info.
-    for(int32_t i = 0; i < buf_size; ++i)
+    size_t row_j;
+    std::vector<HMR_EDGE_INFO> edges;
+} ALLELE_ROW_PAIR;
+
+void draft_mappings_row_pair_worker(int32_t worker_id, int32_t threads, const EDGE_COUNT_MAP& edge_map, const HMR_CONTIG_ID_TABLE& allele_table,
+    const std::vector<HMR_CONTIG_ID_VEC>& contig_rows, std::vector<std::vector<ALLELE_ROW_PAIR> >* row_pairs)
+{
+    std::vector<size_t> candidates;
+    for (size_t i = worker_id; i < allele_table.size(); i += threads)
     {
-        const HMR_MAPPING& mapping_info = mapping[i];
-        //Only care about inter-connected edges.
-        if(mapping_info.refID == mapping_info.next_refID)
+        //Find the rows connected to row i by any edge.
+        candidates.clear();
+        for (const int32_t contig_i : allele_table[i])
         {
-            continue;
+            for (const auto& neighbour : edge_map[contig_i])
+            {
+                for (const int32_t row_j : contig_rows[neighbour.first])
+                {
+                    if (static_cast<size_t>(row_j) > i)
+                    {
+                        candidates.push_back(static_cast<size_t>(row_j));
+                    }
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        //Collect the edges between the different contigs of the two rows.
+        std::vector<ALLELE_ROW_PAIR>& pairs = (*row_pairs)[i];
+        for (const size_t j : candidates)
+        {
+            //Copy two allele row.
+            HMR_CONTIG_ID_VEC row_i(allele_table[i]), row_j(allele_table[j]);
+            //Only care about the different contigs.
+            hmr_remove_common(row_i, row_j);
+            ALLELE_ROW_PAIR row_pair;
+            row_pair.row_j = j;
+            for (const int32_t contig_i : row_i)
+            {
+                const NODE_COUNT_MAP& contig_i_map = edge_map[contig_i];
+                if (contig_i_map.empty())
+                {
+                    continue;
+                }
+                for (const int32_t contig_j : row_j)
+                {
+                    auto iter_j = contig_i_map.find(contig_j);
+                    if (iter_j == contig_i_map.end())
+                    {
+                        continue;
+                    }
+                    row_pair.edges.push_back(HMR_EDGE_INFO{ contig_i, contig_j, static_cast<uint64_t>(iter_j->second), 0.0 });
+                }
+            }
+            //If there is no edges for these two rows, we don't care about that.
+            if (row_pair.edges.empty())
+            {
+                continue;
+            }
+            std::stable_sort(row_pair.edges.begin(), row_pair.edges.end(),
+                [](const HMR_EDGE_INFO& lhs, const HMR_EDGE_INFO& rhs)
+                {
+                    return lhs.pairs > rhs.pairs;
+                });
+            pairs.push_back(std::move(row_pair));
         }
-        //Count the edge for both nodes.
-        count_edge(edge_map, mapping_info.refID, mapping_info.next_refID);
-        count_edge(edge_map, mapping_info.next_refID, mapping_info.refID);
     }
 }
 
-inline bool remove_edge(EDGE_COUNT_MAP& edge_map, int32_t node_start, int32_t node_end)
+void draft_mappings_remove_allele_edges(EDGE_COUNT_MAP& edge_map, const HMR_CONTIG_ID_TABLE& allele_table, int32_t threads)
 {
-    auto &node_map = edge_map[node_start];
-    const auto node_iter = node_map.find(node_end);
-    if(node_iter == node_map.end())
+    //Remove the inter-connected edges inside a row.
+    for (const auto& conflict_row : allele_table)
     {
-        return false;
+        int32_t row_size = static_cast<int32_t>(conflict_row.size());
+        //Remove the record inter-connected edges.
+        for (int32_t i = 0; i < row_size - 1; ++i)
+        {
+            for (int32_t j = i + 1; j < row_size; ++j)
+            {
+                draft_mappings_remove_edge(edge_map, conflict_row[i], conflict_row[j]);
+            }
+        }
     }
-    node_map.erase(node_iter);
-    return true;
-}
-
-void draft_mappings_remove_edge(EDGE_COUNT_MAP &edge_map, int32_t node_a, int32_t node_b)
-{
-    if(remove_edge(edge_map, node_a, node_b))
+    //Build the contig to allele rows index.
+    std::vector<HMR_CONTIG_ID_VEC> contig_rows(edge_map.size());
+    for (size_t i = 0; i < allele_table.size(); ++i)
     {
-        remove_edge(edge_map, node_b, node_a);
+        for (const int32_t contig_id : allele_table[i])
+        {
+            contig_rows[contig_id].push_back(static_cast<int32_t>(i));
+        }
+    }
+    //Find the row pairs linked by edges and their sorted edges.
+    std::vector<std::vector<ALLELE_ROW_PAIR> > row_pairs(allele_table.size());
+    if (threads < 2)
+    {
+        draft_mappings_row_pair_worker(0, 1, edge_map, allele_table, contig_rows, &row_pairs);
+    }
+    else
+    {
+        hmr::task_scheduler scheduler(threads);
+        hmr::task_group row_pair_group(scheduler);
+        for (int32_t i = 0; i < threads; ++i)
+        {
+            row_pair_group.run([&, i] { draft_mappings_row_pair_worker(i, threads, edge_map, allele_table, contig_rows, &row_pairs); });
+        }
+        row_pair_group.wait();
+    }
+    //For edges between rows, leave only the strongest connected edges.
+    //The row pairs are applied in order, edges removed by a previous pair are skipped.
+    for (size_t i = 0; i < allele_table.size(); ++i)
+    {
+        for (const ALLELE_ROW_PAIR& row_pair : row_pairs[i])
+        {
+            HMR_CONTIG_ID_VEC row_i(allele_table[i]), row_j(allele_table[row_pair.row_j]);
+            hmr_remove_common(row_i, row_j);
+            //Pick out the first edges, check whether these two contigs are still in the row.
+            //If not, remove the edge.
+            for (const HMR_EDGE_INFO& edge : row_pair.edges)
+            {
+                const NODE_COUNT_MAP& start_map = edge_map[edge.start];
+                if (start_map.find(edge.end) == start_map.end())
+                {
+                    continue;
+                }
+                if (!hmr_in_ordered_vector(edge.start, row_i) ||
+                    !hmr_in_ordered_vector(edge.end, row_j))
+                {
+                    //Remove the edge.
+                    draft_mappings_remove_edge(edge_map, edge.start, edge.end);
+                    continue;
+                }
+                //Or else, we found an edge that is valid, remove the contig from the vector.
+                hmr_remove_one(row_i, edge.start);
+                hmr_remove_one(row_j, edge.end);
+            }
+        }
+        //Release the row pairs once applied.
+        std::vector<ALLELE_ROW_PAIR>().swap(row_pairs[i]);
     }
 }
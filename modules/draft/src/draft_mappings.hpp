@@ -9,9 +9,8 @@ typedef struct ALLELE_NEIGHBOUR
     int32_t count;
 } ALLELE_NEIGHBOUR;
 
-void draft_mappings_build_edges(HMR_MAPPING* mapping, int32_t buf_size, void* user);
-
 void draft_mappings_remove_edge(EDGE_COUNT_MAP &edge_map, int32_t node_a, int32_t node_b);
-void draft_mappings_build_edge_counter(HMR_MAPPING* mapping, int32_t buf_size, void* user);
+void draft_mappings_remove_allele_edges(EDGE_COUNT_MAP& edge_map, const HMR_CONTIG_ID_TABLE& allele_table, int32_t threads);
+void draft_mappings_build_edge_map(const DRAFT_EDGE_COUNT* counts, size_t count_size, void* user);
 
 #endif // DRAFT_MAPPINGS_H
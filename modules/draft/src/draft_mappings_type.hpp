@@ -3,9 +3,13 @@
 
 #include "hmr_contig_graph_type.hpp"
 
-typedef std::unordered_map<uint64_t, int32_t> EDGE_COUNTER;
-
 typedef std::unordered_map<int32_t, int32_t> NODE_COUNT_MAP;
 typedef std::vector<NODE_COUNT_MAP> EDGE_COUNT_MAP;
 
+typedef struct DRAFT_EDGE_COUNT
+{
+    uint64_t edge;
+    uint64_t count;
+} DRAFT_EDGE_COUNT;
+
 #endif // DRAFT_MAPPINGS_TYPE_H
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+
+#include "hmr_bin_file.hpp"
+#include "hmr_contig_graph.hpp"
+#include "hmr_ui.hpp"
+
+#include "draft_stream.hpp"
+
+constexpr size_t DRAFT_RUN_BUFFER_SIZE = 4096;
+
+void draft_stream_init(DRAFT_EDGE_SORTER& sorter, const char* run_prefix, size_t capacity)
+{
+    sorter.run_prefix = std::string(run_prefix);
+    sorter.capacity = capacity < 1 ? 1 : capacity;
+    sorter.edges.clear();
+    //The buffer is allocated once, growing by doubling could take twice the capacity before the spill.
+    sorter.edges.reserve(sorter.capacity);
+    sorter.runs.clear();
+    sorter.tail.clear();
+}
+
+void draft_stream_radix_sort(uint64_t* edges, uint64_t* temp, size_t edge_size)
+{
+    //Count all the byte histograms in one pass.
+    std::vector<size_t> histograms(8 * 256, 0);
+    for (size_t i = 0; i < edge_size; ++i)
+    {
+        for (int32_t b = 0; b < 8; ++b)
+        {
+            ++histograms[(b << 8) | ((edges[i] >> (b << 3)) & 0xFF)];
+        }
+    }
+    uint64_t* source = edges, * target = temp;
+    for (int32_t b = 0; b < 8; ++b)
+    {
+        size_t* histogram = histograms.data() + (b << 8);
+        //Skip the byte when all the edges are the same on it.
+        if (histogram[(source[0] >> (b << 3)) & 0xFF] == edge_size)
+        {
+            continue;
+        }
+        size_t offset = 0;
+        for (int32_t i = 0; i < 256; ++i)
+        {
+            size_t bucket_size = histogram[i];
+            histogram[i] = offset;
+            offset += bucket_size;
+        }
+        for (size_t i = 0; i < edge_size; ++i)
+        {
+            target[histogram[(source[i] >> (b << 3)) & 0xFF]++] = source[i];
+        }
+        std::swap(source, target);
+    }
+    if (source != edges)
+    {
+        memcpy(edges, source, sizeof(uint64_t) * edge_size);
+    }
+}
+
+void draft_stream_sort_edges(DRAFT_EDGE_SORTER& sorter, std::vector<DRAFT_EDGE_COUNT>& counts)
+{
+    auto& edges = sorter.edges;
+    counts.clear();
+    if (edges.empty())
+    {
+        return;
+    }
+    {
+        std::vector<uint64_t> temp(edges.size());
+        draft_stream_radix_sort(edges.data(), temp.data(), edges.size());
+    }
+    //Collapse the sorted edges into counts.
+    counts.push_back(DRAFT_EDGE_COUNT{ edges[0], 1 });
+    for (size_t i = 1; i < edges.size(); ++i)
+    {
+        if (edges[i] == counts.back().edge)
+        {
+            ++counts.back().count;
+            continue;
+        }
+        counts.push_back(DRAFT_EDGE_COUNT{ edges[i], 1 });
+    }
+    edges.clear();
+}
+
+void draft_stream_spill(DRAFT_EDGE_SORTER& sorter)
+{
+    std::vector<DRAFT_EDGE_COUNT> counts;
+    draft_stream_sort_edges(sorter, counts);
+    //Write the sorted counts to a run file.
+    std::string run_path = sorter.run_prefix + ".run" + std::to_string(sorter.runs.size());
+    FILE* run_file;
+    if (!bin_open(run_path.c_str(), &run_file, "wb"))
+    {
+        time_error(-1, "Failed to create edge run file %s", run_path.c_str());
+    }
+    uint64_t count_size = counts.size();
+    fwrite(&count_size, sizeof(uint64_t), 1, run_file);
+    fwrite(counts.data(), sizeof(DRAFT_EDGE_COUNT), counts.size(), run_file);
+    fclose(run_file);
+    sorter.runs.push_back(run_path);
+}
+
+void draft_stream_sort_proc(HMR_MAPPING* mapping, int32_t buf_size, void* user)
+{
+    DRAFT_EDGE_SORTER* sorter = static_cast<DRAFT_EDGE_SORTER*>(user);
+    //Loop for all the mapping info.
+    for (int32_t i = 0; i < buf_size; ++i)
+    {
+        const HMR_MAPPING& mapping_info = mapping[i];
+        //Only care about inter-connected edges.
+        if (mapping_info.refID == mapping_info.next_refID)
+        {
+            continue;
+        }
+        sorter->edges.push_back(hmr_graph_edge_data(mapping_info.refID, mapping_info.next_refID));
+        //Spill the edges when the buffer is full.
+        if (sorter->edges.size() >= sorter->capacity)
+        {
+            draft_stream_spill(*sorter);
+        }
+    }
+}
+
+typedef struct DRAFT_RUN_CURSOR
+{
+    FILE* run_file;
+    uint64_t remain;
+    std::vector<DRAFT_EDGE_COUNT> buffer;
+    size_t pos;
+} DRAFT_RUN_CURSOR;
+
+inline bool draft_stream_cursor_fetch(DRAFT_RUN_CURSOR& cursor)
+{
+    if (cursor.pos < cursor.buffer.size())
+    {
+        return true;
+    }
+    //The memory run has no file to fetch.
+    if (!cursor.run_file || cursor.remain == 0)
+    {
+        return false;
+    }
+    size_t fetch_size = static_cast<size_t>(std::min<uint64_t>(cursor.remain, DRAFT_RUN_BUFFER_SIZE));
+    cursor.buffer.resize(fetch_size);
+    if (fread(cursor.buffer.data(), sizeof(DRAFT_EDGE_COUNT), fetch_size, cursor.run_file) != fetch_size)
+    {
+        time_error(-1, "Edge run file is truncated.");
+    }
+    cursor.remain -= fetch_size;
+    cursor.pos = 0;
+    return true;
+}
+
+void draft_stream_merge(DRAFT_EDGE_SORTER& sorter, DRAFT_EDGE_COUNT_PROC proc, void* user)
+{
+    //The edges in the buffer are the last run, kept in memory.
+    draft_stream_sort_edges(sorter, sorter.tail);
+    std::vector<uint64_t>().swap(sorter.edges);
+    std::vector<DRAFT_RUN_CURSOR> cursors(sorter.runs.size() + 1);
+    for (size_t i = 0; i < sorter.runs.size(); ++i)
+    {
+        DRAFT_RUN_CURSOR& cursor = cursors[i];
+        if (!bin_open(sorter.runs[i].c_str(), &cursor.run_file, "rb"))
+        {
+            time_error(-1, "Failed to open edge run file %s", sorter.runs[i].c_str());
+        }
+        fread(&cursor.remain, sizeof(uint64_t), 1, cursor.run_file);
+        cursor.pos = 0;
+    }
+    DRAFT_RUN_CURSOR& tail_cursor = cursors.back();
+    tail_cursor.run_file = NULL;
+    tail_cursor.remain = 0;
+    tail_cursor.buffer.swap(sorter.tail);
+    tail_cursor.pos = 0;
+    //Merge the runs with a min-heap of the run heads.
+    typedef std::pair<uint64_t, size_t> RUN_HEAD;
+    std::priority_queue<RUN_HEAD, std::vector<RUN_HEAD>, std::greater<RUN_HEAD> > heads;
+    for (size_t i = 0; i < cursors.size(); ++i)
+    {
+        if (draft_stream_cursor_fetch(cursors[i]))
+        {
+            heads.push(RUN_HEAD(cursors[i].buffer[cursors[i].pos].edge, i));
+        }
+    }
+    std::vector<DRAFT_EDGE_COUNT> merged;
+    merged.reserve(DRAFT_RUN_BUFFER_SIZE);
+    while (!heads.empty())
+    {
+        size_t run_id = heads.top().second;
+        DRAFT_RUN_CURSOR& cursor = cursors[run_id];
+        heads.pop();
+        const DRAFT_EDGE_COUNT& count = cursor.buffer[cursor.pos];
+        //Combine the counts of the same edge from different runs.
+        if (!merged.empty() && merged.back().edge == count.edge)
+        {
+            merged.back().count += count.count;
+        }
+        else
+        {
+            //A new edge comes, all the merged counts are complete.
+            if (merged.size() == DRAFT_RUN_BUFFER_SIZE)
+            {
+                proc(merged.data(), merged.size(), user);
+                merged.clear();
+            }
+            merged.push_back(count);
+        }
+        ++cursor.pos;
+        if (draft_stream_cursor_fetch(cursor))
+        {
+            heads.push(RUN_HEAD(cursor.buffer[cursor.pos].edge, run_id));
+        }
+    }
+    if (!merged.empty())
+    {
+        proc(merged.data(), merged.size(), user);
+    }
+    //Remove the run files.
+    for (size_t i = 0; i < sorter.runs.size(); ++i)
+    {
+        fclose(cursors[i].run_file);
+        remove(sorter.runs[i].c_str());
+    }
+    sorter.runs.clear();
+}
+
+void draft_stream_weight_flush(DRAFT_EDGE_WEIGHTS& weights)
+{
+    hmr_graph_undirected_edges_write(weights.edge_file, weights.buffer.data(), weights.buffer.size());
+    weights.edge_size += weights.buffer.size();
+    weights.buffer.clear();
+}
+
+void draft_stream_weight_proc(const DRAFT_EDGE_COUNT* counts, size_t count_size, void* user)
+{
+    DRAFT_EDGE_WEIGHTS* weights = static_cast<DRAFT_EDGE_WEIGHTS*>(user);
+    const HMR_NODES& nodes = *weights->nodes;
+    int32_t node_start, node_end;
+    for (size_t i = 0; i < count_size; ++i)
+    {
+        //Skip the edge.
+        int32_t edge_num_of_links = static_cast<int32_t>(counts[i].count);
+        if (edge_num_of_links < weights->min_links)
+        {
+            continue;
+        }
+        hmr_graph_edge_pos(counts[i].edge, node_start, node_end);
+        //Calculate the edge weights, count to the factors.
+        double edge_weights = static_cast<double>(weights->max_re_square * edge_num_of_links / nodes[node_start].enzyme_count / nodes[node_end].enzyme_count);
+        weights->buffer.emplace_back(HMR_UNDIRECTED_EDGE_INFO{ node_start, node_end, static_cast<uint64_t>(edge_num_of_links), { edge_weights, edge_weights } });
+        weights->node_factors[node_start] += edge_weights;
+        weights->node_factors[node_end] += edge_weights;
+        weights->links_average += edge_weights;
+        if (weights->buffer.size() >= DRAFT_RUN_BUFFER_SIZE)
+        {
+            draft_stream_weight_flush(*weights);
+        }
+    }
+}
+
+void draft_stream_edge_size_proc(uint64_t edge_size, void* user)
+{
+    //The weighted edges are written in the same order, the size is counted when writing.
+    (void)edge_size;
+    (void)user;
+}
+
+void draft_stream_adjust_proc(HMR_UNDIRECTED_EDGE_INFO* edges, int32_t edge_size, void* user)
+{
+    DRAFT_EDGE_WEIGHTS* weights = static_cast<DRAFT_EDGE_WEIGHTS*>(user);
+    //Based on the node factors, change the graph to directed-graph.
+    for (int32_t i = 0; i < edge_size; ++i)
+    {
+        auto& edge_info = edges[i];
+        edge_info.weights[0] = ceil(edge_info.weights[0] / weights->node_factors[edge_info.start]);
+        edge_info.weights[1] = ceil(edge_info.weights[1] / weights->node_factors[edge_info.end]);
+    }
+    hmr_graph_undirected_edges_write(weights->edge_file, edges, edge_size);
+    weights->edge_size += edge_size;
+}
@@ -0,0 +1,43 @@
+#ifndef DRAFT_STREAM_H
+#define DRAFT_STREAM_H
+
+#include <cstdio>
+#include <string>
+
+#include "draft_mappings_type.hpp"
+
+typedef struct DRAFT_EDGE_SORTER
+{
+    std::string run_prefix;
+    size_t capacity;
+    std::vector<uint64_t> edges;
+    std::vector<std::string> runs;
+    std::vector<DRAFT_EDGE_COUNT> tail;
+} DRAFT_EDGE_SORTER;
+
+typedef struct DRAFT_EDGE_WEIGHTS
+{
+    const HMR_NODES* nodes;
+    int32_t min_links;
+    int64_t max_re_square;
+    double* node_factors;
+    double links_average;
+    FILE* edge_file;
+    uint64_t edge_size;
+    std::vector<HMR_UNDIRECTED_EDGE_INFO> buffer;
+} DRAFT_EDGE_WEIGHTS;
+
+typedef void (*DRAFT_EDGE_COUNT_PROC)(const DRAFT_EDGE_COUNT* counts, size_t count_size, void* user);
+
+/* Edge sorter, the packed edges are radix sorted and spilled to run files when the buffer is full */
+void draft_stream_init(DRAFT_EDGE_SORTER& sorter, const char* run_prefix, size_t capacity);
+void draft_stream_sort_proc(HMR_MAPPING* mapping, int32_t buf_size, void* user);
+void draft_stream_merge(DRAFT_EDGE_SORTER& sorter, DRAFT_EDGE_COUNT_PROC proc, void* user);
+
+/* Edge weight passes */
+void draft_stream_weight_proc(const DRAFT_EDGE_COUNT* counts, size_t count_size, void* user);
+void draft_stream_weight_flush(DRAFT_EDGE_WEIGHTS& weights);
+void draft_stream_edge_size_proc(uint64_t edge_size, void* user);
+void draft_stream_adjust_proc(HMR_UNDIRECTED_EDGE_INFO* edges, int32_t edge_size, void* user);
+
+#endif // DRAFT_STREAM_H
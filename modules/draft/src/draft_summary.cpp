@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <cstring>
+
+#include "hmr_contig_graph.hpp"
+
+#include "draft_summary.hpp"
+
+void draft_summary_init(DRAFT_SUMMARY_BUILDER& builder, const HMR_NODES& nodes)
+{
+    builder.nodes = &nodes;
+    builder.summary.contigs.resize(nodes.size());
+    memset(builder.summary.contigs.data(), 0, sizeof(HMR_CONTIG_SUMMARY) * nodes.size());
+    builder.summary.pairs.clear();
+    builder.pair_index.clear();
+}
+
+inline int32_t draft_summary_distance_bin(int32_t pos, int32_t next_pos)
+{
+    uint32_t distance = static_cast<uint32_t>(pos > next_pos ? pos - next_pos : next_pos - pos) + 1;
+    int32_t bin = 0;
+    while (distance >>= 1)
+    {
+        ++bin;
+    }
+    return bin < HMR_DISTANCE_BINS ? bin : HMR_DISTANCE_BINS - 1;
+}
+
+inline int32_t draft_summary_end(const HMR_NODES& nodes, int32_t contig_id, int32_t pos)
+{
+    //The read is at the head end when it is in the first half of the contig.
+    return (static_cast<int64_t>(pos) << 1) < static_cast<int64_t>(nodes[contig_id].length) ? 0 : 1;
+}
+
+void draft_summary_proc(HMR_MAPPING* mapping, int32_t buf_size, void* user)
+{
+    DRAFT_SUMMARY_BUILDER* builder = static_cast<DRAFT_SUMMARY_BUILDER*>(user);
+    const HMR_NODES& nodes = *builder->nodes;
+    for (int32_t i = 0; i < buf_size; ++i)
+    {
+        const HMR_MAPPING& mapping_info = mapping[i];
+        if (mapping_info.refID == mapping_info.next_refID)
+        {
+            //Reads inside a contig only update the contig summary.
+            HMR_CONTIG_SUMMARY& contig = builder->summary.contigs[mapping_info.refID];
+            ++contig.count;
+            contig.pos_sum[0] += static_cast<uint64_t>(mapping_info.pos);
+            contig.pos_sum[1] += static_cast<uint64_t>(mapping_info.next_pos);
+            ++contig.distances[draft_summary_distance_bin(mapping_info.pos, mapping_info.next_pos)];
+            continue;
+        }
+        //Find the pair record, the smaller contig id is the first.
+        uint64_t edge = hmr_graph_edge_data(mapping_info.refID, mapping_info.next_refID);
+        auto pair_iter = builder->pair_index.find(edge);
+        if (pair_iter == builder->pair_index.end())
+        {
+            HMR_PAIR_SUMMARY pair;
+            memset(&pair, 0, sizeof(HMR_PAIR_SUMMARY));
+            hmr_graph_edge_pos(edge, pair.first, pair.second);
+            pair_iter = builder->pair_index.insert(std::make_pair(edge, builder->summary.pairs.size())).first;
+            builder->summary.pairs.push_back(pair);
+        }
+        HMR_PAIR_SUMMARY& pair = builder->summary.pairs[pair_iter->second];
+        int32_t pos_first = mapping_info.pos, pos_second = mapping_info.next_pos;
+        if (mapping_info.refID != pair.first)
+        {
+            std::swap(pos_first, pos_second);
+        }
+        ++pair.count;
+        pair.pos_sum[0] += static_cast<uint64_t>(pos_first);
+        pair.pos_sum[1] += static_cast<uint64_t>(pos_second);
+        ++pair.ends[(draft_summary_end(nodes, pair.first, pos_first) << 1) | draft_summary_end(nodes, pair.second, pos_second)];
+    }
+}
+
+void draft_summary_finish(DRAFT_SUMMARY_BUILDER& builder)
+{
+    //The pair index is no longer needed, keep the pairs in the order of the edge file.
+    std::unordered_map<uint64_t, size_t>().swap(builder.pair_index);
+    std::sort(builder.summary.pairs.begin(), builder.summary.pairs.end(),
+              [](const HMR_PAIR_SUMMARY& lhs, const HMR_PAIR_SUMMARY& rhs)
+    {
+        return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+    });
+}
@@ -0,0 +1,18 @@
+#ifndef DRAFT_SUMMARY_H
+#define DRAFT_SUMMARY_H
+
+#include "hmr_contig_graph_type.hpp"
+
+typedef struct DRAFT_SUMMARY_BUILDER
+{
+    const HMR_NODES* nodes;
+    HMR_READS_SUMMARY summary;
+    std::unordered_map<uint64_t, size_t> pair_index; // Packed contig pair to its index in the summary pairs.
+} DRAFT_SUMMARY_BUILDER;
+
+/* Paired-reads summary, collected in the same reads pass as the edge sorter */
+void draft_summary_init(DRAFT_SUMMARY_BUILDER& builder, const HMR_NODES& nodes);
+void draft_summary_proc(HMR_MAPPING* mapping, int32_t buf_size, void* user);
+void draft_summary_finish(DRAFT_SUMMARY_BUILDER& builder);
+
+#endif // DRAFT_SUMMARY_H
@@ -7,10 +7,13 @@
 #include "hmr_contig_graph.hpp"
 #include "hmr_global.hpp"
 #include "hmr_path.hpp"
+#include "hmr_stats.hpp"
 #include "hmr_ui.hpp"
 
 #include "args_draft.hpp"
 #include "draft_mappings.hpp"
+#include "draft_stream.hpp"
+#include "draft_summary.hpp"
 
 extern HMR_ARGS opts;
 
@@ -18,6 +21,7 @@ int main(int argc, char* argv[])
 {
     //Parse the arguments.
     parse_arguments(argc, argv);
+    if (opts.stats) { hmr_stats_enable("hana_draft", opts.stats); }
     //Check the arguments are meet the requirements.
     if (!opts.nodes) { help_exit(-1, "Missing HMR graph contig information file path."); }
     if (!path_can_read(opts.nodes)) { time_error(-1, "Cannot read HMR graph contig file %s", opts.nodes); }
@@ -31,6 +35,9 @@ int main(int argc, char* argv[])
     time_print("\tMinimum RE sites: %d", opts.min_re);
     time_print("\tMaximum link density: %.2lf", opts.max_density);
     time_print("\tPaired-reads buffer: %dK", opts.read_buffer_size);
+    time_print("\tEdge sorting memory: %dM", opts.sort_memory);
+    time_print("\tThreads: %d", opts.threads);
+    time_print("\tPaired-reads summary: %s", opts.summary ? "Yes" : "No");
     opts.read_buffer_size <<= 10;
     //Load the contig node information.
     HMR_NODES nodes;
@@ -52,206 +59,141 @@ int main(int argc, char* argv[])
         max_enzyme_count = hMax(max_enzyme_count, nodes[i].enzyme_count);
     }
     time_print("Maximum enzyme counts in contigs: %d", max_enzyme_count);
-    //Read through the reads file, calculate the pairs.
+    //Read through the reads file, sort the pairs to edge runs.
     time_print("Reading paired-reads from %s", opts.reads);
-    HMR_EDGE_COUNTERS edges;
-    std::vector<double> node_factors;
-    
-        EDGE_COUNTER edge_pairs;
-        //Load the allele table when necessary.
-        if (allele_mode)
+    std::string edge_path = hmr_graph_path_edge(opts.output);
+    DRAFT_EDGE_SORTER sorter;
+    draft_stream_init(sorter, edge_path.c_str(), (static_cast<size_t>(opts.sort_memory) << 20) / (sizeof(uint64_t) * 2 + sizeof(DRAFT_EDGE_COUNT)));
+    //The summary is collected in the same pass, the later stages load it instead of the reads.
+    std::vector<HMR_READS_CONSUMER> consumers;
+    consumers.push_back(HMR_READS_CONSUMER{ draft_stream_sort_proc, &sorter });
+    DRAFT_SUMMARY_BUILDER summary_builder;
+    if (opts.summary)
+    {
+        draft_summary_init(summary_builder, nodes);
+        consumers.push_back(HMR_READS_CONSUMER{ draft_summary_proc, &summary_builder });
+    }
+    {
+        HMR_STATS_SCOPE sort_scope("draft.read_sort");
+        hmr_graph_load_reads_multi(opts.reads, opts.read_buffer_size, consumers);
+    }
+    hmr_stats_count("draft.edge_runs", sorter.runs.size());
+    time_print("Paired-reads have been sorted, %zu edge run(s) spilled.", sorter.runs.size());
+    if (opts.summary)
+    {
+        draft_summary_finish(summary_builder);
+        std::string summary_path = hmr_graph_path_reads_summary(opts.output);
+        time_print("Saving %zu contig pair summaries to %s", summary_builder.summary.pairs.size(), summary_path.c_str());
+        hmr_graph_save_reads_summary(summary_path.c_str(), summary_builder.summary);
+        summary_builder.summary = HMR_READS_SUMMARY();
+    }
+    //Calculate the edge weights, the weighted edges are saved to a temporary edge file.
+    std::vector<double> node_factors(num_of_contigs, 0.0);
+    std::string weight_path = edge_path + ".tmp";
+    DRAFT_EDGE_WEIGHTS weights;
+    weights.nodes = &nodes;
+    weights.min_links = opts.min_links;
+    weights.max_re_square = hSquare(static_cast<int64_t>(max_enzyme_count));
+    weights.node_factors = node_factors.data();
+    weights.links_average = 0.0;
+    weights.edge_size = 0;
+    hmr_graph_undirected_edges_open(weight_path.c_str(), &weights.edge_file);
+    time_print("Removing edges failed to reach the minimum links...");
+    time_print("Calculating the node repetitive factors...");
+    double weight_start = hmr_stats_now();
+    //Load the allele table when necessary.
+    if (allele_mode)
+    {
+        //First build the edge counter map.
+        EDGE_COUNT_MAP edge_pair_map;
+        edge_pair_map.resize(nodes.size());
+        draft_stream_merge(sorter, draft_mappings_build_edge_map, &edge_pair_map);
+        time_print("Paired-reads map has been built.");
+        //Read the allele table.
+        HMR_CONTIG_ID_TABLE allele_table;
+        time_print("Loading allele table from %s", opts.allele_table);
+        hmr_graph_load_contig_table(opts.allele_table, allele_table);
+        time_print("%zu allele record(s) loaded.", allele_table.size());
+        //Loop through the allele table, remove the edge pairs.
+        time_print("Removing allele edges...");
+        draft_mappings_remove_allele_edges(edge_pair_map, allele_table, opts.threads);
+        time_print("Converting the node<->node map to sorted edges...");
+        //Convert the map to sorted edge counts.
+        std::vector<DRAFT_EDGE_COUNT> edge_counts;
+        for (int32_t node_start = 0, node_size = static_cast<int32_t>(edge_pair_map.size()); node_start < node_size; ++node_start)
         {
-            //First build the edge counter map.
-            EDGE_COUNT_MAP edge_pair_map;
-            edge_pair_map.resize(nodes.size());
-            hmr_graph_load_reads(opts.reads, opts.read_buffer_size, draft_mappings_build_edge_counter, &edge_pair_map);
-            time_print("Paired-reads map has been built.");
-            //Read the allele table.
-            HMR_CONTIG_ID_TABLE allele_table;
-            time_print("Loading allele table from %s", opts.allele_table);
-            hmr_graph_load_contig_table(opts.allele_table, allele_table);
-            time_print("%zu allele record(s) loaded.", allele_table.size());
-            //Loop through the allele table, remove the edge pairs.
-            time_print("Removing allele edges...");
-            //Remove the inter-connected edges inside a row.
-            for(auto &conflict_row: allele_table)
-            {
-                int32_t row_size = static_cast<int32_t>(conflict_row.size());
-                if(row_size < 2)
-                {
-                    continue;
-                }
-                //Sort the row for better operation.
-                //Remove the record inter-connected edges.
-                for(int32_t i=0; i<row_size-1; ++i)
-                {
-                    for(int32_t j=i+1; j<row_size; ++j)
-                    {
-                        draft_mappings_remove_edge(edge_pair_map, conflict_row[i], conflict_row[j]);
-                    }
-                }
-            }
-            //For edges between rows, leave only the strongest connected edges.
-            size_t num_of_allele_rows = allele_table.size();
-            for(size_t i=0; i<num_of_allele_rows - 1; ++i)
+            for(auto &end_iter: edge_pair_map[node_start])
             {
-                for(size_t j=i+1; j<num_of_allele_rows; ++j)
+                //Only add the edge once.
+                if(node_start < end_iter.first)
                 {
-                    //Copy two allele row.
-                    HMR_CONTIG_ID_VEC row_i(allele_table[i]), row_j(allele_table[j]);
-                    //Only care about the different contigs.
-                    hmr_remove_common(row_i, row_j);
-                    //We want to find the maximum paired edges between these two rows.
-                    //And only one contig is matching the other.
-                    std::deque<HMR_EDGE_INFO> edge_list;
-                    for(const int32_t contig_i: row_i)
-                    {
-                        NODE_COUNT_MAP& contig_i_map = edge_pair_map[contig_i];
-                        if(contig_i_map.empty())
-                        {
-                            continue;
-                        }
-                        for(const int32_t contig_j: row_j)
-                        {
-                            auto iter_j = contig_i_map.find(contig_j);
-                            if(iter_j == contig_i_map.end())
-                            {
-                                continue;
-                            }
-                            edge_list.push_back(HMR_EDGE_INFO{contig_i, contig_j, static_cast<uint64_t>(iter_j->second), 0.0});
-                        }
-                    }
-                    //If there is no edges for these two rows, we don't care about that.
-                    if(edge_list.empty())
-                    {
-                        continue;
-                    }
-                    std::vector<HMR_EDGE_INFO> edges;
-                    hDequeListToVector(edge_list, edges);
-                    std::sort(edges.begin(), edges.end(),
-                              [](const HMR_EDGE_INFO &lhs, const HMR_EDGE_INFO &rhs)
-                    {
-                        return lhs.pairs > rhs.pairs;
-                    });
-                    //Pick out the first edges, check whether these two contigs are still in the row.
-                    //If not, remove the edge.
-                    for(const HMR_EDGE_INFO &edge: edges)
-                    {
-                        if(!hmr_in_ordered_vector(edge.start, row_i) ||
-                                !hmr_in_ordered_vector(edge.end, row_j))
-                        {
-                            //Remove the edge.
-                            draft_mappings_remove_edge(edge_pair_map, edge.start, edge.end);
-                            continue;
-                        }
-                        //Or else, we found an edge that is valid, remove the contig from the vector.
-                        hmr_remove_one(row_i, edge.start);
-                        hmr_remove_one(row_j, edge.end);
-                    }
+                    edge_counts.push_back(DRAFT_EDGE_COUNT{ hmr_graph_edge_data(node_start, end_iter.first), static_cast<uint64_t>(end_iter.second) });
                 }
             }
-            time_print("Converting the node<->node map to edge pair maps...");
-            //Convert the map to edge pairs.
-            for (int32_t node_start = 0, node_size = static_cast<int32_t>(edge_pair_map.size()); node_start < node_size; ++node_start)
-            {
-                for(auto &end_iter: edge_pair_map[node_start])
-                {
-                    HMR_EDGE edge = hmr_graph_edge(node_start, end_iter.first);
-                    //Only add the edge that is not existed before.
-                    if(edge_pairs.find(edge.data) == edge_pairs.end())
-                    {
-                        edge_pairs.insert(std::make_pair(edge.data, end_iter.second));
-                    }
-                }
-            }
-            time_print("%zu edges remain.", edge_pairs.size());
-        }
-        else
-        {
-            //Directly build the edge counter.
-            hmr_graph_load_reads(opts.reads, opts.read_buffer_size, draft_mappings_build_edges, &edge_pairs);
-            time_print("Paired-reads have been counted, %zu edge(s) generated.", edge_pairs.size());
-        }
-        //Filter out the valid links.
-        time_print("Removing edges failed to reach the minimum links...");
-        time_print("Calculating the node repetitive factors...");
-        edges.reserve(edge_pairs.size());
-        node_factors.resize(num_of_contigs);
-        for (int32_t i = 0; i < num_of_contigs; ++i)
-        {
-            node_factors[i] = 0.0;
         }
-        double links_average = 0.0;
-        int64_t max_re_square = hSquare(static_cast<int64_t>(max_enzyme_count));
-        int32_t node_start, node_end;
-        for (const auto& iter : edge_pairs)
+        std::sort(edge_counts.begin(), edge_counts.end(),
+                  [](const DRAFT_EDGE_COUNT &lhs, const DRAFT_EDGE_COUNT &rhs)
         {
-            //Create the edge, count to the factors.
-            hmr_graph_edge_pos(iter.first, node_start, node_end);
-            //Skip the edge.
-            int32_t edge_num_of_links = iter.second;
-            if (edge_num_of_links < opts.min_links)
-            {
-                continue;
-            }
-            // Calculat the edge weights..
-            double edge_weights = static_cast<double>(max_re_square * edge_num_of_links / nodes[node_start].enzyme_count / nodes[node_end].enzyme_count);
-            edges.emplace_back(HMR_EDGE_INFO{ node_start, node_end, static_cast<uint64_t>(edge_num_of_links), edge_weights });
-            edges.emplace_back(HMR_EDGE_INFO{ node_end, node_start, static_cast<uint64_t>(edge_num_of_links), edge_weights });
-            node_factors[node_start] += edge_weights;
-            node_factors[node_end] += edge_weights;
-            links_average += edge_weights;
-        }
-        //Calculate the links average.
-        links_average = 2.0 * links_average / static_cast<double>(num_of_contigs);
-        time_print("%zu edge(s) generated, average links = %.2lf", edges.size(), links_average);
-        time_print("Skip contig(s) with maximum multiplicity...");
+            return lhs.edge < rhs.edge;
+        });
+        time_print("%zu edges remain.", edge_counts.size());
+        draft_stream_weight_proc(edge_counts.data(), edge_counts.size(), &weights);
+    }
+    else
+    {
+        //Directly merge the sorted edge runs.
+        draft_stream_merge(sorter, draft_stream_weight_proc, &weights);
+    }
+    draft_stream_weight_flush(weights);
+    hmr_stats_stage("draft.weight", weight_start);
+    hmr_graph_undirected_edges_close(weights.edge_file, weights.edge_size);
+    //Calculate the links average.
+    double links_average = 2.0 * weights.links_average / static_cast<double>(num_of_contigs);
+    time_print("%zu edge(s) generated, average links = %.2lf", static_cast<size_t>(weights.edge_size), links_average);
+    time_print("Skip contig(s) with maximum multiplicity...");
+    //Calculate the node factors.
+    int32_t invalid_counter = 0;
+    for (int32_t i = 0; i < num_of_contigs; ++i)
+    {
         //Calculate the node factors.
-        int32_t invalid_counter = 0;
-        for (int32_t i = 0; i < num_of_contigs; ++i)
-        {
-            //Calculate the node factors.
-            node_factors[i] /= links_average;
-            //Check whether the node factors is valid or not.
-            contig_invalid[i] |= (node_factors[i] >= opts.max_density);
-            if (contig_invalid[i])
-            {
-                ++invalid_counter;
-            }
-        }
-        //Extract invalid node vector.
-        HMR_CONTIG_ID_VEC invalid_nodes;
-        invalid_nodes.reserve(invalid_counter);
-        for (int32_t i = 0; i < num_of_contigs; ++i)
+        node_factors[i] /= links_average;
+        //Check whether the node factors is valid or not.
+        contig_invalid[i] |= (node_factors[i] >= opts.max_density);
+        if (contig_invalid[i])
         {
-            if (contig_invalid[i])
-            {
-                invalid_nodes.emplace_back(i);
-            }
+            ++invalid_counter;
         }
-        //Loop for all the edges, update their weights.
-        time_print("%zu node(s) are skipped.", invalid_nodes.size());
-        if (!invalid_nodes.empty())
+    }
+    //Extract invalid node vector.
+    HMR_CONTIG_ID_VEC invalid_nodes;
+    invalid_nodes.reserve(invalid_counter);
+    for (int32_t i = 0; i < num_of_contigs; ++i)
+    {
+        if (contig_invalid[i])
         {
-            //Write the skipped nodes.
-            std::string invalid_node_path = hmr_graph_path_contigs_invalid(opts.output);
-            time_print("Saving invalid contig ids to %s", invalid_node_path.c_str());
-            hmr_graph_save_contig_ids(invalid_node_path.c_str(), invalid_nodes);
-            time_print("Done");
+            invalid_nodes.emplace_back(i);
         }
-
-    //Based on the node factors, change the graph to directed-graph.
-    time_print("Adjust link densities by repetitive factors...");
-    for (size_t i = 0; i < edges.size(); ++i)
+    }
+    //Loop for all the edges, update their weights.
+    time_print("%zu node(s) are skipped.", invalid_nodes.size());
+    if (!invalid_nodes.empty())
     {
-        auto& edge_info = edges[i];
-        edge_info.weights = ceil(edge_info.weights / node_factors[edge_info.start]);
+        //Write the skipped nodes.
+        std::string invalid_node_path = hmr_graph_path_contigs_invalid(opts.output);
+        time_print("Saving invalid contig ids to %s", invalid_node_path.c_str());
+        hmr_graph_save_contig_ids(invalid_node_path.c_str(), invalid_nodes);
+        time_print("Done");
     }
-    time_print("%zu edge(s) generated.", edges.size());
-    //Write the edge information to the target file.
-    std::string edge_path = hmr_graph_path_edge(opts.output);
+    //Based on the node factors, stream the weighted edges to the edge file.
+    time_print("Adjust link densities by repetitive factors...");
     time_print("Saving edge information to %s", edge_path.c_str());
-    hmr_graph_save_edges(edge_path.c_str(), edges);
+    hmr_graph_undirected_edges_open(edge_path.c_str(), &weights.edge_file);
+    weights.edge_size = 0;
+    HMR_STATS_SCOPE adjust_scope("draft.adjust");
+    hmr_graph_load_undirected_edges(weight_path.c_str(), opts.read_buffer_size, draft_stream_edge_size_proc, draft_stream_adjust_proc, &weights);
+    hmr_graph_undirected_edges_close(weights.edge_file, weights.edge_size);
+    remove(weight_path.c_str());
+    time_print("%zu undirected edge(s) generated.", static_cast<size_t>(weights.edge_size));
     time_print("Draft complete.");
     return 0;
 }
@@ -18,6 +18,7 @@ SOURCES += \
     ../shared/hmr_contig_graph.cpp \
     ../shared/hmr_gz.cpp \
     ../shared/hmr_path.cpp \
+    ../shared/hmr_stats.cpp \
     ../shared/hmr_text_file.cpp \
     ../shared/hmr_ui.cpp \
     src/args_dump.cpp \
@@ -35,6 +36,8 @@ HEADERS += \
     ../shared/hmr_contig_graph_type.hpp \
     ../shared/hmr_gz.hpp \
     ../shared/hmr_path.hpp \
+    ../shared/hmr_stats.hpp \
+    ../shared/hmr_task_scheduler.hpp \
     ../shared/hmr_text_file.hpp \
     ../shared/hmr_ui.hpp \
     src\args_dump.hpp \
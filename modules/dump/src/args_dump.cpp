@@ -9,4 +9,5 @@ HMR_ARGS opts;
 HMR_ARG_PARSER args_parser = {
     { {"-n", "--nodes"}, "NODES", "HMR Nodes file (.hmr_nodes)", LAMBDA_PARSE_ARG {opts.nodes = arg[0]; }},
     { {"-o", "--output"}, "OUTPUT", "Output path", LAMBDA_PARSE_ARG {opts.output = arg[0]; }},
+    { {"--stats"}, "STATS", "Save the stage timings, counters and peak memory as JSON", LAMBDA_PARSE_ARG {opts.stats = arg[0]; }},
 };
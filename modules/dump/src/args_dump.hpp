@@ -10,6 +10,7 @@ typedef struct HMR_ARGS
     const char* output = NULL;
     const char* nodes = NULL;
     const char* allele = NULL;
+    const char* stats = NULL;
 } HMR_ARGS;
 
 #endif // ARGS_DUMP_H
@@ -4,6 +4,7 @@
 #include "hmr_text_file.hpp"
 #include "hmr_contig_graph.hpp"
 #include "hmr_args.hpp"
+#include "hmr_stats.hpp"
 #include "hmr_ui.hpp"
 #include "hmr_bam.hpp"
 
@@ -47,6 +48,7 @@ int dump_bam(int argc, char* argv[])
     }
     //Read the arguments.
     parse_arguments(argc - 1, argv + 1);
+    if (opts.stats) { hmr_stats_enable("hana_dump", opts.stats); }
     //Get the bam file path.
     const char* filepath = argv[1];
     if (!path_can_read(filepath))
@@ -94,6 +96,7 @@ int dump_reads(int argc, char* argv[])
     }
     //Read the arguments.
     parse_arguments(argc - 1, argv + 1);
+    if (opts.stats) { hmr_stats_enable("hana_dump", opts.stats); }
     //Get the bam file path.
     const char* filepath = argv[1];
     if (!path_can_read(filepath))
@@ -142,6 +145,17 @@ void dump_edges_proc(HMR_EDGE_INFO* edges, int32_t edge_size, void* user)
     }
 }
 
+void dump_undirected_edges_proc(HMR_UNDIRECTED_EDGE_INFO* edges, int32_t edge_size, void* user)
+{
+    DUMP_READS *d = static_cast<DUMP_READS*>(user);
+    for(int32_t i=0; i<edge_size; ++i)
+    {
+        fprintf(d->file, "%s\t%s\t%lu\t%lf\t%lf\n",
+                d->node_infos.names[edges[i].start].name, d->node_infos.names[edges[i].end].name,
+                edges[i].pairs, edges[i].weights[0], edges[i].weights[1]);
+    }
+}
+
 int dump_edges(int argc, char* argv[])
 {
     if (argc < 2)
@@ -150,6 +164,7 @@ int dump_edges(int argc, char* argv[])
     }
     //Read the arguments.
     parse_arguments(argc - 1, argv + 1);
+    if (opts.stats) { hmr_stats_enable("hana_dump", opts.stats); }
     //Get the bam file path.
     const char* filepath = argv[1];
     if (!path_can_read(filepath))
@@ -178,7 +193,14 @@ int dump_edges(int argc, char* argv[])
     user.file = dump_file;
     hmr_graph_load_contigs(opts.nodes, user.node_infos.contigs, &user.node_infos.names);
     //Load the edges.
-    hmr_graph_load_edges(filepath, 512 << 10, dump_edges_size_proc, dump_edges_proc, &user);
+    if (hmr_graph_edges_is_undirected(filepath))
+    {
+        hmr_graph_load_undirected_edges(filepath, 512 << 10, dump_edges_size_proc, dump_undirected_edges_proc, &user);
+    }
+    else
+    {
+        hmr_graph_load_edges(filepath, 512 << 10, dump_edges_size_proc, dump_edges_proc, &user);
+    }
     fclose(dump_file);
     return 0;
 }
@@ -225,6 +247,7 @@ int dump_group(int argc, char* argv[])
     }
     //Read the arguments.
     parse_arguments(argc - 1, argv + 1);
+    if (opts.stats) { hmr_stats_enable("hana_dump", opts.stats); }
     //Get the bam file path.
     const char* filepath = argv[1];
     if (!path_can_read(filepath))
@@ -271,6 +294,7 @@ int dump_allele_table(int argc, char* argv[])
     }
     //Read the arguments.
     parse_arguments(argc - 1, argv + 1);
+    if (opts.stats) { hmr_stats_enable("hana_dump", opts.stats); }
     //Get the bam file path.
     const char* filepath = argv[1];
     if (!path_can_read(filepath))
@@ -320,6 +344,7 @@ int dump_chromo(int argc, char* argv[])
     }
     //Read the arguments.
     parse_arguments(argc - 1, argv + 1);
+    if (opts.stats) { hmr_stats_enable("hana_dump", opts.stats); }
     //Get the bam file path.
     const char* filepath = argv[1];
     if (!path_can_read(filepath))
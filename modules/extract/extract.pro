@@ -23,6 +23,7 @@ SOURCES += \
     ../shared/hmr_pairs.cpp \
     ../shared/hmr_path.cpp \
     ../shared/hmr_seq.cpp \
+    ../shared/hmr_stats.cpp \
     ../shared/hmr_text_file.cpp \
     ../shared/hmr_ui.cpp \
     src/args_extract.cpp \
@@ -50,8 +51,9 @@ HEADERS += \
     ../shared/hmr_pairs.hpp \
     ../shared/hmr_path.hpp \
     ../shared/hmr_seq.hpp \
+    ../shared/hmr_stats.hpp \
     ../shared/hmr_text_file.hpp \
-    ../shared/hmr_thread_pool.hpp \
+    ../shared/hmr_task_scheduler.hpp \
     ../shared/hmr_ui.hpp \
     src/args_extract.hpp \
     src/extract_allele.hpp \
@@ -21,4 +21,5 @@ HMR_ARG_PARSER args_parser = {
     { {"--mapping-buffer"}, "MAP_BUF_SIZE", "Mapping parse buffer size (unit: K, default: 512)", LAMBDA_PARSE_ARG { opts.mapping_pool = atoi(arg[0]); }},
     { {"--no-flag"}, "", "Skip the flag checking", LAMBDA_PARSE_ARG { (void)arg; opts.skip_flag = true; }},
     { {"--no-range"}, "", "Skip the enzyme range checking", LAMBDA_PARSE_ARG { (void)arg; opts.skip_range = true; }},
+    { {"--stats"}, "STATS", "Save the stage timings, counters and peak memory as JSON", LAMBDA_PARSE_ARG {opts.stats = arg[0]; }},
 };
@@ -9,6 +9,7 @@ typedef struct HMR_ARGS
     const char* fasta = NULL;
     const char* output = NULL;
     const char* allele = NULL;
+    const char* stats = NULL;
     std::vector<char*> mappings;
     std::vector<char*> enzyme, weight_enzyme;
     int mapq = 40, threads = 1, range = 500, fasta_pool = 32, mapping_pool = 512, pairs_read_len = 150;
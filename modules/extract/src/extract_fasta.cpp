@@ -146,8 +146,9 @@ void extract_fasta_search_proc(int32_t, char* name, size_t name_size, char* seq,
     int32_t contig_id = static_cast<int32_t>(node_user->nodes.size());
     node_user->nodes.push_back(HMR_NODE{ static_cast<int32_t>(seq_size), -1 });
     node_user->node_names.push_back(HMR_NODE_NAME{ static_cast<int32_t>(name_size), name });
-    //Start to search the enzyme.
-    node_user->pool.push_task(ENZYME_RANGE_SEARCH
+    //Limit the sequences waiting for searching, then start to search the enzyme.
+    node_user->search_group.wait_below(node_user->search_depth);
+    ENZYME_RANGE_SEARCH search
         {
             node_user->init_search_range,
             node_user->init_search_calc,
@@ -156,5 +157,6 @@ void extract_fasta_search_proc(int32_t, char* name, size_t name_size, char* seq,
             node_user->half_range, 
             contig_id, 
             &(node_user->results)
-        });
+        };
+    node_user->search_group.run([search] { contig_range_search(search); });
 }
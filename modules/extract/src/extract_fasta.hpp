@@ -4,8 +4,8 @@
 #include <deque>
 
 #include "hmr_contig_graph_type.hpp"
-#include "hmr_thread_pool.hpp"
 #include "hmr_enzyme.hpp"
+#include "hmr_task_scheduler.hpp"
 
 #include "extract_fasta_type.hpp"
 
@@ -43,7 +43,6 @@ typedef struct ENZYME_RANGE_SEARCH
 } ENZYME_RANGE_SEARCH;
 
 void contig_range_search(const ENZYME_RANGE_SEARCH& param);
-typedef hmr::thread_pool<ENZYME_RANGE_SEARCH> RANGE_SEARCH_POOL;
 
 typedef std::deque<HMR_NODE> CONTIG_CHAIN;
 typedef std::deque<HMR_NODE_NAME> CONTIG_NAME_CHAIN;
@@ -54,7 +53,8 @@ typedef struct EXTRACT_FASTA_USER
     const CANDIDATE_ENZYMES& init_search_calc;
     CONTIG_CHAIN& nodes;
     CONTIG_NAME_CHAIN& node_names;
-    RANGE_SEARCH_POOL& pool;
+    hmr::task_group& search_group;
+    const int64_t search_depth;
     const int32_t half_range;
     CONTIG_RANGE_RESULTS& results;
 } EXTRACT_FASTA_USER;
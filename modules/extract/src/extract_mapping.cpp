@@ -1,12 +1,12 @@
 #include <cassert>
 #include <cstdlib>
-#include <thread>
 #include <mutex>
 
 #include "hmr_global.hpp"
 #include "hmr_bam.hpp"
 #include "hmr_pairs.hpp"
 #include "hmr_path.hpp"
+#include "hmr_stats.hpp"
 #include "hmr_ui.hpp"
 
 #include "extract_mapping.hpp"
@@ -84,6 +84,7 @@ inline void worker_init(MAPPING_WORKER& worker, int32_t worker_index, int32_t bu
     mapping_buffer_init(worker.valid_buffer, buffer_size);
     worker.start_pos = worker_index * buffer_size;
     worker.end_pos = worker.start_pos + buffer_size;
+    worker.counter = 0;
 }
 
 inline void worker_free(MAPPING_WORKER& worker)
@@ -94,25 +95,17 @@ inline void worker_free(MAPPING_WORKER& worker)
 inline void mapping_worker_sync_init(MAPPING_WORKER_SYNC& worker_sync, FILE *reads_file, int32_t num_of_worker)
 {
     worker_sync.reads_file = reads_file;
-    worker_sync.completed_worker = num_of_worker;
-    worker_sync.exit = false;
     worker_sync.total_worker = num_of_worker;
-    worker_sync.start_signal = new bool[num_of_worker];
-    for (int32_t i = 0; i < num_of_worker; ++i)
-    {
-        worker_sync.start_signal[i] = false;
-    }
-    worker_sync.start_mutex = new std::mutex[num_of_worker];
-    worker_sync.start_cv = new std::condition_variable[num_of_worker];
+    worker_sync.scheduler = new hmr::task_scheduler(num_of_worker);
+    worker_sync.filter_group = new hmr::task_group(*worker_sync.scheduler);
 }
 
 inline void mapping_worker_sync_start(MAPPING_WORKER_SYNC& worker_sync)
 {
-    worker_sync.completed_worker = 0;
+    //Each worker range of the filtering buffer is a task, the reader keeps filling the other buffer.
     for (int32_t i = 0; i < worker_sync.total_worker; ++i)
     {
-        worker_sync.start_signal[i] = true;
-        worker_sync.start_cv[i].notify_one();
+        worker_sync.filter_group->run([&worker_sync, i] { worker_sync.filter(i); });
     }
 }
 
@@ -125,44 +118,15 @@ inline void mapping_worker_sync_dump(MAPPING_WORKER_SYNC& worker_sync, MAPPING_B
 
 inline void mapping_worker_sync_wait_ready(MAPPING_WORKER_SYNC& worker_sync)
 {
-    if (worker_sync.completed_worker != worker_sync.total_worker)
-    {
-        std::unique_lock<std::mutex> lock(worker_sync.complete_mutex);
-        worker_sync.complete_cv.wait(lock, [&] {return worker_sync.completed_worker == worker_sync.total_worker; });
-    }
-}
-
-inline void mapping_worker_sync_complete_one(MAPPING_WORKER_SYNC& worker_sync)
-{
-    worker_sync.complete_mutex.lock();
-    ++worker_sync.completed_worker;
-    if (worker_sync.completed_worker == worker_sync.total_worker)
-    {
-        worker_sync.complete_cv.notify_one();
-    }
-    worker_sync.complete_mutex.unlock();
-}
-
-inline void mapping_worker_sync_exit(MAPPING_WORKER_SYNC& worker_sync, std::thread* workers)
-{
-    //Wait for all the workers are complete their work.
-    mapping_worker_sync_wait_ready(worker_sync);
-    //Set the exit signal.
-    worker_sync.exit = true;
-    for (int32_t i = 0; i < worker_sync.total_worker; ++i)
-    {
-        //Set the start signal.
-        worker_sync.start_signal[i] = true;
-        //Let the worker start.
-        worker_sync.start_cv[i].notify_one();
-        //Wait for the worker done.
-        workers[i].join();
-    }
+    //The reader waits for the filter workers.
+    HMR_STATS_SCOPE wait_scope("extract.filter_wait");
+    worker_sync.filter_group->wait();
 }
 
 inline void mapping_worker_sync_free(MAPPING_WORKER_SYNC& worker_sync)
 {
-    delete[] worker_sync.start_signal;
+    delete worker_sync.filter_group;
+    delete worker_sync.scheduler;
 }
 
 // ------ BAM Workers ------
@@ -247,46 +211,34 @@ void bam_extractor_free(BAM_EXTRACTOR& extractor)
     mapping_worker_sync_free(extractor.sync);
 }
 
-void extract_mapping_bam_worker(int32_t id, MAPPING_WORKER &worker, BAM_EXTRACTOR &extractor)
+void extract_mapping_bam_worker(MAPPING_WORKER &worker, BAM_EXTRACTOR &extractor)
 {
-    MAPPING_WORKER_SYNC& sync = extractor.sync;
-    std::unique_lock<std::mutex> lock(sync.start_mutex[id]);
-    while (!sync.exit)
+    uint64_t valid_reads = 0;
+    //Loop in the worker area.
+    BAM_MAPPING_BUFFER* filtering_buf = extractor.buf_filtering;
+    for (int32_t i = worker.start_pos; i < worker.end_pos; ++i)
     {
-        //Wait for the start signal.
-        sync.start_cv[id].wait(lock, [&] {return sync.start_signal[id]; });
-        if (sync.exit)
+        BAM_MAPPING_INFO& mapping_info = filtering_buf->buffer[i];
+        //Check whether the mapping info is valid, then check whether the position is in range.
+        int32_t ref_index = bam_extractor_get_contig_id(extractor, mapping_info.refID),
+            next_ref_index = bam_extractor_get_contig_id(extractor, mapping_info.next_refID);
+        if (!extract_bam_mapping_valid(ref_index, next_ref_index, mapping_info.mapq, mapping_info.flag, extractor.mapq, extractor.check_flag)
+            || ((extractor.check_flag & CHECK_FLAG_RANGE) && (!range_in_range(mapping_info.pos, mapping_info.l_seq, (*extractor.contig_enzyme_ranges)[ref_index])))) // Or the position is not in the position.
         {
-            return;
+            continue;
         }
-        //Loop in the worker area.
-        BAM_MAPPING_BUFFER* filtering_buf = extractor.buf_filtering;
-        for (int32_t i = worker.start_pos; i < worker.end_pos; ++i)
+        //Save the mapping info to the buffer.
+        if (mapping_buffer_is_full(worker.valid_buffer))
         {
-            BAM_MAPPING_INFO& mapping_info = filtering_buf->buffer[i];
-            //Check whether the mapping info is valid, then check whether the position is in range.
-            int32_t ref_index = bam_extractor_get_contig_id(extractor, mapping_info.refID),
-                next_ref_index = bam_extractor_get_contig_id(extractor, mapping_info.next_refID);
-            if (ref_index == -1 || next_ref_index == -1 //Reference index cannot be find in the mapping index detection.
-                || mapping_info.mapq == 0 || mapping_info.mapq == 255 //Map quality is invalid.
-                || mapping_info.mapq < extractor.mapq //Check whether the mapping reaches the minimum quality
-                || ((extractor.check_flag & CHECK_FLAG_FLAG) && (mapping_info.flag & 3852)) // Filtered flag from AllHiC.
-                || (ref_index == next_ref_index) // We don't care about the pairs on the same contigs.
-                || ((extractor.check_flag & CHECK_FLAG_RANGE) && (!range_in_range(mapping_info.pos, mapping_info.l_seq, (*extractor.contig_enzyme_ranges)[ref_index])))) // Or the position is not in the position.
-            {
-                continue;
-            }
-            //Save the mapping info to the buffer.
-            if (mapping_buffer_is_full(worker.valid_buffer))
-            {
-                mapping_worker_sync_dump(extractor.sync, worker.valid_buffer);
-            }
-            mapping_buffer_push(worker.valid_buffer, HMR_MAPPING{ mapping_info.refID, mapping_info.pos, mapping_info.next_refID, mapping_info.next_pos });
+            mapping_worker_sync_dump(extractor.sync, worker.valid_buffer);
         }
-        //Reset the start signal.
-        sync.start_signal[id] = false;
-        //Increase the sync counter.
-        mapping_worker_sync_complete_one(extractor.sync);
+        mapping_buffer_push(worker.valid_buffer, HMR_MAPPING{ mapping_info.refID, mapping_info.pos, mapping_info.next_refID, mapping_info.next_pos });
+        ++valid_reads;
+    }
+    if (hmr_stats_enabled())
+    {
+        hmr_stats_count("extract.reads", static_cast<uint64_t>(worker.end_pos - worker.start_pos));
+        hmr_stats_count("extract.valid_reads", valid_reads);
     }
 }
 
@@ -419,42 +371,33 @@ void pairs_extractor_free(PAIR_EXTRACTOR& extractor)
     mapping_worker_sync_free(extractor.sync);
 }
 
-void extract_mapping_pairs_worker(int32_t id, MAPPING_WORKER &worker, PAIR_EXTRACTOR &extractor)
+void extract_mapping_pairs_worker(MAPPING_WORKER &worker, PAIR_EXTRACTOR &extractor)
 {
-    MAPPING_WORKER_SYNC& sync = extractor.sync;
-    worker.counter = 0;
-    std::unique_lock<std::mutex> lock(sync.start_mutex[id]);
-    while (!sync.exit)
+    uint64_t valid_reads = 0;
+    //Loop in the worker area.
+    PAIRS_MAPPING_BUFFER* filtering_buf = extractor.buf_filtering;
+    worker.counter += worker.end_pos - worker.start_pos;
+    for (int32_t i = worker.start_pos; i < worker.end_pos; ++i)
     {
-        //Wait for the start signal.
-        sync.start_cv[id].wait(lock, [&] {return sync.start_signal[id]; });
-        if (sync.exit)
+        PAIRS_MAPPING_INFO& mapping_info = filtering_buf->buffer[i];
+        //Check whether the mapping info is valid, then check whether the position is in range.
+        if ((mapping_info.refID == mapping_info.next_refID) // We don't care about the pairs on the same contigs.
+            || ((extractor.check_flag & CHECK_FLAG_RANGE) && (!range_in_range(mapping_info.pos, extractor.read_len, (*extractor.contig_enzyme_ranges)[mapping_info.refID])))) // Or the position is not in the position.
         {
-            return;
+            continue;
         }
-        //Loop in the worker area.
-        PAIRS_MAPPING_BUFFER* filtering_buf = extractor.buf_filtering;
-        worker.counter += worker.end_pos - worker.start_pos;
-        for (int32_t i = worker.start_pos; i < worker.end_pos; ++i)
+        //Save the mapping info to the buffer.
+        if (mapping_buffer_is_full(worker.valid_buffer))
         {
-            PAIRS_MAPPING_INFO& mapping_info = filtering_buf->buffer[i];
-            //Check whether the mapping info is valid, then check whether the position is in range.
-            if ((mapping_info.refID == mapping_info.next_refID) // We don't care about the pairs on the same contigs.
-                || ((extractor.check_flag & CHECK_FLAG_RANGE) && (!range_in_range(mapping_info.pos, extractor.read_len, (*extractor.contig_enzyme_ranges)[mapping_info.refID])))) // Or the position is not in the position.
-            {
-                continue;
-            }
-            //Save the mapping info to the buffer.
-            if (mapping_buffer_is_full(worker.valid_buffer))
-            {
-                mapping_worker_sync_dump(extractor.sync, worker.valid_buffer);
-            }
-            mapping_buffer_push(worker.valid_buffer, HMR_MAPPING{ mapping_info.refID, mapping_info.pos, mapping_info.next_refID, mapping_info.next_pos });
+            mapping_worker_sync_dump(extractor.sync, worker.valid_buffer);
         }
-        //Reset the start signal.
-        sync.start_signal[id] = false;
-        //Increase the sync counter.
-        mapping_worker_sync_complete_one(extractor.sync);
+        mapping_buffer_push(worker.valid_buffer, HMR_MAPPING{ mapping_info.refID, mapping_info.pos, mapping_info.next_refID, mapping_info.next_pos });
+        ++valid_reads;
+    }
+    if (hmr_stats_enabled())
+    {
+        hmr_stats_count("extract.reads", static_cast<uint64_t>(worker.end_pos - worker.start_pos));
+        hmr_stats_count("extract.valid_reads", valid_reads);
     }
 }
 
@@ -506,15 +449,12 @@ void extract_mapping_file(const char* filepath, CONTIG_INDEX_MAP* index_map, FIL
         bam_extractor_init(bam_extractor, index_map, contig_enzyme_ranges, mapq, reads_file, thread_buffer_size, num_of_worker, check_flag);
         //Prepare the worker buffer.
         MAPPING_WORKER* worker_buffer = new MAPPING_WORKER[num_of_worker];
-        //Start BAM filter workers.
-        std::thread *workers = new std::thread[num_of_worker];
         for (int32_t i = 0; i < num_of_worker; ++i)
         {
             //Initialize the worker.
             worker_init(worker_buffer[i], i, thread_buffer_size);
-            //Start the worker.
-            workers[i] = std::thread(extract_mapping_bam_worker, i, std::ref(worker_buffer[i]), std::ref(bam_extractor));
         }
+        bam_extractor.sync.filter = [&](int32_t i) { extract_mapping_bam_worker(worker_buffer[i], bam_extractor); };
         //Start parsing the bam file.
         hmr_bam_read(filepath, BAM_MAPPING_PROC{ extract_bam_num_of_contigs ,extract_bam_contig, extract_bam_read_align }, &bam_extractor, num_of_worker);
         //Wait for all the workers complete.
@@ -537,8 +477,8 @@ void extract_mapping_file(const char* filepath, CONTIG_INDEX_MAP* index_map, FIL
             //Start all the workers.
             mapping_worker_sync_start(bam_extractor.sync);
         }
-        //Exit all the workers.
-        mapping_worker_sync_exit(bam_extractor.sync, workers);
+        //Wait for the last part of work.
+        mapping_worker_sync_wait_ready(bam_extractor.sync);
         //Recover the memory and dump the data left in their buffer.
         for (int32_t i = 0; i < num_of_worker; ++i)
         {
@@ -546,7 +486,6 @@ void extract_mapping_file(const char* filepath, CONTIG_INDEX_MAP* index_map, FIL
             worker_free(worker_buffer[i]);
         }
         bam_extractor_free(bam_extractor);
-        delete[] workers;
         delete[] worker_buffer;
         return;
     }
@@ -556,19 +495,16 @@ void extract_mapping_file(const char* filepath, CONTIG_INDEX_MAP* index_map, FIL
         pairs_extractor_init(pairs_extractor, contig_enzyme_ranges, reads_file, index_map, thread_buffer_size, threads, pairs_read_len, check_flag);
         //Prepare the worker buffer.
         MAPPING_WORKER* worker_buffer = new MAPPING_WORKER[threads];
-        //Start BAM filter workers.
-        std::thread *workers = new std::thread[threads];
         for (int32_t i = 0; i < threads; ++i)
         {
             //Initialize the worker.
             worker_init(worker_buffer[i], i, thread_buffer_size);
-            //Start the worker.
-            workers[i] = std::thread(extract_mapping_pairs_worker, i, std::ref(worker_buffer[i]), std::ref(pairs_extractor));
         }
+        pairs_extractor.sync.filter = [&](int32_t i) { extract_mapping_pairs_worker(worker_buffer[i], pairs_extractor); };
         //Parse the pairs format file.
         hmr_pairs_read(filepath, extract_pairs_proc, &pairs_extractor);
-        //Exit all the workers.
-        mapping_worker_sync_exit(pairs_extractor.sync, workers);
+        //Wait for all the workers complete.
+        mapping_worker_sync_wait_ready(pairs_extractor.sync);
         //Recover the memory and dump the data left in their buffer.
         for (int32_t i = 0; i < threads; ++i)
         {
@@ -576,7 +512,6 @@ void extract_mapping_file(const char* filepath, CONTIG_INDEX_MAP* index_map, FIL
             worker_free(worker_buffer[i]);
         }
         pairs_extractor_free(pairs_extractor);
-        delete[] workers;
         delete[] worker_buffer;
         return;
     }
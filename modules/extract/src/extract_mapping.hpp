@@ -6,6 +6,17 @@
 
 constexpr auto CHECK_FLAG_RANGE = 1 << 0;
 constexpr auto CHECK_FLAG_FLAG = 1 << 1;
+constexpr uint16_t BAM_FILTER_FLAG = 3852; // Filtered flag from AllHiC.
+
+/* Check the BAM mapping before the enzyme range, the contig index is -1 when the reference is not a contig */
+inline bool extract_bam_mapping_valid(int32_t ref_index, int32_t next_ref_index, uint8_t mapq, uint16_t flag, uint8_t min_mapq, uint16_t check_flag)
+{
+    return ref_index != -1 && next_ref_index != -1 //Reference index cannot be find in the mapping index detection.
+        && mapq != 0 && mapq != 255 //Map quality is invalid.
+        && mapq >= min_mapq //Check whether the mapping reaches the minimum quality
+        && !((check_flag & CHECK_FLAG_FLAG) && (flag & BAM_FILTER_FLAG))
+        && ref_index != next_ref_index; // We don't care about the pairs on the same contigs.
+}
 
 void extract_mapping_file(const char* filepath, CONTIG_INDEX_MAP* index_map, FILE* reads_file, CONTIG_ENZYME_RANGES* contig_enzyme_ranges,
                           uint16_t check_flag, int32_t pairs_read_len, uint8_t mapq, int32_t thread_buffer_size, int32_t threads);
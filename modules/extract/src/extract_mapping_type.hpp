@@ -1,10 +1,11 @@
 #ifndef EXTRACT_MAPPING_TYPE_H
 #define EXTRACT_MAPPING_TYPE_H
 
+#include <functional>
 #include <mutex>
-#include <condition_variable>
 
 #include "hmr_contig_graph_type.hpp"
+#include "hmr_task_scheduler.hpp"
 
 #include "extract_index_map.hpp"
 
@@ -23,11 +24,11 @@ typedef struct MAPPING_WORKER
 
 typedef struct MAPPING_WORKER_SYNC
 {
-    std::mutex *start_mutex, complete_mutex, file_mutex;
-    std::condition_variable *start_cv, complete_cv;
-    bool *start_signal = NULL;
-    int32_t completed_worker = 0, total_worker = 0;
-    bool exit = false;
+    std::mutex file_mutex;
+    hmr::task_scheduler* scheduler = NULL;
+    hmr::task_group* filter_group = NULL;
+    std::function<void(int32_t)> filter; // Filters the range of a worker in the filtering buffer.
+    int32_t total_worker = 0;
     FILE* reads_file;
 } MAPPING_WORKER_SYNC;
 
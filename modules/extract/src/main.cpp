@@ -9,6 +9,7 @@
 #include "hmr_fasta.hpp"
 #include "hmr_global.hpp"
 #include "hmr_path.hpp"
+#include "hmr_stats.hpp"
 #include "hmr_ui.hpp"
 
 #include "args_extract.hpp"
@@ -22,6 +23,7 @@ int main(int argc, char* argv[])
 {
     //Parse the arguments.
     parse_arguments(argc, argv);
+    if (opts.stats) { hmr_stats_enable("hana_extract", opts.stats); }
     //Check the arguments are meet the requirements.
     if (!opts.fasta) { help_exit(-1, "Missing FASTA file path."); }
     if (!path_can_read(opts.fasta)) { time_error(-1, "Cannot read FASTA file %s", opts.fasta); }
@@ -88,12 +90,15 @@ int main(int argc, char* argv[])
         CONTIG_NAME_CHAIN node_name_chain;
         CONTIG_RANGE_RESULTS node_ranges;
         {
-            //Start the enzyme search pool.
-            RANGE_SEARCH_POOL pool(contig_range_search, opts.threads * opts.fasta_pool, opts.threads);
+            HMR_STATS_SCOPE search_scope("extract.enzyme_search");
+            //Start the enzyme search scheduler.
+            hmr::task_scheduler scheduler(opts.threads);
+            hmr::task_group search_group(scheduler);
             //Construct the contig info build user.
-            EXTRACT_FASTA_USER node_build_user {search_range, search_calc, node_chain, node_name_chain, pool, opts.range, node_ranges };
+            EXTRACT_FASTA_USER node_build_user {search_range, search_calc, node_chain, node_name_chain, search_group, static_cast<int64_t>(opts.threads) * opts.fasta_pool, opts.range, node_ranges };
             time_print("Searching enzyme in %s", opts.fasta);
             hmr_fasta_read(opts.fasta, extract_fasta_search_proc, &node_build_user);
+            search_group.wait();
         }
         extract_enzyme_search_end(search_range);
         //Convert the node chain into node vector.
@@ -146,6 +151,7 @@ int main(int argc, char* argv[])
     for (char* mapping_path : opts.mappings)
     {
         time_print("Loading reads from %s", mapping_path);
+        HMR_STATS_SCOPE mapping_scope("extract.mapping");
         extract_mapping_file(mapping_path, &contig_index_map, reads_file, &contig_enzyme_ranges, check_flag, opts.pairs_read_len, opts.mapq, opts.mapping_pool, opts.threads);
     }
     fclose(reads_file);
@@ -13,11 +13,15 @@ SOURCES += \
     ../shared/hmr_bin_file.cpp \
     ../shared/hmr_contig_graph.cpp \
     ../shared/hmr_path.cpp \
+    ../shared/hmr_stats.cpp \
     ../shared/hmr_ui.cpp \
     src/args_ordering.cpp \
     src/main.cpp \
     src/ordering_ea.cpp \
-    src/ordering_loader.cpp
+    src/ordering_loader.cpp \
+    src/ordering_polish.cpp \
+    src/ordering_seed.cpp \
+    src/ordering_links.cpp
 
 HEADERS += \
     ../shared/hmr_algorithm.hpp \
@@ -27,8 +31,13 @@ HEADERS += \
     ../shared/hmr_contig_graph.hpp \
     ../shared/hmr_contig_graph_type.hpp \
     ../shared/hmr_path.hpp \
+    ../shared/hmr_stats.hpp \
+    ../shared/hmr_task_scheduler.hpp \
     ../shared/hmr_ui.hpp \
     src/args_ordering.hpp \
     src/ordering_ea.hpp \
     src/ordering_loader.hpp \
+    src/ordering_polish.hpp \
+    src/ordering_seed.hpp \
+    src/ordering_links.hpp \
     src/ordering_type.hpp
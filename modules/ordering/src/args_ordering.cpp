@@ -9,8 +9,8 @@ HMR_ARGS opts;
 HMR_ARG_PARSER args_parser = {
     { {"-n", "--nodes"}, "NODES", "HMR contig node file (.hmr_contig)", LAMBDA_PARSE_ARG {opts.nodes = arg[0]; }},
     { {"-e", "--edge"}, "EDGE", "HMR edge file (.hmr_edge)", LAMBDA_PARSE_ARG { opts.edge = arg[0];}},
-    { {"-g", "--group"}, "GROUP", "HMR contig group file (.hmr_group)", LAMBDA_PARSE_ARG { opts.group = arg[0];}},
-    { {"-o", "--output"}, "OUTPUT", "Output ordered contig sequence file (.hmr_seq)", LAMBDA_PARSE_ARG {opts.output = arg[0]; }},
+    { {"-g", "--group"}, "GROUP 1, GROUP 2...", "HMR contig group files (.hmr_group)", LAMBDA_PARSE_ARG { opts.groups = arg;}},
+    { {"-o", "--output"}, "OUTPUT", "Output ordered contig sequence file of a single group (.hmr_seq, default: named after the group)", LAMBDA_PARSE_ARG {opts.output = arg[0]; }},
     { {"-t", "--threads"}, "THREADS", "Number of threads (default: 1)", LAMBDA_PARSE_ARG { opts.threads = atoi(arg[0]); }},
     { {"-b", "--buffer-size"}, "BUFFER_SIZE", "HMR edge buffer size (unit: K, default: 512)", LAMBDA_PARSE_ARG {opts.read_buffer_size = atoi(arg[0]); }},
     { {"-s", "--seed"}, "SEED", "Fixed random seed, 0 for no special seed (default: 806)", LAMBDA_PARSE_ARG {opts.seed = atoll(arg[0]); }},
@@ -18,4 +18,8 @@ HMR_ARG_PARSER args_parser = {
     { {"--ngen"}, "NUM_OF_GENERATION", "Number of generations for convergence (default: 5000)", LAMBDA_PARSE_ARG {opts.ngen = atoi(arg[0]); }},
     { {"--max-gen"}, "MAX_GENERATION", "Limits of trial generations (default: 1000000)", LAMBDA_PARSE_ARG {opts.max_gen = atoll(arg[0]); }},
     { {"--npop"}, "NUM_OF_POP", "Candidate sequences size (default: 100)", LAMBDA_PARSE_ARG {opts.npop = atoi(arg[0]); }},
+    { {"--no-seed"}, "", "Skip the spectral, greedy chain and nearest neighbour tours in the initial population, the spectral tour takes up to 8 MB and about a second per group", LAMBDA_PARSE_ARG { (void)arg; opts.no_seed = true; }},
+    { {"--no-polish"}, "", "Skip the local search polish after the evaluation algorithm", LAMBDA_PARSE_ARG { (void)arg; opts.no_polish = true; }},
+    { {"--migration"}, "MIGRATION", "Evolve one island per thread and migrate the elites every MIGRATION generations, 0 to share one population (default: 0)", LAMBDA_PARSE_ARG {opts.migration = atoi(arg[0]); }},
+    { {"--stats"}, "STATS", "Save the stage timings, counters and peak memory as JSON", LAMBDA_PARSE_ARG {opts.stats = arg[0]; }},
 };
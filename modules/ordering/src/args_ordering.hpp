@@ -3,16 +3,19 @@
 
 #include <cstdlib>
 #include <cstdint>
+#include <vector>
 
 typedef struct HMR_ARGS
 {
     const char* nodes = NULL;
     const char* edge = NULL;
-    const char* group = NULL;
+    std::vector<char*> groups;
     const char* output = NULL;
+    const char* stats = NULL;
     double mutapb = 0.2;
-    int ngen = 5000, npop = 100, threads = 1, read_buffer_size = 512;
+    int ngen = 5000, npop = 100, threads = 1, read_buffer_size = 512, migration = 0;
     uint64_t seed = 806, max_gen = 1000000;
+    bool no_polish = false, no_seed = false;
 } HMR_ARGS;
 
 #endif // ARGS_ORDERING_H
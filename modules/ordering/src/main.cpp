@@ -7,26 +7,105 @@
 #include "hmr_contig_graph.hpp"
 #include "hmr_ui.hpp"
 #include "hmr_path.hpp"
+#include "hmr_stats.hpp"
+#include "hmr_task_scheduler.hpp"
 
+#include "ordering_links.hpp"
 #include "ordering_loader.hpp"
 #include "ordering_ea.hpp"
+#include "ordering_polish.hpp"
+#include "ordering_seed.hpp"
 
 #include "args_ordering.hpp"
 
 extern HMR_ARGS opts;
 
+typedef struct ORDERING_GROUP
+{
+    const char* group_path;
+    std::string output_path;
+    HMR_CONTIG_ID_VEC contig_ids;
+    std::vector<ORDERING_LINK> edges;
+    const HMR_NODES* contigs;
+    int32_t threads;
+} ORDERING_GROUP;
+
+void ordering_group_proc(ORDERING_GROUP* group)
+{
+    //Initialize the ordering info.
+    ORDERING_INFO info;
+    info.contig_size = static_cast<int32_t>(group->contig_ids.size());
+    info.contig_ids = group->contig_ids;
+    ordering_links_init(info.edges, info.contig_size, group->edges);
+    group->edges = std::vector<ORDERING_LINK>();
+    //Construct the tours to seed the initial population.
+    if (!opts.no_seed)
+    {
+        std::vector<HMR_CONTIG_ID_VEC> tours;
+        double seed_start = hmr_stats_now();
+        ordering_seed_tours(info.edges, tours);
+        hmr_stats_stage("ordering.seed", seed_start);
+        for (const HMR_CONTIG_ID_VEC& tour : tours)
+        {
+            std::vector<ORDERING_TIG> seed(tour.size());
+            for (size_t i = 0; i < tour.size(); ++i)
+            {
+                seed[i].index = tour[i];
+                seed[i].length = (*group->contigs)[info.contig_ids[tour[i]]].length;
+            }
+            info.seeds.push_back(seed);
+        }
+        time_print("%zu initial tour(s) constructed for %s", info.seeds.size(), group->group_path);
+    }
+    //Shuffle the initial order for good luck, each group starts from the same seed.
+    time_print("Generating initial contig orders of %s...", group->group_path);
+    HMR_CONTIG_ID_VEC contig_group = group->contig_ids;
+    std::mt19937_64 rng(opts.seed);
+    std::shuffle(contig_group.begin(), contig_group.end(), rng);
+    info.init_genome = static_cast<ORDERING_TIG*>(malloc(sizeof(ORDERING_TIG) * info.contig_size));
+    if (!info.init_genome)
+    {
+        time_error(-1, "Failed to allocate memory for initial order sequence.");
+    }
+    assert(info.init_genome);
+    //Loop for 2 phase, the first phase is generating a ordered sequence, the second phase is to test whether it could be better.
+    for (int32_t phase = 0; phase < 2; ++phase)
+    {
+        time_print("Starting evaluation algorithm phase %d of %s...", phase + 1, group->group_path);
+        ordering_ea_init(contig_group, *group->contigs, info);
+        contig_group = ordering_ea_optimize(phase + 1, opts.npop, opts.ngen, opts.max_gen, opts.mutapb, info, rng, group->threads, opts.migration);
+        //The second phase starts from the result of the first phase only.
+        info.seeds.clear();
+    }
+    //Polish the evaluation result with local search.
+    if (!opts.no_polish)
+    {
+        ordering_ea_init(contig_group, *group->contigs, info);
+        HMR_STATS_SCOPE polish_scope("ordering.polish");
+        contig_group = ordering_polish(info, group->threads);
+    }
+    free(info.init_genome);
+    //Dump the data to output file.
+    time_print("Writing ordered contig indices to %s", group->output_path.c_str());
+    hmr_graph_save_contig_ids(group->output_path.c_str(), contig_group);
+}
+
 int main(int argc, char* argv[])
 {
     //Parse the arguments.
     parse_arguments(argc, argv);
+    if (opts.stats) { hmr_stats_enable("hana_ordering", opts.stats); }
     //Check the arguments are meet the requirements.
     if (!opts.nodes) { help_exit(-1, "Missing HMR graph contig information file path."); }
     if (!path_can_read(opts.nodes)) { time_error(-1, "Cannot read HMR graph contig file %s", opts.nodes); }
     if (!opts.edge) { help_exit(-1, "Missing HMR graph edge file path."); }
     if (!path_can_read(opts.edge)) { time_error(-1, "Cannot read HMR graph edge file %s", opts.edge); }
-    if (!opts.group) { help_exit(-1, "Missing HMR contig group file path."); }
-    if (!path_can_read(opts.group)) { time_error(-1, "Cannot read HMR contig group file %s", opts.group); }
-    if (!opts.output) { help_exit(-1, "Missing HMR sequence output file path."); }
+    if (opts.groups.empty()) { help_exit(-1, "Missing HMR contig group file path."); }
+    for (const char* group_path : opts.groups)
+    {
+        if (!path_can_read(group_path)) { time_error(-1, "Cannot read HMR contig group file %s", group_path); }
+    }
+    if (opts.output && opts.groups.size() > 1) { help_exit(-1, "Output file path only works with a single group."); }
     time_print("Execution configuration:");
     time_print("\tMaximum idle generations: %d", opts.ngen);
     time_print("\tMaximum possible generations: %d", opts.max_gen);
@@ -39,48 +118,104 @@ int main(int argc, char* argv[])
     }
     time_print("\tRandom seed: %lu", opts.seed);
     time_print("\tThreads: %d", opts.threads);
+    time_print("\tScoring kernel: %s", ordering_row_kernel.name);
+    if (opts.migration > 0)
+    {
+        time_print("\tIsland migration: every %d generations", opts.migration);
+    }
+    time_print("\tConstructed initial tours: %s", opts.no_seed ? "No" : "Yes");
+    time_print("\tLocal search polish: %s", opts.no_polish ? "No" : "Yes");
     time_print("\tEdge buffer: %dK", opts.read_buffer_size);
+    time_print("\tGroups: %zu", opts.groups.size());
     opts.read_buffer_size <<= 10;
-    //Read the group file for the index.
-    time_print("Loading group contig index from %s", opts.group);
-    HMR_CONTIG_ID_VEC contig_group;
-    hmr_graph_load_contig_ids(opts.group, contig_group);
-    std::sort(contig_group.begin(), contig_group.end());
-    time_print("%zu contig indices loaded.", contig_group.size());
     //Load the contig information.
     time_print("Loading contig information from %s", opts.nodes);
     HMR_NODES contigs;
     hmr_graph_load_contigs(opts.nodes, contigs);
     time_print("%zu contig(s) loaded.", contigs.size());
-    //Initialize the ordering info.
+    //Read the group files for the index.
+    int32_t num_of_groups = static_cast<int32_t>(opts.groups.size());
+    std::vector<ORDERING_GROUP> groups(num_of_groups);
+    HMR_CONTIG_ID_VEC group_ids(contigs.size(), -1), local_ids(contigs.size(), -1);
+    for (int32_t i = 0; i < num_of_groups; ++i)
+    {
+        ORDERING_GROUP& group = groups[i];
+        group.group_path = opts.groups[i];
+        group.output_path = opts.output ? std::string(opts.output) : hmr_graph_path_seq_name(group.group_path);
+        group.contigs = &contigs;
+        time_print("Loading group contig index from %s", group.group_path);
+        hmr_graph_load_contig_ids(group.group_path, group.contig_ids);
+        std::sort(group.contig_ids.begin(), group.contig_ids.end());
+        for (size_t j = 0; j < group.contig_ids.size(); ++j)
+        {
+            int32_t contig_id = group.contig_ids[j];
+            if (contig_id < 0 || contig_id >= static_cast<int32_t>(contigs.size()))
+            {
+                time_error(-1, "Invalid contig id %d in group file %s", contig_id, group.group_path);
+            }
+            if (group_ids[contig_id] != -1)
+            {
+                time_error(-1, "Contig %d appears in both %s and %s", contig_id, opts.groups[group_ids[contig_id]], group.group_path);
+            }
+            group_ids[contig_id] = i;
+            local_ids[contig_id] = static_cast<int32_t>(j);
+        }
+        time_print("%zu contig indices loaded.", group.contig_ids.size());
+    }
+    //Load the edges of all the groups in one pass.
     time_print("Loading edge information from %s", opts.edge);
-    ORDERING_INFO info;
-    info.contig_size = static_cast<int32_t>(contig_group.size());
-    info.edges.reserve(info.contig_size);
-    ORDERING_EDGE_LOADER loader{ contig_group, info.edges };
-    hmr_graph_load_edges(opts.edge, opts.read_buffer_size, ordering_edge_map_size_proc, ordering_edge_map_data_proc, &loader);
-    time_print("Group edges are loaded.");
-    //Shuffle the initial order for good luck.
-    time_print("Generating initial contig orders...");
-    std::mt19937_64 rng(opts.seed);
-    std::shuffle(contig_group.begin(), contig_group.end(), rng);
-    info.init_genome = static_cast<ORDERING_TIG*>(malloc(sizeof(ORDERING_TIG) * info.contig_size));
-    if (!info.init_genome)
+    std::vector<std::vector<ORDERING_LINK> > group_edges(num_of_groups);
+    ORDERING_EDGE_LOADER loader{ group_ids, local_ids, group_edges };
+    double load_start = hmr_stats_now();
+    if (hmr_graph_edges_is_undirected(opts.edge))
     {
-        time_error(-1, "Failed to allocate memory for initial order sequence.");
+        hmr_graph_load_undirected_edges(opts.edge, opts.read_buffer_size, ordering_edge_map_size_proc, ordering_undirected_edge_map_data_proc, &loader);
     }
-    assert(info.init_genome);
-    //Loop for 2 phase, the first phase is generating a ordered sequence, the second phase is to test whether it could be better.
-    for (int32_t phase = 0; phase < 2; ++phase)
+    else
     {
-        time_print("Starting evaluation algorithm phase %d...", phase + 1);
-        ordering_ea_init(contig_group, contigs, info);
-        contig_group = ordering_ea_optimize(phase + 1, opts.npop, opts.ngen, opts.max_gen, opts.mutapb, info, rng, opts.threads);
+        hmr_graph_load_edges(opts.edge, opts.read_buffer_size, ordering_edge_map_size_proc, ordering_edge_map_data_proc, &loader);
+    }
+    hmr_stats_stage("ordering.load_edges", load_start);
+    for (int32_t i = 0; i < num_of_groups; ++i)
+    {
+        groups[i].edges.swap(group_edges[i]);
+        time_print("%zu edge(s) loaded for %s", groups[i].edges.size(), groups[i].group_path);
+    }
+    if (num_of_groups == 1)
+    {
+        groups[0].threads = opts.threads;
+        ordering_group_proc(&groups[0]);
+    }
+    else
+    {
+        //Schedule the largest groups first, the threads left are shared by the EA of each group.
+        std::vector<ORDERING_GROUP*> schedule(num_of_groups);
+        for (int32_t i = 0; i < num_of_groups; ++i)
+        {
+            schedule[i] = &groups[i];
+        }
+        std::stable_sort(schedule.begin(), schedule.end(),
+            [](const ORDERING_GROUP* lhs, const ORDERING_GROUP* rhs)
+            {
+                return lhs->contig_ids.size() > rhs->contig_ids.size();
+            });
+        int32_t workers = opts.threads < num_of_groups ? opts.threads : num_of_groups;
+        if (workers < 1)
+        {
+            workers = 1;
+        }
+        int32_t ea_threads = opts.threads / workers;
+        time_print("Ordering %d groups with %d worker(s), %d thread(s) for each group...", num_of_groups, workers, ea_threads < 1 ? 1 : ea_threads);
+        //The groups from the main thread are taken in the schedule order.
+        hmr::task_scheduler scheduler(workers);
+        hmr::task_group group_tasks(scheduler);
+        for (ORDERING_GROUP* group : schedule)
+        {
+            group->threads = ea_threads;
+            group_tasks.run([group] { ordering_group_proc(group); });
+        }
+        group_tasks.wait();
     }
-    free(info.init_genome);
-    //Dump the data to output file.
-    time_print("Writing ordered contig indices to %s", opts.output);
-    hmr_graph_save_contig_ids(opts.output, contig_group);
     time_print("Ordering complete.");
     return 0;
 }
\ No newline at end of file
@@ -1,21 +1,49 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstring>
-#include <numeric>
 #include <mutex>
-#include <thread>
 
 #include "hmr_algorithm.hpp"
+#include "hmr_stats.hpp"
+#include "hmr_task_scheduler.hpp"
 #include "hmr_ui.hpp"
 
 #include "ordering_ea.hpp"
+#include "ordering_links.hpp"
 
 constexpr double LIMIT = 10000000;
 const double LimitLog = log(LIMIT);
 
+typedef struct ORDERING_RNG
+{
+    //Splitmix64 generator, cheap enough to create one stream per offspring pair.
+    typedef uint64_t result_type;
+    uint64_t state;
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return UINT64_MAX; }
+    uint64_t operator()()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+} ORDERING_RNG;
+
+inline ORDERING_RNG ordering_rng_stream(uint64_t seed, uint64_t stream)
+{
+    //Derive an independent stream from the seed and the stream index.
+    ORDERING_RNG mixer{ stream };
+    return ORDERING_RNG{ seed ^ mixer() };
+}
+
 typedef struct ORDERING_EVA
 {
     ORDERING_TIG* seq;
+    double* mid; // Cached contig midpoints of the sequence.
     double score;
     bool evaluated;
 } ORDERING_EVA;
@@ -26,8 +54,10 @@ typedef struct ORDERING_EA
     double mut_rate;
     uint64_t generations;
     std::mt19937_64 rng;
+    uint64_t gen_seed;
 
     ORDERING_TIG* buffer1, * buffer2; // Sequence buffer pool.
+    double* mid1, * mid2; // Midpoint buffer pool.
     ORDERING_EVA* eva1, * eva2;
 
     ORDERING_TIG* best_seq;
@@ -37,37 +67,37 @@ typedef struct ORDERING_EA
     bool reversed;
     ORDERING_EVA* current_eva, * target_eva;
     ORDERING_TIG* target_buffer;
-
-    int32_t mutate_complete_counter;
-    std::mutex *mutate_mutex;
-    std::mutex complete_thread_lock;
-    uint64_t* mutate_seeds;
-    bool* mutate_flag, mutate_exit;
+    double* target_mid;
 } ORDERING_EA;
 
-int32_t ordering_ea_get_links(int32_t a, int32_t b, const ORDERING_COUNTS& edges)
+typedef struct ORDERING_MIGRANT
 {
-    if (a > b)
-    {
-        hmr_swap(a, b);
-    }
-    auto a_iter = edges.find(a);
-    if (a_iter == edges.end())
-    {
-        return 0;
-    }
-    auto b_iter = a_iter->second.find(b);
-    return b_iter == a_iter->second.end() ? 0 : b_iter->second;
-}
+    ORDERING_TIG* seq;
+    double* mid;
+    double score;
+    std::atomic<bool> full; // Single slot channel, written by the previous island only.
+} ORDERING_MIGRANT;
 
-double ordering_evaluate_sequence(ORDERING_TIG* seq, int32_t seq_length, const ORDERING_COUNTS& edges)
+typedef struct ORDERING_ISLANDS
+{
+    const ORDERING_INFO* info;
+    int32_t phase, num_of_islands, island_pop, ngen, migration;
+    uint64_t maxgen;
+    double mut_rate;
+    size_t seq_bytes;
+    uint64_t* seeds;
+    ORDERING_MIGRANT* inboxes;
+    std::atomic<bool> stop;
+    std::atomic<uint64_t> improvements;
+    std::atomic<uint64_t> generations;
+
+    std::mutex best_lock;
+    ORDERING_TIG* best_seq;
+    std::atomic<double> best_score;
+} ORDERING_ISLANDS;
+
+double ordering_evaluate_sequence(ORDERING_TIG* seq, double* mid, int32_t seq_length, const ORDERING_LINKS& edges)
 {
-    double* mid = static_cast<double*>(malloc(sizeof(double) * seq_length));
-    if (!mid)
-    {
-        time_error(-1, "No enough memory for evaluating sequences.");
-    }
-    assert(mid);
     double cum_sum = 0.0;
     for (int32_t i = 0; i < seq_length; ++i)
     {
@@ -77,39 +107,72 @@ double ordering_evaluate_sequence(ORDERING_TIG* seq, int32_t seq_length, const O
     }
     //Calculate the score of the sequence.
     double score = 0.0;
+    int32_t range_end = 0;
     for (int32_t i = 0; i < seq_length - 1; ++i)
+    {
+        double a_mid = mid[i];
+        // This serves two purposes:
+        // 1. Break earlier reduces the amount of calculation
+        // 2. Ignore distant links so that telomeric regions don't come
+        //    to be adjacent (based on Ler0 data)
+        //The midpoints are increasing, so the end of the range only moves forward.
+        while (range_end < seq_length && mid[range_end] - a_mid <= LIMIT)
+        {
+            ++range_end;
+        }
+        // We are looking for maximum
+        score -= ordering_links_row_sum(edges, seq[i].index, a_mid, seq, mid, i + 1, range_end);
+    }
+    return score;
+}
+
+double ordering_evaluate_window(const ORDERING_TIG* seq, const double* mid, int32_t seq_length, int32_t p, int32_t q, int32_t split_a, int32_t split_b, const ORDERING_LINKS& edges)
+{
+    //The window [p, q] is split into rigid blocks [p, split_a), [split_a, split_b) and [split_b, q].
+    //A mutation only translates or reflects these blocks, the pairs inside a block keep their distance.
+    //Calculate the score of the pairs which across different blocks.
+    double score = 0.0;
+    for (int32_t i = p; i <= q; ++i)
     {
         int32_t a = seq[i].index;
         double a_mid = mid[i];
-        for (int32_t j = i + 1; j < seq_length; ++j)
-        {
-            int32_t b = seq[j].index,
-                n_links = ordering_ea_get_links(a, b, edges);
-            double dist = mid[j] - a_mid;
-            // This serves two purposes:
-            // 1. Break earlier reduces the amount of calculation
-            // 2. Ignore distant links so that telomeric regions don't come
-            //    to be adjacent (based on Ler0 data)
-            if (dist > LIMIT)
-            {
-                break;
-            }
-            // We are looking for maximum
-            score -= static_cast<double>(n_links) / dist;
+        //Pairs to the right, skip the contigs in the same block.
+        int32_t block_end = i < split_a ? split_a : (i < split_b ? split_b : q + 1);
+        if (block_end < seq_length)
+        {
+            int32_t right_end = static_cast<int32_t>(std::upper_bound(mid + block_end, mid + seq_length, a_mid + LIMIT) - mid);
+            score -= ordering_links_row_sum(edges, a, a_mid, seq, mid, block_end, right_end);
+        }
+        //Pairs to the left of the window.
+        if (p > 0)
+        {
+            int32_t left_start = static_cast<int32_t>(std::lower_bound(mid, mid + p, a_mid - LIMIT) - mid);
+            score -= ordering_links_row_sum(edges, a, a_mid, seq, mid, left_start, p);
         }
     }
-    free(mid);
     return score;
 }
 
-void ordering_evaluate_calc(ORDERING_EVA* eva, int32_t seqs_count, int32_t seq_length, const ORDERING_COUNTS& edges)
+void ordering_update_mid(const ORDERING_TIG* seq, double* mid, int32_t p, int32_t q)
+{
+    //The contigs outside [p, q] are not moved, only update the midpoints inside.
+    double cum_sum = p ? mid[p - 1] + static_cast<double>(seq[p - 1].length) / 2.0 : 0.0;
+    for (int32_t i = p; i <= q; ++i)
+    {
+        double t_size = static_cast<double>(seq[i].length);
+        mid[i] = cum_sum + t_size / 2.0;
+        cum_sum += t_size;
+    }
+}
+
+void ordering_evaluate_calc(ORDERING_EVA* eva, int32_t seqs_count, int32_t seq_length, const ORDERING_LINKS& edges)
 {
     //Loop and check all the evaluation state.
     for (int32_t i = 0; i < seqs_count; ++i)
     {
         if (!eva[i].evaluated)
         {
-            eva[i].score = ordering_evaluate_sequence(eva[i].seq, seq_length, edges);
+            eva[i].score = ordering_evaluate_sequence(eva[i].seq, eva[i].mid, seq_length, edges);
             eva[i].evaluated = true;
         }
     }
@@ -117,14 +180,16 @@ void ordering_evaluate_calc(ORDERING_EVA* eva, int32_t seqs_count, int32_t seq_l
 
 void ordering_evaluate_sort(ORDERING_EVA* eva, int32_t seqs_count)
 {
+    //Equal scores keep the slot order (the sequences are laid out by slot), so the result never depends on the
+    //sort internals, and unlike the stable sort nothing is allocated.
     std::sort(eva, eva + seqs_count,
         [](const ORDERING_EVA& lhs, const ORDERING_EVA& rhs)
         {
-            return lhs.score < rhs.score;
+            return lhs.score < rhs.score || (lhs.score == rhs.score && lhs.seq < rhs.seq);
         });
 }
 
-inline void ordering_ea_tig_random_range(std::uniform_int_distribution<>& dist, std::mt19937_64& rng, int32_t& p, int32_t& q)
+inline void ordering_ea_tig_random_range(std::uniform_int_distribution<>& dist, ORDERING_RNG& rng, int32_t& p, int32_t& q)
 {
     p = dist(rng);
     q = dist(rng);
@@ -143,11 +208,29 @@ inline void ordering_swap(ORDERING_TIG* seq, int32_t p, int32_t q)
     seq[q] = temp;
 }
 
-void ordering_mutate(ORDERING_EVA& candidate, int32_t seq_length, std::mt19937_64& rng)
+inline void ordering_mutate_window_begin(ORDERING_EVA& candidate, int32_t seq_length, int32_t p, int32_t q, int32_t split_a, int32_t split_b, const ORDERING_LINKS& edges)
+{
+    //Remove the score of the pairs across the blocks before the mutation.
+    if (candidate.evaluated)
+    {
+        candidate.score -= ordering_evaluate_window(candidate.seq, candidate.mid, seq_length, p, q, split_a, split_b, edges);
+    }
+}
+
+inline void ordering_mutate_window_end(ORDERING_EVA& candidate, int32_t seq_length, int32_t p, int32_t q, int32_t split_a, int32_t split_b, const ORDERING_LINKS& edges)
+{
+    //Add the score of the pairs across the blocks after the mutation.
+    if (candidate.evaluated)
+    {
+        ordering_update_mid(candidate.seq, candidate.mid, p, q);
+        candidate.score += ordering_evaluate_window(candidate.seq, candidate.mid, seq_length, p, q, split_a, split_b, edges);
+    }
+}
+
+void ordering_mutate(ORDERING_EVA& candidate, int32_t seq_length, const ORDERING_LINKS& edges, ORDERING_RNG& rng)
 {
-    //Reset the evaluate state.
-    candidate.evaluated = false;
     // Mutate a Tour by applying by inversion or insertion
+    // Except splice, the mutations only move the blocks in [p, q], the score is updated by the pairs across them.
     std::uniform_real_distribution<> rate(0.0, 1.0);
     std::uniform_int_distribution<> index_rng(0, seq_length - 1);
     double mutate_rate = rate(rng);
@@ -165,27 +248,18 @@ void ordering_mutate(ORDERING_EVA& candidate, int32_t seq_length, std::mt19937_6
         {
             return;
         }
+        ordering_mutate_window_begin(candidate, seq_length, p, q, p + 1, q, edges);
         ordering_swap(candidate.seq, p, q);
+        ordering_mutate_window_end(candidate, seq_length, p, q, p + 1, q, edges);
     }
     else if (mutate_rate < 0.4)
     {
         //MutSplice(r, rng)
+        //All the contigs are moved, reset the evaluate state.
+        candidate.evaluated = false;
         int32_t k = index_rng(rng);
-        //Construct [k:][:k].
-        std::vector<ORDERING_TIG> buffer;
-        buffer.reserve(seq_length);
-        for (int32_t i = k; i < seq_length; ++i)
-        {
-            buffer.push_back(candidate.seq[i]);
-        }
-        for (int32_t i = 0; i < k; ++i)
-        {
-            buffer.push_back(candidate.seq[i]);
-        }
-        for (int32_t i = 0; i < seq_length; ++i)
-        {
-            candidate.seq[i] = buffer[i];
-        }
+        //Construct [k:][:k] in place.
+        std::rotate(candidate.seq, candidate.seq + k, candidate.seq + seq_length);
     }
     else if (mutate_rate < 0.7)
     {
@@ -197,15 +271,18 @@ void ordering_mutate(ORDERING_EVA& candidate, int32_t seq_length, std::mt19937_6
         if (rate(rng) < 0.5)
         {
             // Pop q and insert to p position
+            ordering_mutate_window_begin(candidate, seq_length, p, q, q, q + 1, edges);
             auto cq = candidate.seq[q];
             for (int32_t i = q; i > p; --i)
             {
                 candidate.seq[i] = candidate.seq[i - 1];
             }
             candidate.seq[p] = cq;
+            ordering_mutate_window_end(candidate, seq_length, p, q, p + 1, q + 1, edges);
         }
         else
         {
+            ordering_mutate_window_begin(candidate, seq_length, p, q, p + 1, q + 1, edges);
             auto cp = candidate.seq[p];
             // Move cq to the back and push everyone left
             for (int32_t i = p; i < q; ++i)
@@ -213,6 +290,7 @@ void ordering_mutate(ORDERING_EVA& candidate, int32_t seq_length, std::mt19937_6
                 candidate.seq[i] = candidate.seq[i + 1];
             }
             candidate.seq[q] = cp;
+            ordering_mutate_window_end(candidate, seq_length, p, q, q, q + 1, edges);
         }
     }
     else
@@ -222,59 +300,61 @@ void ordering_mutate(ORDERING_EVA& candidate, int32_t seq_length, std::mt19937_6
         // Choose two points on the genome
         int32_t p, q;
         ordering_ea_tig_random_range(index_rng, rng, p, q);
+        ordering_mutate_window_begin(candidate, seq_length, p, q, q + 1, q + 1, edges);
         // Swap within range
-        while (p < q)
+        for (int32_t i = p, j = q; i < j; ++i, --j)
         {
-            ordering_swap(candidate.seq, p, q);
-            ++p;
-            --q;
+            ordering_swap(candidate.seq, i, j);
         }
+        ordering_mutate_window_end(candidate, seq_length, p, q, q + 1, q + 1, edges);
     }
 }
 
-typedef std::vector<int32_t> ORDERING_IDS;
-ORDERING_IDS ordering_select_contestants(int32_t n, ORDERING_IDS& candidates, std::mt19937_64& rng)
-{
-    std::unordered_set<int32_t> chosen;
-    std::uniform_int_distribution<> dist(0, static_cast<int32_t>(candidates.size()) - 1);
-    for (int32_t i = 0; i < n; ++i)
-    {
-        int32_t j = dist(rng);
-        while (chosen.count(j) > 0)
-        {
-            j = dist(rng);
-        }
-        chosen.insert(j);
-    }
-    return ORDERING_IDS(chosen.begin(), chosen.end());
-}
+constexpr int32_t ORDERING_MAX_CONTESTANTS = 8;
 
 // SelTournament samples individuals through tournament selection. The
 // tournament is composed of randomly chosen individuals. The winner of the
 // tournament is the chosen individual with the lowest fitness. The obtained
 // individuals are all distinct, in other words there are no repetitions.
-ORDERING_IDS ordering_select_n_parents(int32_t n, int32_t num_of_contestants,
-    ORDERING_EVA* parents, int32_t seqs_count, std::mt19937_64& rng)
+// The contestants are drawn on the stack, nothing is allocated per selection.
+void ordering_select_n_parents(int32_t n, int32_t num_of_contestants,
+    const ORDERING_EVA* parents, int32_t seqs_count, ORDERING_RNG& rng, int32_t* winners)
 {
     // Check that the number of individuals is large enough
-    if (seqs_count - n < num_of_contestants - 1 || seqs_count < n)
+    if (seqs_count - n < num_of_contestants - 1 || seqs_count < n || num_of_contestants > ORDERING_MAX_CONTESTANTS)
     {
         time_error(-1, "Not enough contestants.");
     }
-    ORDERING_IDS winners;
-    ORDERING_IDS candidates(seqs_count);
-    winners.reserve(n);
-    std::iota(candidates.begin(), candidates.end(), 0);
+    std::uniform_int_distribution<> dist(0, seqs_count - 1);
+    int32_t contestants[ORDERING_MAX_CONTESTANTS];
     for (int32_t i = 0; i < n; ++i)
     {
-        // Select contestants.
-        std::vector<int32_t> contestants_id = ordering_select_contestants(num_of_contestants, candidates, rng);
+        // Select distinct contestants, the previous winners are banned from re-participating.
+        for (int32_t j = 0; j < num_of_contestants; ++j)
+        {
+            int32_t id;
+            bool taken;
+            do
+            {
+                id = dist(rng);
+                taken = false;
+                for (int32_t k = 0; k < j && !taken; ++k)
+                {
+                    taken = contestants[k] == id;
+                }
+                for (int32_t k = 0; k < i && !taken; ++k)
+                {
+                    taken = winners[k] == id;
+                }
+            } while (taken);
+            contestants[j] = id;
+        }
         // Find the winner from contestants.
-        int32_t winner_id = contestants_id[0];
+        int32_t winner_id = contestants[0];
         double winner_score = parents[winner_id].score;
         for (int32_t j = 1; j < num_of_contestants; ++j)
         {
-            int32_t current_id = contestants_id[j];
+            int32_t current_id = contestants[j];
             double current_score = parents[current_id].score;
             if (current_score < winner_score)
             {
@@ -283,30 +363,29 @@ ORDERING_IDS ordering_select_n_parents(int32_t n, int32_t num_of_contestants,
             }
         }
         //Record the winner id.
-        winners.push_back(winner_id);
-        // Ban the winner from re-participating.
-        candidates.erase(candidates.begin() + winner_id);
+        winners[i] = winner_id;
     }
-    return winners;
 }
 
 void ordering_clone_seq(ORDERING_EVA& dst, const ORDERING_EVA& src, size_t seq_bytes)
 {
-    //Copy the sequence first.
+    //Copy the sequence and its midpoints first.
     memcpy(dst.seq, src.seq, seq_bytes);
+    memcpy(dst.mid, src.mid, seq_bytes / sizeof(ORDERING_TIG) * sizeof(double));
     dst.score = src.score;
     dst.evaluated = src.evaluated;
 }
 
 void ordering_generate_offsprings(ORDERING_EVA* parents, ORDERING_EVA* offsprings,
     int32_t offspring_index, int32_t offspring_index_end, int32_t seqs_count,
-                                  const size_t seq_bytes, std::mt19937_64& rng)
+                                  const size_t seq_bytes, ORDERING_RNG& rng)
 {
     //Loop until the offsprings are filled.
     while (offspring_index < offspring_index_end)
     {
         //Select 2 parents from 3 contestants.
-        ORDERING_IDS selected = ordering_select_n_parents(2, 3, parents, seqs_count, rng);
+        int32_t selected[2];
+        ordering_select_n_parents(2, 3, parents, seqs_count, rng, selected);
         //Create the offsprings.
         if (offspring_index < offspring_index_end)
         {
@@ -321,64 +400,55 @@ void ordering_generate_offsprings(ORDERING_EVA* parents, ORDERING_EVA* offspring
     }
 }
 
-void ordering_offspring_worker(const int32_t idx, const int32_t threads, const ORDERING_INFO* info, size_t seq_bytes, ORDERING_EA* ea)
+void ordering_generate_range(ORDERING_EA* ea, const ORDERING_INFO* info, int32_t start_idx, int32_t end_idx, size_t seq_bytes)
 {
-    int32_t start_idx, end_idx;
-    {
-        int32_t step = (ea->num_of_seqs + threads - 1) / threads;
-        start_idx = idx * step;
-        end_idx = start_idx + step;
-        if (end_idx > ea->num_of_seqs)
-        {
-            end_idx = ea->num_of_seqs;
-        }
-    }
-    std::mt19937_64 rng(ea->mutate_seeds[idx]);
+    //Each offspring pair has its own random stream, so the result does not depend on the threads.
     std::uniform_real_distribution<double> rate(0.0, 1.0);
-    const double mut_rate = ea->mut_rate;
     const int32_t seq_length = info->contig_size;
-    const ORDERING_COUNTS& edges = info->edges;
-    while (true)
+    for (int32_t pair_idx = start_idx; pair_idx < end_idx; pair_idx += 2)
     {
-        //Wait for the start signal.
-        while(!ea->mutate_flag[idx])
-        {
-            std::this_thread::sleep_for(std::chrono::nanoseconds(1));
-        }
-        if (ea->mutate_exit)
-        {
-            //Just exit the thread.
-            break;
-        }
-        //Loop in thread range and handle the data.
-        ORDERING_EVA* source = ea->current_eva;
-        ORDERING_EVA* target = ea->target_eva;
-        //Generate offsprings.
-        ordering_generate_offsprings(source, target, start_idx, end_idx, ea->num_of_seqs, seq_bytes, rng);
-        //Mutate offsprings.
-        for (int32_t i = start_idx; i < end_idx; ++i)
-        {
-            if (rate(rng) < mut_rate)
+        ORDERING_RNG rng = ordering_rng_stream(ea->gen_seed, static_cast<uint64_t>(pair_idx >> 1));
+        //Select 2 parents from 3 contestants.
+        int32_t selected[2];
+        ordering_select_n_parents(2, 3, ea->current_eva, ea->num_of_seqs, rng, selected);
+        for (int32_t j = 0; j < 2 && pair_idx + j < end_idx; ++j)
+        {
+            //Create and mutate the offspring.
+            ORDERING_EVA& offspring = ea->target_eva[pair_idx + j];
+            ordering_clone_seq(offspring, ea->current_eva[selected[j]], seq_bytes);
+            if (rate(rng) < ea->mut_rate)
             {
-                ordering_mutate(target[i], seq_length, rng);
+                ordering_mutate(offspring, seq_length, info->edges, rng);
             }
-            if (!target[i].evaluated)
+            if (!offspring.evaluated)
             {
-                target[i].score = ordering_evaluate_sequence(target[i].seq, seq_length, edges);
-                target[i].evaluated = true;
+                offspring.score = ordering_evaluate_sequence(offspring.seq, offspring.mid, seq_length, info->edges);
+                offspring.evaluated = true;
             }
         }
-        //Disable the available flag.
-        ea->mutate_mutex[idx].lock();
-        ea->mutate_flag[idx] = false;
-        ea->mutate_mutex[idx].unlock();
-        //Process the data based on the threads.
+    }
+}
+
+void ordering_offspring_worker(const int32_t idx, const int32_t threads, const ORDERING_INFO* info, size_t seq_bytes, ORDERING_EA* ea)
+{
+    int32_t start_idx, end_idx;
+    {
+        //The range always starts at a pair.
+        int32_t step = (ea->num_of_seqs + threads - 1) / threads;
+        step += step & 1;
+        start_idx = idx * step;
+        end_idx = start_idx + step;
+        if (start_idx > ea->num_of_seqs)
         {
-            ea->complete_thread_lock.lock();
-            ++ea->mutate_complete_counter;
-            ea->complete_thread_lock.unlock();
+            start_idx = ea->num_of_seqs;
+        }
+        if (end_idx > ea->num_of_seqs)
+        {
+            end_idx = ea->num_of_seqs;
         }
     }
+    //Generate, mutate and evaluate the offsprings in thread range.
+    ordering_generate_range(ea, info, start_idx, end_idx, seq_bytes);
 }
 
 inline void ordering_update_best(ORDERING_EA& ea, size_t seq_bytes)
@@ -393,18 +463,259 @@ inline void ordering_update_best(ORDERING_EA& ea, size_t seq_bytes)
     }
 }
 
+inline void ordering_ea_init_seq(const ORDERING_INFO& info, int32_t i, ORDERING_TIG* seq, size_t seq_bytes)
+{
+    //The constructed tours are placed right after the initial genome.
+    if (i > 0 && static_cast<size_t>(i) <= info.seeds.size())
+    {
+        memcpy(seq, info.seeds[i - 1].data(), seq_bytes);
+    }
+    else
+    {
+        memcpy(seq, info.init_genome, seq_bytes);
+    }
+}
+
 void ordering_ea_init(const HMR_CONTIG_ID_VEC& contig_group, const HMR_NODES& contigs, ORDERING_INFO& info)
 {
-    //Loop for all the ids in the group.
+    //Loop for all the ids in the group, the genome uses the local index of the contigs.
     for (size_t i = 0; i < contig_group.size(); ++i)
     {
-        info.init_genome[i].index = contig_group[i];
+        info.init_genome[i].index = static_cast<int32_t>(std::lower_bound(info.contig_ids.begin(), info.contig_ids.end(), contig_group[i]) - info.contig_ids.begin());
         info.init_genome[i].length = contigs[contig_group[i]].length;
     }
 }
 
-HMR_CONTIG_ID_VEC ordering_ea_optimize(int32_t phase, int npop, int ngen, uint64_t maxgen, double mutapb, ORDERING_INFO& info, std::mt19937_64& rng, int threads)
+void ordering_ea_report_speed(int32_t phase, uint64_t generations, std::chrono::steady_clock::time_point start)
+{
+    //Report the evolving speed, the main measurement of the inner loop cost.
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    time_print("EA Phase %d, %llu generation(s) in %.2lf second(s), %.1lf generation(s) per second.", phase,
+        static_cast<unsigned long long>(generations), seconds, seconds > 0.0 ? static_cast<double>(generations) / seconds : 0.0);
+    hmr_stats_stage_time("ordering.ea_evolve", seconds);
+    hmr_stats_count("ordering.ea_generations", generations);
+}
+
+inline void ordering_island_update_best(ORDERING_ISLANDS* islands, const ORDERING_EVA& best_eva)
+{
+    double best_score = -best_eva.score;
+    if (best_score <= islands->best_score.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    //Only an improvement needs the lock, check it again inside.
+    std::lock_guard<std::mutex> best_guard(islands->best_lock);
+    if (best_score > islands->best_score.load(std::memory_order_relaxed))
+    {
+        memcpy(islands->best_seq, best_eva.seq, islands->seq_bytes);
+        islands->best_score.store(best_score, std::memory_order_relaxed);
+        islands->improvements.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ordering_island_migrate(int32_t idx, ORDERING_ISLANDS* islands, ORDERING_EVA* current, bool send)
+{
+    const int32_t island_pop = islands->island_pop, seq_length = islands->info->contig_size;
+    //Send the elite to the next island when its inbox is empty.
+    if (send)
+    {
+        ORDERING_MIGRANT& outbox = islands->inboxes[(idx + 1) % islands->num_of_islands];
+        if (!outbox.full.load(std::memory_order_acquire))
+        {
+            memcpy(outbox.seq, current[0].seq, islands->seq_bytes);
+            memcpy(outbox.mid, current[0].mid, sizeof(double) * seq_length);
+            outbox.score = current[0].score;
+            outbox.full.store(true, std::memory_order_release);
+        }
+    }
+    //Replace the worst individual by the received migrant.
+    ORDERING_MIGRANT& inbox = islands->inboxes[idx];
+    if (inbox.full.load(std::memory_order_acquire))
+    {
+        ORDERING_EVA& worst = current[island_pop - 1];
+        memcpy(worst.seq, inbox.seq, islands->seq_bytes);
+        memcpy(worst.mid, inbox.mid, sizeof(double) * seq_length);
+        worst.score = inbox.score;
+        worst.evaluated = true;
+        inbox.full.store(false, std::memory_order_release);
+        //Keep the population sorted.
+        for (int32_t i = island_pop - 1; i > 0 && current[i].score < current[i - 1].score; --i)
+        {
+            std::swap(current[i], current[i - 1]);
+        }
+    }
+}
+
+void ordering_island_worker(const int32_t idx, ORDERING_ISLANDS* islands)
 {
+    const ORDERING_INFO* info = islands->info;
+    const int32_t island_pop = islands->island_pop, seq_length = info->contig_size;
+    const size_t seq_bytes = islands->seq_bytes;
+    //Allocate the double buffer of the island.
+    ORDERING_TIG* buffer1 = static_cast<ORDERING_TIG*>(malloc(seq_bytes * island_pop)),
+        * buffer2 = static_cast<ORDERING_TIG*>(malloc(seq_bytes * island_pop));
+    double* mid1 = static_cast<double*>(malloc(sizeof(double) * seq_length * island_pop)),
+        * mid2 = static_cast<double*>(malloc(sizeof(double) * seq_length * island_pop));
+    ORDERING_EVA* current = static_cast<ORDERING_EVA*>(malloc(sizeof(ORDERING_EVA) * island_pop)),
+        * target = static_cast<ORDERING_EVA*>(malloc(sizeof(ORDERING_EVA) * island_pop));
+    if (!buffer1 || !buffer2 || !mid1 || !mid2 || !current || !target)
+    {
+        time_error(-1, "Failed to allocate memory for EA island %d.", idx);
+    }
+    ORDERING_RNG rng{ islands->seeds[idx] };
+    std::uniform_real_distribution<double> rate(0.0, 1.0);
+    //Initial the island population.
+    for (int32_t i = 0; i < island_pop; ++i)
+    {
+        current[i].seq = buffer1 + i * seq_length;
+        current[i].mid = mid1 + i * seq_length;
+        ordering_ea_init_seq(*info, i, current[i].seq, seq_bytes);
+        if (islands->phase == 0 && (idx || i))
+        {
+            std::shuffle(current[i].seq, current[i].seq + seq_length, rng);
+        }
+        current[i].evaluated = false;
+    }
+    ordering_evaluate_calc(current, island_pop, seq_length, info->edges);
+    ordering_evaluate_sort(current, island_pop);
+    ordering_island_update_best(islands, current[0]);
+    ORDERING_TIG* target_buffer = buffer2;
+    double* target_mid = mid2;
+    uint64_t seen_improvements = islands->improvements.load(std::memory_order_relaxed), idle_start = 0, generation;
+    for (generation = 0; generation < islands->maxgen; ++generation)
+    {
+        if (islands->stop.load(std::memory_order_relaxed))
+        {
+            break;
+        }
+        //Convergence criteria, no island improves the best score in ngen generations.
+        uint64_t improvements = islands->improvements.load(std::memory_order_relaxed);
+        if (improvements != seen_improvements)
+        {
+            seen_improvements = improvements;
+            idle_start = generation;
+        }
+        if (generation - idle_start > static_cast<uint64_t>(islands->ngen))
+        {
+            islands->stop.store(true, std::memory_order_relaxed);
+            break;
+        }
+        //Generate, mutate and evaluate the offsprings.
+        for (int32_t i = 0; i < island_pop; ++i)
+        {
+            target[i].seq = target_buffer + i * seq_length;
+            target[i].mid = target_mid + i * seq_length;
+        }
+        ordering_generate_offsprings(current, target, 0, island_pop, island_pop, seq_bytes, rng);
+        for (int32_t i = 0; i < island_pop; ++i)
+        {
+            if (rate(rng) < islands->mut_rate)
+            {
+                ordering_mutate(target[i], seq_length, info->edges, rng);
+            }
+        }
+        ordering_evaluate_calc(target, island_pop, seq_length, info->edges);
+        ordering_evaluate_sort(target, island_pop);
+        //Swap the target and current.
+        std::swap(current, target);
+        target_buffer = target_buffer == buffer1 ? buffer2 : buffer1;
+        target_mid = target_mid == mid1 ? mid2 : mid1;
+        ordering_island_migrate(idx, islands, current, (generation + 1) % islands->migration == 0);
+        ordering_island_update_best(islands, current[0]);
+        if (idx == 0 && (generation + 1) % 500 == 0)
+        {
+            time_print("EA Phase %d, Generation %-12dscore: %.5lf", islands->phase, generation + 1, islands->best_score.load(std::memory_order_relaxed));
+        }
+    }
+    islands->generations.fetch_add(generation, std::memory_order_relaxed);
+    free(buffer1);
+    free(buffer2);
+    free(mid1);
+    free(mid2);
+    free(current);
+    free(target);
+}
+
+HMR_CONTIG_ID_VEC ordering_ea_optimize_islands(int32_t phase, int npop, int ngen, uint64_t maxgen, double mutapb, ORDERING_INFO& info, std::mt19937_64& rng, int threads, int migration)
+{
+    ORDERING_ISLANDS islands;
+    islands.info = &info;
+    islands.phase = phase;
+    islands.num_of_islands = threads < 1 ? 1 : threads;
+    //Split the population into the islands, the tournament needs at least 4 candidates.
+    islands.island_pop = (npop + islands.num_of_islands - 1) / islands.num_of_islands;
+    if (islands.island_pop < 4)
+    {
+        islands.island_pop = 4;
+    }
+    islands.ngen = ngen;
+    islands.migration = migration;
+    islands.maxgen = maxgen;
+    islands.mut_rate = mutapb;
+    islands.seq_bytes = sizeof(ORDERING_TIG) * info.contig_size;
+    islands.stop = false;
+    islands.improvements = 0;
+    islands.generations = 0;
+    islands.best_score = -std::numeric_limits<double>::max();
+    islands.best_seq = static_cast<ORDERING_TIG*>(malloc(islands.seq_bytes));
+    islands.seeds = new uint64_t[islands.num_of_islands];
+    islands.inboxes = new ORDERING_MIGRANT[islands.num_of_islands];
+    if (!islands.best_seq)
+    {
+        time_error(-1, "Failed to allocate memory for EA algorithm.");
+    }
+    std::mt19937_64 ea_rng(rng());
+    for (int32_t i = 0; i < islands.num_of_islands; ++i)
+    {
+        islands.seeds[i] = ea_rng();
+        islands.inboxes[i].seq = static_cast<ORDERING_TIG*>(malloc(islands.seq_bytes));
+        islands.inboxes[i].mid = static_cast<double*>(malloc(sizeof(double) * info.contig_size));
+        islands.inboxes[i].full = false;
+        if (!islands.inboxes[i].seq || !islands.inboxes[i].mid)
+        {
+            time_error(-1, "Failed to allocate memory for EA migration.");
+        }
+    }
+    time_print("EA Phase %d, %d island(s) of %d sequences, migrate every %d generations.", phase, islands.num_of_islands, islands.island_pop, migration);
+    //Evolve all the islands.
+    auto evolve_start = std::chrono::steady_clock::now();
+    {
+        //The islands never block on each other, so they run as plain tasks.
+        hmr::task_scheduler scheduler(islands.num_of_islands);
+        hmr::task_group island_group(scheduler);
+        for (int32_t i = 0; i < islands.num_of_islands; ++i)
+        {
+            island_group.run([&islands, i] { ordering_island_worker(i, &islands); });
+        }
+        island_group.wait();
+    }
+    time_print("EA Phase %d, %llu island generation(s) evolved, score: %.5lf", phase, static_cast<unsigned long long>(islands.generations.load()), islands.best_score.load());
+    ordering_ea_report_speed(phase, islands.generations.load(), evolve_start);
+    for (int32_t i = 0; i < islands.num_of_islands; ++i)
+    {
+        free(islands.inboxes[i].seq);
+        free(islands.inboxes[i].mid);
+    }
+    delete[] islands.inboxes;
+    delete[] islands.seeds;
+    //Extract the sequence from the best result of all islands.
+    HMR_CONTIG_ID_VEC ea_result;
+    ea_result.resize(info.contig_size);
+    for (int32_t i = 0; i < info.contig_size; ++i)
+    {
+        ea_result[i] = info.contig_ids[islands.best_seq[i].index];
+    }
+    free(islands.best_seq);
+    return ea_result;
+}
+
+HMR_CONTIG_ID_VEC ordering_ea_optimize(int32_t phase, int npop, int ngen, uint64_t maxgen, double mutapb, ORDERING_INFO& info, std::mt19937_64& rng, int threads, int migration)
+{
+    //Each thread evolves its own population in island mode.
+    if (migration > 0)
+    {
+        return ordering_ea_optimize_islands(phase, npop, ngen, maxgen, mutapb, info, rng, threads, migration);
+    }
     //Configure the threads.
     bool is_single = threads < 2;
     ORDERING_EA ea;
@@ -417,43 +728,33 @@ HMR_CONTIG_ID_VEC ordering_ea_optimize(int32_t phase, int npop, int ngen, uint64
         buffer_bytes = ea.num_of_seqs * seq_bytes;
     ea.buffer1 = static_cast<ORDERING_TIG*>(malloc(buffer_bytes));
     ea.buffer2 = static_cast<ORDERING_TIG*>(malloc(buffer_bytes));
+    size_t mid_bytes = sizeof(double) * info.contig_size * ea.num_of_seqs;
+    ea.mid1 = static_cast<double*>(malloc(mid_bytes));
+    ea.mid2 = static_cast<double*>(malloc(mid_bytes));
     size_t eva_bytes = sizeof(ORDERING_EVA) * ea.num_of_seqs;
     ea.eva1 = static_cast<ORDERING_EVA*>(malloc(eva_bytes));
     ea.eva2 = static_cast<ORDERING_EVA*>(malloc(eva_bytes));
-    if (!ea.buffer1 || !ea.buffer2 || !ea.eva1 || !ea.eva2)
+    if (!ea.buffer1 || !ea.buffer2 || !ea.mid1 || !ea.mid2 || !ea.eva1 || !ea.eva2)
     {
         time_error(-1, "Failed to allocate memory for EA algorithm.");
     }
     //Prepare the threads when necessary.
-    std::thread* mutate_workers = NULL;
-    if (!is_single)
-    {
-        mutate_workers = new std::thread[threads];
-        ea.mutate_flag = new bool[threads];
-        ea.mutate_seeds = new uint64_t[threads];
-        ea.mutate_mutex = new std::mutex[threads];
-        ea.mutate_exit = false;
-        for (int32_t i = 0; i < threads; ++i)
-        {
-            ea.mutate_seeds[i] = ea.rng();
-            ea.mutate_flag[i] = false;
-            mutate_workers[i] = std::thread(ordering_offspring_worker, i, threads, &info, seq_bytes, &ea);
-        }
-    }
+    hmr::task_scheduler* scheduler = is_single ? NULL : new hmr::task_scheduler(threads);
     //Activate sequence 1.
     ea.reversed = false;
     ea.current_eva = ea.eva1;
     ea.target_eva = ea.eva2;
     ea.target_buffer = ea.buffer2;
-    std::uniform_real_distribution<double> rate(0.0, 1.0);
+    ea.target_mid = ea.mid2;
     //Initial the evaluation seqs to current buffer.
     for (int32_t i = 0; i < ea.num_of_seqs; ++i)
     {
         //Set and initialize the buffer1.
         off_t seq_offset = i * info.contig_size;
         ea.eva1[i].seq = ea.buffer1 + seq_offset;
+        ea.eva1[i].mid = ea.mid1 + seq_offset;
         //Initialize the sequences.
-        memcpy(ea.eva1[i].seq, info.init_genome, seq_bytes);
+        ordering_ea_init_seq(info, i, ea.eva1[i].seq, seq_bytes);
         //Shuffle the odd sequences.
         if (phase == 0 && i)
         {
@@ -475,6 +776,7 @@ HMR_CONTIG_ID_VEC ordering_ea_optimize(int32_t phase, int npop, int ngen, uint64
     time_print("EA Phase %d, Generation %-12dscore: %.5lf", phase, ea.generations, ea.best_score);
     //Run EA algorithm with the configuration above.
     uint32_t ui_gen_counter = 0;
+    auto evolve_start = std::chrono::steady_clock::now();
     for (ea.generations = 0; ea.generations < maxgen; ++ea.generations)
     {
         //Convergence criteria.
@@ -483,45 +785,29 @@ HMR_CONTIG_ID_VEC ordering_ea_optimize(int32_t phase, int npop, int ngen, uint64
             //Meet the requirement, so we quit.
             break;
         }
-        //Prepare the generation random generator.
-        std::mt19937_64 gen_rng(ea.rng());
+        //Prepare the generation random seed.
+        ea.gen_seed = ea.rng();
         //Reset the target eva positions.
         for (int32_t i = 0; i < ea.num_of_seqs; ++i)
         {
             ea.target_eva[i].seq = ea.target_buffer + i * info.contig_size;
+            ea.target_eva[i].mid = ea.target_mid + i * info.contig_size;
         }
         //Mutate the candidates.
         if (is_single)
         {
             //Generate the offspring at target eva matrix.
-            ordering_generate_offsprings(ea.current_eva, ea.target_eva, 0, ea.num_of_seqs, ea.num_of_seqs, seq_bytes, gen_rng);
-            //Mutate the offsprings.
-            for (int32_t i = 0; i < ea.num_of_seqs; ++i)
-            {
-                if (rate(gen_rng) < ea.mut_rate)
-                {
-                    ordering_mutate(ea.target_eva[i], info.contig_size, gen_rng);
-                }
-            }
-            ordering_evaluate_calc(ea.target_eva, ea.num_of_seqs, info.contig_size, info.edges);
+            ordering_generate_range(&ea, &info, 0, ea.num_of_seqs, seq_bytes);
         }
         else
         {
-            ea.complete_thread_lock.lock();
-            ea.mutate_complete_counter = 0;
-            ea.complete_thread_lock.unlock();
-            //Reset the thread start flag.
+            //Each generation forks the offspring ranges and joins them before sorting.
+            hmr::task_group offspring_group(*scheduler);
             for (int32_t i = 0; i < threads; ++i)
             {
-                ea.mutate_mutex[i].lock();
-                ea.mutate_flag[i] = true;
-                ea.mutate_mutex[i].unlock();
-            }
-            //Wait for everyone complete working.
-            while(ea.mutate_complete_counter != threads)
-            {
-                std::this_thread::sleep_for(std::chrono::nanoseconds(1));
+                offspring_group.run([&ea, &info, seq_bytes, threads, i] { ordering_offspring_worker(i, threads, &info, seq_bytes, &ea); });
             }
+            offspring_group.wait();
         }
         //Sort the target buffer.
         ordering_evaluate_sort(ea.target_eva, ea.num_of_seqs);
@@ -543,6 +829,7 @@ HMR_CONTIG_ID_VEC ordering_ea_optimize(int32_t phase, int npop, int ngen, uint64
             ea.current_eva = ea.eva1;
             ea.target_eva = ea.eva2;
             ea.target_buffer = ea.buffer2;
+            ea.target_mid = ea.mid2;
         }
         else
         {
@@ -550,30 +837,17 @@ HMR_CONTIG_ID_VEC ordering_ea_optimize(int32_t phase, int npop, int ngen, uint64
             ea.current_eva = ea.eva2;
             ea.target_eva = ea.eva1;
             ea.target_buffer = ea.buffer1;
+            ea.target_mid = ea.mid1;
         }
     }
+    ordering_ea_report_speed(phase, ea.generations, evolve_start);
     //Recover the memory of the multi-threads.
-    if (!is_single)
-    {
-        ea.mutate_exit = true;
-        //Request everyone to exit.
-        for (int32_t i = 0; i < threads; ++i)
-        {
-            ea.mutate_flag[i] = true;
-        }
-        //Request to kill all the threads.
-        for (int32_t i = 0; i < threads; ++i)
-        {
-            mutate_workers[i].join();
-        }
-        delete[] ea.mutate_mutex;
-        delete[] ea.mutate_seeds;
-        delete[] ea.mutate_flag;
-        delete[] mutate_workers;
-    }
+    delete scheduler;
     //Recovery the buffer memory.
     free(ea.buffer1);
     free(ea.buffer2);
+    free(ea.mid1);
+    free(ea.mid2);
     free(ea.eva1);
     free(ea.eva2);
     //Extract the sequence from the best history result.
@@ -581,7 +855,8 @@ HMR_CONTIG_ID_VEC ordering_ea_optimize(int32_t phase, int npop, int ngen, uint64
     ea_result.resize(info.contig_size);
     for (int32_t i = 0; i < info.contig_size; ++i)
     {
-        ea_result[i] = ea.best_seq[i].index;
+        ea_result[i] = info.contig_ids[ea.best_seq[i].index];
     }
+    free(ea.best_seq);
     return ea_result;
 }
@@ -5,7 +5,13 @@
 
 #include "ordering_type.hpp"
 
+/* Score of the sequence, the contig midpoints are updated as well */
+double ordering_evaluate_sequence(ORDERING_TIG* seq, double* mid, int32_t seq_length, const ORDERING_LINKS& edges);
+/* Score of the pairs across the rigid blocks [p, split_a), [split_a, split_b) and [split_b, q] */
+double ordering_evaluate_window(const ORDERING_TIG* seq, const double* mid, int32_t seq_length, int32_t p, int32_t q, int32_t split_a, int32_t split_b, const ORDERING_LINKS& edges);
+void ordering_update_mid(const ORDERING_TIG* seq, double* mid, int32_t p, int32_t q);
+
 void ordering_ea_init(const HMR_CONTIG_ID_VEC& contig_group, const HMR_NODES& contigs, ORDERING_INFO& info);
-HMR_CONTIG_ID_VEC ordering_ea_optimize(int32_t phase, int npop, int ngen, uint64_t maxgen, double mutapb, ORDERING_INFO& info, std::mt19937_64& rng, int threads);
+HMR_CONTIG_ID_VEC ordering_ea_optimize(int32_t phase, int npop, int ngen, uint64_t maxgen, double mutapb, ORDERING_INFO& info, std::mt19937_64& rng, int threads, int migration);
 
 #endif // ORDERING_EA_H
@@ -0,0 +1,309 @@
+#include <algorithm>
+
+#include "hmr_ui.hpp"
+
+#include "ordering_links.hpp"
+
+//The vector kernels are built with the function target attributes and selected by the running CPU.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ORDERING_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+//Groups within the limit use a dense matrix (64M of floats at most).
+constexpr int32_t ORDERING_DENSE_LIMIT = 4096;
+
+void ordering_links_init(ORDERING_LINKS& links, int32_t size, const std::vector<ORDERING_LINK>& edges)
+{
+    links.size = size;
+    links.dense = size <= ORDERING_DENSE_LIMIT;
+    if (links.dense)
+    {
+        //Fill both directions of the matrix.
+        links.matrix.assign(static_cast<size_t>(size) * size, 0.0f);
+        for (const ORDERING_LINK& edge : edges)
+        {
+            links.matrix[static_cast<size_t>(edge.a) * size + edge.b] = edge.count;
+            links.matrix[static_cast<size_t>(edge.b) * size + edge.a] = edge.count;
+        }
+        //Mark the non-zero counts, the matrix is 32 times larger than the bits.
+        links.linked_words = (size + 31) >> 5;
+        links.linked.assign(static_cast<size_t>(links.linked_words) * size, 0);
+        for (int32_t a = 0; a < size; ++a)
+        {
+            const float* row = links.matrix.data() + static_cast<size_t>(a) * size;
+            uint32_t* linked = links.linked.data() + static_cast<size_t>(a) * links.linked_words;
+            for (int32_t b = 0; b < size; ++b)
+            {
+                if (row[b] != 0.0f)
+                {
+                    linked[b >> 5] |= 1U << (b & 31);
+                }
+            }
+        }
+        return;
+    }
+    //Count the neighbours of each contig.
+    links.offsets.assign(size + 1, 0);
+    for (const ORDERING_LINK& edge : edges)
+    {
+        ++links.offsets[edge.a + 1];
+        ++links.offsets[edge.b + 1];
+    }
+    for (int32_t i = 0; i < size; ++i)
+    {
+        links.offsets[i + 1] += links.offsets[i];
+    }
+    //Fill the neighbours, then sort each row.
+    links.neighbours.resize(links.offsets[size]);
+    links.counts.resize(links.offsets[size]);
+    {
+        std::vector<int32_t> row_pos(links.offsets.begin(), links.offsets.end() - 1);
+        std::vector<ORDERING_LINK> row_links(links.offsets[size]);
+        for (const ORDERING_LINK& edge : edges)
+        {
+            row_links[row_pos[edge.a]++] = ORDERING_LINK{ edge.a, edge.b, edge.count };
+            row_links[row_pos[edge.b]++] = ORDERING_LINK{ edge.b, edge.a, edge.count };
+        }
+        for (int32_t i = 0; i < size; ++i)
+        {
+            std::stable_sort(row_links.begin() + links.offsets[i], row_links.begin() + links.offsets[i + 1],
+                [](const ORDERING_LINK& lhs, const ORDERING_LINK& rhs)
+                {
+                    return lhs.b < rhs.b;
+                });
+        }
+        //Merge the duplicated pairs, the last link is kept as the dense matrix does.
+        std::vector<int32_t> unique_offsets(size + 1, 0);
+        int32_t total = 0;
+        for (int32_t i = 0; i < size; ++i)
+        {
+            unique_offsets[i] = total;
+            for (int32_t k = links.offsets[i]; k < links.offsets[i + 1]; ++k)
+            {
+                if (total > unique_offsets[i] && links.neighbours[total - 1] == row_links[k].b)
+                {
+                    links.counts[total - 1] = row_links[k].count;
+                    continue;
+                }
+                links.neighbours[total] = row_links[k].b;
+                links.counts[total] = row_links[k].count;
+                ++total;
+            }
+        }
+        unique_offsets[size] = total;
+        links.offsets.swap(unique_offsets);
+        links.neighbours.resize(total);
+        links.counts.resize(total);
+    }
+    //Build the hash slots of each row, the slot size is a power of 2 no less than twice of the neighbours.
+    links.slot_offsets.assign(size + 1, 0);
+    for (int32_t i = 0; i < size; ++i)
+    {
+        int32_t degree = links.offsets[i + 1] - links.offsets[i], slot_size = 0;
+        if (degree > 0)
+        {
+            slot_size = 2;
+            while (slot_size < (degree << 1))
+            {
+                slot_size <<= 1;
+            }
+        }
+        links.slot_offsets[i + 1] = links.slot_offsets[i] + slot_size;
+    }
+    links.slots.assign(links.slot_offsets[size], -1);
+    for (int32_t i = 0; i < size; ++i)
+    {
+        int32_t slot_start = links.slot_offsets[i], mask = links.slot_offsets[i + 1] - slot_start - 1;
+        for (int32_t pos = links.offsets[i]; pos < links.offsets[i + 1]; ++pos)
+        {
+            int32_t k = (static_cast<uint32_t>(links.neighbours[pos]) * 2654435761U) & mask;
+            while (links.slots[slot_start + k] != -1)
+            {
+                k = (k + 1) & mask;
+            }
+            links.slots[slot_start + k] = pos;
+        }
+    }
+    time_print("Group has %d contigs, sparse link lists are used.", size);
+}
+
+void ordering_links_edges(const ORDERING_LINKS& links, std::vector<ORDERING_LINK>& edges)
+{
+    edges.clear();
+    for (int32_t a = 0; a < links.size; ++a)
+    {
+        if (links.dense)
+        {
+            const float* row = links.matrix.data() + static_cast<size_t>(a) * links.size;
+            for (int32_t b = a + 1; b < links.size; ++b)
+            {
+                if (row[b] > 0.0f)
+                {
+                    edges.emplace_back(ORDERING_LINK{ a, b, row[b] });
+                }
+            }
+        }
+        else
+        {
+            for (int32_t k = links.offsets[a]; k < links.offsets[a + 1]; ++k)
+            {
+                if (links.neighbours[k] > a && links.counts[k] > 0.0f)
+                {
+                    edges.emplace_back(ORDERING_LINK{ a, links.neighbours[k], links.counts[k] });
+                }
+            }
+        }
+    }
+}
+
+inline bool ordering_row_linked(const uint32_t* linked, int32_t id)
+{
+    return (linked[id >> 5] >> (id & 31)) & 1U;
+}
+
+double ordering_row_sum_scalar(const float* row, const uint32_t* linked, double a_mid, const ORDERING_TIG* seq, const double* mid, int32_t from, int32_t to)
+{
+    //Four independent lanes, the vector kernels keep exactly the same lanes and order.
+    //The pairs without links are skipped, the sum does not change since adding +0.0 is exact.
+    double lanes[4] = { 0.0, 0.0, 0.0, 0.0 };
+    int32_t j = from;
+    for (; j + 4 <= to; j += 4)
+    {
+        for (int32_t k = 0; k < 4; ++k)
+        {
+            int32_t id = seq[j + k].index;
+            if (ordering_row_linked(linked, id))
+            {
+                lanes[k] += static_cast<double>(row[id]) / fabs(mid[j + k] - a_mid);
+            }
+        }
+    }
+    for (; j < to; ++j)
+    {
+        int32_t id = seq[j].index;
+        if (ordering_row_linked(linked, id))
+        {
+            lanes[0] += static_cast<double>(row[id]) / fabs(mid[j] - a_mid);
+        }
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+#ifdef ORDERING_X86_KERNELS
+__attribute__((target("avx2")))
+inline __m128i ordering_row_linked_avx2(const uint32_t* linked, __m128i ids)
+{
+    //Test the link bits of 4 indices, the lane is all ones when the pair is linked.
+    __m128i words = _mm_i32gather_epi32(reinterpret_cast<const int*>(linked), _mm_srli_epi32(ids, 5), 4);
+    __m128i bits = _mm_and_si128(_mm_srlv_epi32(words, _mm_and_si128(ids, _mm_set1_epi32(31))), _mm_set1_epi32(1));
+    return _mm_cmpeq_epi32(bits, _mm_set1_epi32(1));
+}
+
+__attribute__((target("avx2")))
+inline __m256d ordering_row_terms_avx2(const float* row, const uint32_t* linked, __m256d a_mid, const ORDERING_TIG* seq, const double* mid, bool& any_linked)
+{
+    //Pick the 4 indices out of the interleaved (index, length) pairs.
+    __m256i tigs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(seq));
+    __m128i ids = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(tigs, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+    __m128i mask = ordering_row_linked_avx2(linked, ids);
+    any_linked = !_mm_testz_si128(mask, mask);
+    if (!any_linked)
+    {
+        return _mm256_setzero_pd();
+    }
+    //Only the linked weights are read from the matrix, the others stay +0.0.
+    __m256d weights = _mm256_cvtps_pd(_mm_mask_i32gather_ps(_mm_setzero_ps(), row, ids, _mm_castsi128_ps(mask), 4));
+    __m256d distances = _mm256_andnot_pd(_mm256_set1_pd(-0.0), _mm256_sub_pd(_mm256_loadu_pd(mid), a_mid));
+    return _mm256_div_pd(weights, distances);
+}
+
+__attribute__((target("avx2")))
+inline double ordering_row_sum_tail(__m256d lanes_vec, const float* row, const uint32_t* linked, double a_mid, const ORDERING_TIG* seq, const double* mid, int32_t j, int32_t to)
+{
+    double lanes[4];
+    _mm256_storeu_pd(lanes, lanes_vec);
+    for (; j < to; ++j)
+    {
+        int32_t id = seq[j].index;
+        if (ordering_row_linked(linked, id))
+        {
+            lanes[0] += static_cast<double>(row[id]) / fabs(mid[j] - a_mid);
+        }
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+__attribute__((target("avx2")))
+double ordering_row_sum_avx2(const float* row, const uint32_t* linked, double a_mid, const ORDERING_TIG* seq, const double* mid, int32_t from, int32_t to)
+{
+    //One vector holds the four scalar lanes, so the sum is bit identical to the scalar kernel.
+    __m256d lanes = _mm256_setzero_pd(), a_mid_vec = _mm256_set1_pd(a_mid);
+    int32_t j = from;
+    bool any_linked;
+    for (; j + 4 <= to; j += 4)
+    {
+        __m256d terms = ordering_row_terms_avx2(row, linked, a_mid_vec, seq + j, mid + j, any_linked);
+        if (any_linked)
+        {
+            lanes = _mm256_add_pd(lanes, terms);
+        }
+    }
+    return ordering_row_sum_tail(lanes, row, linked, a_mid, seq, mid, j, to);
+}
+
+__attribute__((target("avx512f,avx2")))
+double ordering_row_sum_avx512(const float* row, const uint32_t* linked, double a_mid, const ORDERING_TIG* seq, const double* mid, int32_t from, int32_t to)
+{
+    //Compute 8 terms at once, the lower half is added before the upper half as the scalar lanes do.
+    __m256d lanes = _mm256_setzero_pd(), a_mid_vec = _mm256_set1_pd(a_mid);
+    const __m512d a_mid_wide = _mm512_set1_pd(a_mid);
+    const __m512i pick = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 0, 2, 4, 6, 8, 10, 12, 14);
+    int32_t j = from;
+    bool any_linked;
+    for (; j + 8 <= to; j += 8)
+    {
+        __m256i ids = _mm512_castsi512_si256(_mm512_permutexvar_epi32(pick, _mm512_loadu_si512(seq + j)));
+        __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(linked), _mm256_srli_epi32(ids, 5), 4);
+        __m256i bits = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(ids, _mm256_set1_epi32(31))), _mm256_set1_epi32(1));
+        __m256i mask = _mm256_cmpeq_epi32(bits, _mm256_set1_epi32(1));
+        if (_mm256_testz_si256(mask, mask))
+        {
+            continue;
+        }
+        __m512d weights = _mm512_cvtps_pd(_mm256_mask_i32gather_ps(_mm256_setzero_ps(), row, ids, _mm256_castsi256_ps(mask), 4));
+        __m512d distances = _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(mid + j), a_mid_wide));
+        __m512d terms = _mm512_div_pd(weights, distances);
+        lanes = _mm256_add_pd(lanes, _mm512_castpd512_pd256(terms));
+        lanes = _mm256_add_pd(lanes, _mm512_extractf64x4_pd(terms, 1));
+    }
+    if (j + 4 <= to)
+    {
+        __m256d terms = ordering_row_terms_avx2(row, linked, a_mid_vec, seq + j, mid + j, any_linked);
+        if (any_linked)
+        {
+            lanes = _mm256_add_pd(lanes, terms);
+        }
+        j += 4;
+    }
+    return ordering_row_sum_tail(lanes, row, linked, a_mid, seq, mid, j, to);
+}
+#endif
+
+ORDERING_ROW_KERNEL ordering_row_kernel_detect()
+{
+#ifdef ORDERING_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return ORDERING_ROW_KERNEL{ "AVX-512", ordering_row_sum_avx512 };
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return ORDERING_ROW_KERNEL{ "AVX2", ordering_row_sum_avx2 };
+    }
+#endif
+    return ORDERING_ROW_KERNEL{ "Scalar", ordering_row_sum_scalar };
+}
+
+const ORDERING_ROW_KERNEL ordering_row_kernel = ordering_row_kernel_detect();
@@ -0,0 +1,85 @@
+#ifndef ORDERING_LINKS_H
+#define ORDERING_LINKS_H
+
+#include <cmath>
+#include <cstdint>
+
+#include "ordering_type.hpp"
+
+/* Build the link storage from the local index edges, the dense matrix is used for small groups */
+void ordering_links_init(ORDERING_LINKS& links, int32_t size, const std::vector<ORDERING_LINK>& edges);
+/* List the links once for each contig pair, a < b */
+void ordering_links_edges(const ORDERING_LINKS& links, std::vector<ORDERING_LINK>& edges);
+
+inline float ordering_links_sparse_get(const ORDERING_LINKS& links, int32_t a, int32_t b)
+{
+    int32_t slot_start = links.slot_offsets[a], mask = links.slot_offsets[a + 1] - slot_start - 1;
+    if (mask < 0)
+    {
+        return 0.0f;
+    }
+    //Linear probing in the row slots.
+    for (int32_t k = (static_cast<uint32_t>(b) * 2654435761U) & mask; ; k = (k + 1) & mask)
+    {
+        int32_t pos = links.slots[slot_start + k];
+        if (pos == -1)
+        {
+            return 0.0f;
+        }
+        if (links.neighbours[pos] == b)
+        {
+            return links.counts[pos];
+        }
+    }
+}
+
+inline float ordering_links_get(const ORDERING_LINKS& links, int32_t a, int32_t b)
+{
+    return links.dense ? links.matrix[static_cast<size_t>(a) * links.size + b] : ordering_links_sparse_get(links, a, b);
+}
+
+/* Sum of row[seq[j].index] / |mid[j] - a_mid| for j in [from, to) of a dense matrix row and its link bits */
+typedef double (*ORDERING_ROW_SUM)(const float* row, const uint32_t* linked, double a_mid, const ORDERING_TIG* seq, const double* mid, int32_t from, int32_t to);
+
+typedef struct ORDERING_ROW_KERNEL
+{
+    const char* name;
+    ORDERING_ROW_SUM dense_sum;
+} ORDERING_ROW_KERNEL;
+
+/* The widest dense row kernel supported by the running CPU, selected at start */
+extern const ORDERING_ROW_KERNEL ordering_row_kernel;
+
+/* Sum of links(a, seq[j]) / |mid[j] - a_mid| for j in [from, to) */
+inline double ordering_links_row_sum(const ORDERING_LINKS& links, int32_t a, double a_mid, const ORDERING_TIG* seq, const double* mid, int32_t from, int32_t to)
+{
+    if (links.dense)
+    {
+        return ordering_row_kernel.dense_sum(links.matrix.data() + static_cast<size_t>(a) * links.size, links.linked.data() + static_cast<size_t>(a) * links.linked_words, a_mid, seq, mid, from, to);
+    }
+    //Four independent lanes, the summation order is fixed so the result never depends on the compiler or the kernel.
+    double lanes[4] = { 0.0, 0.0, 0.0, 0.0 };
+    int32_t j = from;
+    for (; j + 4 <= to; j += 4)
+    {
+        for (int32_t k = 0; k < 4; ++k)
+        {
+            float weight = ordering_links_sparse_get(links, a, seq[j + k].index);
+            if (weight != 0.0f)
+            {
+                lanes[k] += static_cast<double>(weight) / fabs(mid[j + k] - a_mid);
+            }
+        }
+    }
+    for (; j < to; ++j)
+    {
+        float weight = ordering_links_sparse_get(links, a, seq[j].index);
+        if (weight != 0.0f)
+        {
+            lanes[0] += static_cast<double>(weight) / fabs(mid[j] - a_mid);
+        }
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+#endif // ORDERING_LINKS_H
@@ -1,30 +1,23 @@
-#include "hmr_algorithm.hpp"
-
 #include "ordering_loader.hpp"
 
 void ordering_edge_map_size_proc(uint64_t, void*)
 {
 }
 
-inline void insert_edge(int32_t a, int32_t b, int32_t count, ORDERING_COUNTS& map)
+inline void insert_edge(int32_t a_id, int32_t b_id, int32_t count, ORDERING_EDGE_LOADER* loader)
 {
-    //Swap the b and a when necessary.
-    if (a > b)
-    {
-        hmr_swap(a, b);
-    }
-    //Do the insertion.
-    auto iter = map.find(a);
-    if (iter == map.end())
+    //Only save the edges that inside a group, using the local index of the contigs.
+    int32_t num_of_contigs = static_cast<int32_t>(loader->group_ids.size());
+    if (a_id >= num_of_contigs || b_id >= num_of_contigs)
     {
-        CONTIG_COUNTS b_weights;
-        b_weights.insert(std::make_pair(b, count));
-        map.insert(std::make_pair(a, b_weights));
+        return;
     }
-    else
+    int32_t group_id = loader->group_ids[a_id];
+    if (group_id == -1 || loader->group_ids[b_id] != group_id)
     {
-        iter->second.insert(std::make_pair(b, count));
+        return;
     }
+    loader->edges[group_id].emplace_back(ORDERING_LINK{ loader->local_ids[a_id], loader->local_ids[b_id], static_cast<float>(count) });
 }
 
 void ordering_edge_map_data_proc(HMR_EDGE_INFO* edges, int32_t edge_size, void* user)
@@ -34,11 +27,17 @@ void ordering_edge_map_data_proc(HMR_EDGE_INFO* edges, int32_t edge_size, void*
     for (int32_t i = 0; i < edge_size; ++i)
     {
         HMR_EDGE_INFO& edge_info = edges[i];
-        //Only save the edges that inside the group.
-        int32_t a_id = edge_info.start, b_id = edge_info.end;
-        if (hmr_in_ordered_vector(a_id, loader->contig_group) && hmr_in_ordered_vector(b_id, loader->contig_group))
-        {
-            insert_edge(a_id, b_id, static_cast<int32_t>(edge_info.pairs), loader->edges);
-        }
+        insert_edge(edge_info.start, edge_info.end, static_cast<int32_t>(edge_info.pairs), loader);
+    }
+}
+
+void ordering_undirected_edge_map_data_proc(HMR_UNDIRECTED_EDGE_INFO* edges, int32_t edge_size, void* user)
+{
+    ORDERING_EDGE_LOADER* loader = static_cast<ORDERING_EDGE_LOADER*>(user);
+    //Build the edge map, each contig pair only appears once.
+    for (int32_t i = 0; i < edge_size; ++i)
+    {
+        HMR_UNDIRECTED_EDGE_INFO& edge_info = edges[i];
+        insert_edge(edge_info.start, edge_info.end, static_cast<int32_t>(edge_info.pairs), loader);
     }
 }
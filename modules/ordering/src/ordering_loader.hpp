@@ -7,11 +7,13 @@
 
 typedef struct ORDERING_EDGE_LOADER
 {
-    const HMR_CONTIG_ID_VEC& contig_group;
-    ORDERING_COUNTS& edges;
+    const HMR_CONTIG_ID_VEC& group_ids; // Group of each contig, -1 for not in any group.
+    const HMR_CONTIG_ID_VEC& local_ids; // Local index of each contig in its group.
+    std::vector<std::vector<ORDERING_LINK> >& edges;
 } ORDERING_EDGE_LOADER;
 
 void ordering_edge_map_size_proc(uint64_t edge_size, void* user);
 void ordering_edge_map_data_proc(HMR_EDGE_INFO* edges, int32_t edge_size, void* user);
+void ordering_undirected_edge_map_data_proc(HMR_UNDIRECTED_EDGE_INFO* edges, int32_t edge_size, void* user);
 
 #endif // ORDERING_LOADER_H
@@ -0,0 +1,321 @@
+#include <algorithm>
+
+#include "hmr_task_scheduler.hpp"
+#include "hmr_ui.hpp"
+
+#include "ordering_ea.hpp"
+#include "ordering_links.hpp"
+
+#include "ordering_polish.hpp"
+
+//Number of the strongest linked contigs used as move candidates.
+constexpr int32_t ORDERING_POLISH_NEIGHBOURS = 8;
+//Longest segment a move could change.
+constexpr int32_t ORDERING_POLISH_MAX_SPAN = 256;
+//Longest block moved by Or-opt.
+constexpr int32_t ORDERING_POLISH_MAX_BLOCK = 3;
+constexpr int32_t ORDERING_POLISH_MAX_ROUNDS = 1000;
+//Score change below this is treated as no improvement, avoids looping on the rounding error.
+constexpr double ORDERING_POLISH_EPSILON = 1e-12;
+
+enum ORDERING_MOVE_TYPE
+{
+    ORDERING_MOVE_NONE,
+    ORDERING_MOVE_REVERSE,
+    ORDERING_MOVE_ROTATE
+};
+
+typedef struct ORDERING_MOVE
+{
+    //Reverse [p, q], or rotate [p, q] to move the first k contigs to the end.
+    int32_t type;
+    int32_t p, q, k;
+    double delta;
+} ORDERING_MOVE;
+
+typedef struct ORDERING_POLISH
+{
+    const ORDERING_INFO* info;
+    int32_t seq_length;
+    ORDERING_TIG* seq;
+    double* mid;
+    int32_t* pos;
+    std::vector<bool> active; // Positions to search in this round.
+    std::vector<int32_t> neighbours;
+    ORDERING_MOVE* best_moves;
+} ORDERING_POLISH;
+
+void ordering_polish_neighbours(const ORDERING_LINKS& links, std::vector<int32_t>& neighbours)
+{
+    //Find the strongest linked contigs of each contig.
+    int32_t size = links.size;
+    neighbours.assign(static_cast<size_t>(size) * ORDERING_POLISH_NEIGHBOURS, -1);
+    std::vector<std::pair<float, int32_t> > row;
+    for (int32_t a = 0; a < size; ++a)
+    {
+        row.clear();
+        if (links.dense)
+        {
+            const float* counts = links.matrix.data() + static_cast<size_t>(a) * size;
+            for (int32_t b = 0; b < size; ++b)
+            {
+                if (counts[b] > 0.0f && b != a)
+                {
+                    row.emplace_back(counts[b], b);
+                }
+            }
+        }
+        else
+        {
+            for (int32_t k = links.offsets[a]; k < links.offsets[a + 1]; ++k)
+            {
+                if (links.counts[k] > 0.0f && links.neighbours[k] != a)
+                {
+                    row.emplace_back(links.counts[k], links.neighbours[k]);
+                }
+            }
+        }
+        size_t top = std::min(row.size(), static_cast<size_t>(ORDERING_POLISH_NEIGHBOURS));
+        std::partial_sort(row.begin(), row.begin() + top, row.end(),
+            [](const std::pair<float, int32_t>& lhs, const std::pair<float, int32_t>& rhs)
+            {
+                return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+            });
+        for (size_t k = 0; k < top; ++k)
+        {
+            neighbours[static_cast<size_t>(a) * ORDERING_POLISH_NEIGHBOURS + k] = row[k].second;
+        }
+    }
+}
+
+inline void ordering_polish_apply(ORDERING_TIG* seq, double* mid, const ORDERING_MOVE& move, bool revert)
+{
+    if (move.type == ORDERING_MOVE_REVERSE)
+    {
+        std::reverse(seq + move.p, seq + move.q + 1);
+    }
+    else
+    {
+        //Rotate back by the rest of the window.
+        int32_t k = revert ? move.q - move.p + 1 - move.k : move.k;
+        std::rotate(seq + move.p, seq + move.p + k, seq + move.q + 1);
+    }
+    ordering_update_mid(seq, mid, move.p, move.q);
+}
+
+double ordering_polish_delta(ORDERING_TIG* seq, double* mid, int32_t seq_length, const ORDERING_MOVE& move, const ORDERING_LINKS& edges)
+{
+    //Only the pairs across the moved blocks change their distance.
+    int32_t split_a, split_b, after_a, after_b;
+    if (move.type == ORDERING_MOVE_REVERSE)
+    {
+        split_a = split_b = after_a = after_b = move.q + 1;
+    }
+    else
+    {
+        split_a = move.p + move.k;
+        after_a = move.q + 1 - move.k;
+        split_b = after_b = move.q + 1;
+    }
+    double before = ordering_evaluate_window(seq, mid, seq_length, move.p, move.q, split_a, split_b, edges);
+    ordering_polish_apply(seq, mid, move, false);
+    double after = ordering_evaluate_window(seq, mid, seq_length, move.p, move.q, after_a, after_b, edges);
+    ordering_polish_apply(seq, mid, move, true);
+    return after - before;
+}
+
+inline void ordering_polish_try(ORDERING_TIG* seq, double* mid, int32_t seq_length, const ORDERING_LINKS& edges,
+    int32_t type, int32_t p, int32_t q, int32_t k, ORDERING_MOVE& best)
+{
+    ORDERING_MOVE move{ type, p, q, k, 0.0 };
+    move.delta = ordering_polish_delta(seq, mid, seq_length, move, edges);
+    if (move.delta < best.delta)
+    {
+        best = move;
+    }
+}
+
+void ordering_polish_best_move(int32_t i, ORDERING_TIG* seq, double* mid, const ORDERING_POLISH* polish, ORDERING_MOVE& best)
+{
+    const ORDERING_LINKS& edges = polish->info->edges;
+    const int32_t seq_length = polish->seq_length;
+    best.type = ORDERING_MOVE_NONE;
+    best.delta = -ORDERING_POLISH_EPSILON;
+    //Adjacent swap.
+    if (i + 1 < seq_length)
+    {
+        ordering_polish_try(seq, mid, seq_length, edges, ORDERING_MOVE_ROTATE, i, i + 1, 1, best);
+    }
+    //Moves which make the contig adjacent to one of its neighbours.
+    const int32_t* neighbours = polish->neighbours.data() + static_cast<size_t>(seq[i].index) * ORDERING_POLISH_NEIGHBOURS;
+    for (int32_t n = 0; n < ORDERING_POLISH_NEIGHBOURS && neighbours[n] != -1; ++n)
+    {
+        int32_t j = polish->pos[neighbours[n]];
+        if (j > i + 1 && j - i <= ORDERING_POLISH_MAX_SPAN)
+        {
+            //2-opt, reverse [i + 1, j].
+            ordering_polish_try(seq, mid, seq_length, edges, ORDERING_MOVE_REVERSE, i + 1, j, 0, best);
+            //Or-opt, move the block starting at j right after i.
+            for (int32_t l = 1; l <= ORDERING_POLISH_MAX_BLOCK && j + l <= seq_length; ++l)
+            {
+                ordering_polish_try(seq, mid, seq_length, edges, ORDERING_MOVE_ROTATE, i + 1, j + l - 1, j - i - 1, best);
+            }
+        }
+        else if (j < i - 1 && i - j <= ORDERING_POLISH_MAX_SPAN)
+        {
+            //2-opt, reverse [j, i - 1].
+            ordering_polish_try(seq, mid, seq_length, edges, ORDERING_MOVE_REVERSE, j, i - 1, 0, best);
+            //Or-opt, move the block ending at j right before i.
+            for (int32_t l = 1; l <= ORDERING_POLISH_MAX_BLOCK && j - l + 1 >= 0; ++l)
+            {
+                ordering_polish_try(seq, mid, seq_length, edges, ORDERING_MOVE_ROTATE, j - l + 1, i - 1, l, best);
+            }
+        }
+    }
+}
+
+void ordering_polish_worker(const int32_t idx, const int32_t threads, ORDERING_POLISH* polish)
+{
+    //Each thread tries the moves on its own copy of the sequence.
+    const int32_t seq_length = polish->seq_length;
+    std::vector<ORDERING_TIG> seq(polish->seq, polish->seq + seq_length);
+    std::vector<double> mid(polish->mid, polish->mid + seq_length);
+    for (int32_t i = idx; i < seq_length; i += threads)
+    {
+        if (polish->active[i])
+        {
+            ordering_polish_best_move(i, seq.data(), mid.data(), polish, polish->best_moves[i]);
+        }
+        else
+        {
+            polish->best_moves[i].type = ORDERING_MOVE_NONE;
+        }
+    }
+}
+
+HMR_CONTIG_ID_VEC ordering_polish(ORDERING_INFO& info, int threads)
+{
+    ORDERING_POLISH polish;
+    polish.info = &info;
+    polish.seq_length = info.contig_size;
+    polish.seq = info.init_genome;
+    polish.mid = static_cast<double*>(malloc(sizeof(double) * polish.seq_length));
+    polish.pos = static_cast<int32_t*>(malloc(sizeof(int32_t) * polish.seq_length));
+    polish.best_moves = static_cast<ORDERING_MOVE*>(malloc(sizeof(ORDERING_MOVE) * polish.seq_length));
+    if (!polish.mid || !polish.pos || !polish.best_moves)
+    {
+        time_error(-1, "Failed to allocate memory for ordering polish.");
+    }
+    ordering_polish_neighbours(info.edges, polish.neighbours);
+    double score = ordering_evaluate_sequence(polish.seq, polish.mid, polish.seq_length, info.edges);
+    time_print("Polishing contig order, initial score: %.5lf", -score);
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+    std::vector<ORDERING_MOVE> moves;
+    std::vector<int32_t> touched;
+    //Search all positions in the first round, then only the positions around the applied moves.
+    polish.active.assign(polish.seq_length, true);
+    size_t total_moves = 0;
+    int32_t rounds;
+    for (int32_t i = 0; i < polish.seq_length; ++i)
+    {
+        polish.pos[polish.seq[i].index] = i;
+    }
+    //The workers are kept for all the rounds.
+    hmr::task_scheduler* scheduler = threads > 1 ? new hmr::task_scheduler(threads) : NULL;
+    for (rounds = 0; rounds < ORDERING_POLISH_MAX_ROUNDS; ++rounds)
+    {
+        //Find the best move at each position in parallel.
+        if (threads == 1)
+        {
+            ordering_polish_worker(0, 1, &polish);
+        }
+        else
+        {
+            hmr::task_group search_group(*scheduler);
+            for (int32_t i = 0; i < threads; ++i)
+            {
+                search_group.run([i, threads, &polish] { ordering_polish_worker(i, threads, &polish); });
+            }
+            search_group.wait();
+        }
+        //Apply the best moves first.
+        moves.clear();
+        for (int32_t i = 0; i < polish.seq_length; ++i)
+        {
+            if (polish.best_moves[i].type != ORDERING_MOVE_NONE)
+            {
+                moves.push_back(polish.best_moves[i]);
+            }
+        }
+        if (moves.empty())
+        {
+            break;
+        }
+        std::stable_sort(moves.begin(), moves.end(),
+            [](const ORDERING_MOVE& lhs, const ORDERING_MOVE& rhs)
+            {
+                return lhs.delta < rhs.delta;
+            });
+        std::fill(polish.active.begin(), polish.active.end(), false);
+        touched.clear();
+        size_t applied = 0;
+        for (const ORDERING_MOVE& move : moves)
+        {
+            //The applied moves may change the delta, check it again.
+            double delta = ordering_polish_delta(polish.seq, polish.mid, polish.seq_length, move, info.edges);
+            if (delta >= -ORDERING_POLISH_EPSILON)
+            {
+                continue;
+            }
+            ordering_polish_apply(polish.seq, polish.mid, move, false);
+            ++applied;
+            //Only the contigs at the block boundaries have new adjacent contigs.
+            int32_t bounds[3] = { move.p, move.q, move.type == ORDERING_MOVE_ROTATE ? move.q + 1 - move.k : move.p };
+            for (int32_t bound : bounds)
+            {
+                int32_t active_start = std::max(bound - ORDERING_POLISH_MAX_BLOCK - 1, 0),
+                    active_end = std::min(bound + ORDERING_POLISH_MAX_BLOCK + 1, polish.seq_length - 1);
+                for (int32_t i = active_start; i <= active_end; ++i)
+                {
+                    polish.active[i] = true;
+                    touched.push_back(polish.seq[i].index);
+                }
+            }
+        }
+        if (!applied)
+        {
+            break;
+        }
+        total_moves += applied;
+        //The neighbours of the touched contigs may have new moves as well.
+        for (int32_t i = 0; i < polish.seq_length; ++i)
+        {
+            polish.pos[polish.seq[i].index] = i;
+        }
+        for (int32_t index : touched)
+        {
+            const int32_t* neighbours = polish.neighbours.data() + static_cast<size_t>(index) * ORDERING_POLISH_NEIGHBOURS;
+            for (int32_t n = 0; n < ORDERING_POLISH_NEIGHBOURS && neighbours[n] != -1; ++n)
+            {
+                polish.active[polish.pos[neighbours[n]]] = true;
+            }
+        }
+    }
+    delete scheduler;
+    score = ordering_evaluate_sequence(polish.seq, polish.mid, polish.seq_length, info.edges);
+    time_print("Polish complete, %zu move(s) in %d round(s), score: %.5lf", total_moves, rounds, -score);
+    free(polish.mid);
+    free(polish.pos);
+    free(polish.best_moves);
+    //Extract the polished sequence.
+    HMR_CONTIG_ID_VEC result;
+    result.resize(polish.seq_length);
+    for (int32_t i = 0; i < polish.seq_length; ++i)
+    {
+        result[i] = info.contig_ids[polish.seq[i].index];
+    }
+    return result;
+}
@@ -0,0 +1,11 @@
+#ifndef ORDERING_POLISH_H
+#define ORDERING_POLISH_H
+
+#include <cstdint>
+
+#include "ordering_type.hpp"
+
+/* Polish the initial genome with 2-opt reversals, Or-opt block moves and adjacent swaps */
+HMR_CONTIG_ID_VEC ordering_polish(ORDERING_INFO& info, int threads);
+
+#endif // ORDERING_POLISH_H
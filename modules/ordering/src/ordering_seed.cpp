@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "hmr_ui.hpp"
+
+#include "ordering_links.hpp"
+
+#include "ordering_seed.hpp"
+
+//Maximum Lanczos basis size of the Fiedler vector.
+constexpr int32_t ORDERING_SEED_LANCZOS_STEPS = 400;
+//Memory of the dense basis, the large groups get fewer steps.
+constexpr size_t ORDERING_SEED_LANCZOS_BUDGET = 8 << 20;
+constexpr int32_t ORDERING_SEED_LANCZOS_MIN_STEPS = 2;
+
+inline int32_t ordering_seed_find(std::vector<int32_t>& parent, int32_t x)
+{
+    while (parent[x] != x)
+    {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+void ordering_seed_greedy(const std::vector<ORDERING_LINK>& edges, int32_t size, HMR_CONTIG_ID_VEC& tour)
+{
+    //Sort the links from the strongest.
+    std::vector<int32_t> edge_ids(edges.size());
+    std::iota(edge_ids.begin(), edge_ids.end(), 0);
+    std::stable_sort(edge_ids.begin(), edge_ids.end(),
+        [&edges](int32_t lhs, int32_t rhs)
+        {
+            return edges[lhs].count > edges[rhs].count;
+        });
+    //Join the chain ends, each contig has 2 sides at most and no cycle is allowed.
+    std::vector<int32_t> parent(size), degree(size, 0), adjacent(static_cast<size_t>(size) * 2, -1);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (int32_t edge_id : edge_ids)
+    {
+        int32_t a = edges[edge_id].a, b = edges[edge_id].b;
+        if (degree[a] > 1 || degree[b] > 1)
+        {
+            continue;
+        }
+        int32_t root_a = ordering_seed_find(parent, a), root_b = ordering_seed_find(parent, b);
+        if (root_a == root_b)
+        {
+            continue;
+        }
+        parent[root_a] = root_b;
+        adjacent[(a << 1) + degree[a]++] = b;
+        adjacent[(b << 1) + degree[b]++] = a;
+    }
+    //Walk through the chains from their ends, the longer chains are placed first.
+    std::vector<HMR_CONTIG_ID_VEC> chains;
+    std::vector<bool> visited(size, false);
+    for (int32_t i = 0; i < size; ++i)
+    {
+        if (visited[i] || degree[i] > 1)
+        {
+            continue;
+        }
+        HMR_CONTIG_ID_VEC chain;
+        for (int32_t prev = -1, current = i; current != -1; )
+        {
+            visited[current] = true;
+            chain.push_back(current);
+            int32_t next = adjacent[current << 1] == prev ? adjacent[(current << 1) + 1] : adjacent[current << 1];
+            prev = current;
+            current = next;
+        }
+        chains.push_back(chain);
+    }
+    std::stable_sort(chains.begin(), chains.end(),
+        [](const HMR_CONTIG_ID_VEC& lhs, const HMR_CONTIG_ID_VEC& rhs)
+        {
+            return lhs.size() > rhs.size();
+        });
+    tour.clear();
+    tour.reserve(size);
+    for (const HMR_CONTIG_ID_VEC& chain : chains)
+    {
+        tour.insert(tour.end(), chain.begin(), chain.end());
+    }
+}
+
+void ordering_seed_nearest(const ORDERING_LINKS& links, int32_t start, const HMR_CONTIG_ID_VEC& fallback, HMR_CONTIG_ID_VEC& tour)
+{
+    int32_t size = links.size;
+    std::vector<bool> visited(size, false);
+    tour.clear();
+    tour.reserve(size);
+    size_t fallback_pos = 0;
+    for (int32_t current = start; current != -1; )
+    {
+        visited[current] = true;
+        tour.push_back(current);
+        //Find the strongest linked unvisited contig.
+        int32_t next = -1;
+        float next_count = 0.0f;
+        if (links.dense)
+        {
+            const float* row = links.matrix.data() + static_cast<size_t>(current) * size;
+            for (int32_t b = 0; b < size; ++b)
+            {
+                if (!visited[b] && row[b] > next_count)
+                {
+                    next = b;
+                    next_count = row[b];
+                }
+            }
+        }
+        else
+        {
+            for (int32_t k = links.offsets[current]; k < links.offsets[current + 1]; ++k)
+            {
+                if (!visited[links.neighbours[k]] && links.counts[k] > next_count)
+                {
+                    next = links.neighbours[k];
+                    next_count = links.counts[k];
+                }
+            }
+        }
+        //Jump to the next unvisited contig of the fallback tour when there is no link.
+        while (next == -1 && fallback_pos < fallback.size())
+        {
+            if (!visited[fallback[fallback_pos]])
+            {
+                next = fallback[fallback_pos];
+            }
+            ++fallback_pos;
+        }
+        current = next;
+    }
+}
+
+inline void ordering_seed_laplacian(const std::vector<ORDERING_LINK>& edges, const std::vector<double>& degree, const double* x, double* y)
+{
+    int32_t size = static_cast<int32_t>(degree.size());
+    for (int32_t i = 0; i < size; ++i)
+    {
+        y[i] = degree[i] * x[i];
+    }
+    for (const ORDERING_LINK& edge : edges)
+    {
+        y[edge.a] -= edge.count * x[edge.b];
+        y[edge.b] -= edge.count * x[edge.a];
+    }
+}
+
+inline double ordering_seed_dot(const double* x, const double* y, int32_t size)
+{
+    double sum = 0.0;
+    for (int32_t i = 0; i < size; ++i)
+    {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+inline int32_t ordering_seed_sturm_count(const std::vector<double>& alpha, const std::vector<double>& beta, double x)
+{
+    //Number of the tridiagonal eigenvalues less than x.
+    int32_t count = 0;
+    double d = 1.0;
+    for (size_t i = 0; i < alpha.size(); ++i)
+    {
+        d = alpha[i] - x - (i ? beta[i - 1] * beta[i - 1] / d : 0.0);
+        if (d == 0.0)
+        {
+            d = -1e-300;
+        }
+        count += d < 0.0;
+    }
+    return count;
+}
+
+void ordering_seed_spectral(const std::vector<ORDERING_LINK>& edges, int32_t size, const HMR_CONTIG_ID_VEC& guess, HMR_CONTIG_ID_VEC& tour)
+{
+    //Without links the Laplacian is zero, the inverse iteration would divide by zero.
+    if (edges.empty())
+    {
+        tour = guess;
+        return;
+    }
+    std::vector<double> degree(size, 0.0);
+    for (const ORDERING_LINK& edge : edges)
+    {
+        degree[edge.a] += edge.count;
+        degree[edge.b] += edge.count;
+    }
+    //Lanczos on the Laplacian in the space orthogonal to the constant vector, the smallest Ritz value is the Fiedler value.
+    //The basis is fully reorthogonalized, so the Ritz vector does not depend on the starting guess once the basis spans it.
+    //The reorthogonalization costs steps^2 * size, the budget also bounds the time of the large groups.
+    int32_t budget_steps = static_cast<int32_t>(std::min<size_t>(ORDERING_SEED_LANCZOS_STEPS, ORDERING_SEED_LANCZOS_BUDGET / (sizeof(double) * size)));
+    int32_t steps = std::min(size - 1, std::max(budget_steps, ORDERING_SEED_LANCZOS_MIN_STEPS));
+    std::vector<double> basis(static_cast<size_t>(steps) * size), w(size), alpha, beta;
+    //Start from the position in the guessed tour, which is already smooth along the chromosome.
+    double* v = basis.data();
+    for (int32_t i = 0; i < size; ++i)
+    {
+        v[guess[i]] = static_cast<double>(i) - 0.5 * static_cast<double>(size - 1);
+    }
+    double norm = sqrt(ordering_seed_dot(v, v, size));
+    for (int32_t i = 0; i < size; ++i)
+    {
+        v[i] /= norm;
+    }
+    for (int32_t j = 0; j < steps; ++j)
+    {
+        v = basis.data() + static_cast<size_t>(j) * size;
+        ordering_seed_laplacian(edges, degree, v, w.data());
+        alpha.push_back(ordering_seed_dot(w.data(), v, size));
+        if (j + 1 == steps)
+        {
+            break;
+        }
+        //Remove the constant vector and the basis, twice for the round-off.
+        for (int32_t pass = 0; pass < 2; ++pass)
+        {
+            double mean = std::accumulate(w.begin(), w.end(), 0.0) / size;
+            for (int32_t i = 0; i < size; ++i)
+            {
+                w[i] -= mean;
+            }
+            for (int32_t k = 0; k <= j; ++k)
+            {
+                const double* u = basis.data() + static_cast<size_t>(k) * size;
+                double projection = ordering_seed_dot(w.data(), u, size);
+                for (int32_t i = 0; i < size; ++i)
+                {
+                    w[i] -= projection * u[i];
+                }
+            }
+        }
+        norm = sqrt(ordering_seed_dot(w.data(), w.data(), size));
+        //The basis spans an invariant subspace, the Ritz values are exact.
+        if (norm <= 1e-10 * (fabs(alpha.back()) + 1.0))
+        {
+            break;
+        }
+        beta.push_back(norm);
+        double* next = basis.data() + static_cast<size_t>(j + 1) * size;
+        for (int32_t i = 0; i < size; ++i)
+        {
+            next[i] = w[i] / norm;
+        }
+    }
+    int32_t m = static_cast<int32_t>(alpha.size());
+    //Bisect the smallest eigenvalue of the tridiagonal matrix in its Gershgorin bound.
+    double lower = alpha[0], upper = alpha[0];
+    for (int32_t i = 0; i < m; ++i)
+    {
+        double radius = (i ? beta[i - 1] : 0.0) + (i + 1 < m ? beta[i] : 0.0);
+        lower = std::min(lower, alpha[i] - radius);
+        upper = std::max(upper, alpha[i] + radius);
+    }
+    double scale = std::max(fabs(lower), fabs(upper)) + 1e-300;
+    for (int32_t iteration = 0; iteration < 200 && upper - lower > 1e-14 * scale; ++iteration)
+    {
+        double mid = 0.5 * (lower + upper);
+        if (ordering_seed_sturm_count(alpha, beta, mid) > 0)
+        {
+            upper = mid;
+        }
+        else
+        {
+            lower = mid;
+        }
+    }
+    //Inverse iteration just below the eigenvalue, the shifted matrix is positive definite so no pivoting is needed.
+    double shift = lower - 1e-10 * scale;
+    std::vector<double> s(m, 1.0), c(m), d(m);
+    for (int32_t iteration = 0; iteration < 3; ++iteration)
+    {
+        //Thomas algorithm on (T - shift I) s' = s.
+        double pivot = alpha[0] - shift;
+        c[0] = m > 1 ? beta[0] / pivot : 0.0;
+        d[0] = s[0] / pivot;
+        for (int32_t i = 1; i < m; ++i)
+        {
+            pivot = alpha[i] - shift - beta[i - 1] * c[i - 1];
+            c[i] = i + 1 < m ? beta[i] / pivot : 0.0;
+            d[i] = (s[i] - beta[i - 1] * d[i - 1]) / pivot;
+        }
+        s[m - 1] = d[m - 1];
+        for (int32_t i = m - 2; i >= 0; --i)
+        {
+            s[i] = d[i] - c[i] * s[i + 1];
+        }
+        norm = sqrt(ordering_seed_dot(s.data(), s.data(), m));
+        for (int32_t i = 0; i < m; ++i)
+        {
+            s[i] /= norm;
+        }
+    }
+    //The Ritz vector in the contig space.
+    std::vector<double> x(size, 0.0);
+    for (int32_t j = 0; j < m; ++j)
+    {
+        const double* u = basis.data() + static_cast<size_t>(j) * size;
+        for (int32_t i = 0; i < size; ++i)
+        {
+            x[i] += s[j] * u[i];
+        }
+    }
+    //Sort the contigs by the vector.
+    tour.resize(size);
+    std::iota(tour.begin(), tour.end(), 0);
+    std::stable_sort(tour.begin(), tour.end(),
+        [&x](int32_t lhs, int32_t rhs)
+        {
+            return x[lhs] < x[rhs];
+        });
+}
+
+void ordering_seed_tours(const ORDERING_LINKS& links, std::vector<HMR_CONTIG_ID_VEC>& tours)
+{
+    tours.clear();
+    if (links.size < 2)
+    {
+        return;
+    }
+    std::vector<ORDERING_LINK> edges;
+    ordering_links_edges(links, edges);
+    HMR_CONTIG_ID_VEC greedy, nearest, spectral;
+    ordering_seed_greedy(edges, links.size, greedy);
+    ordering_seed_nearest(links, greedy[0], greedy, nearest);
+    ordering_seed_spectral(edges, links.size, greedy, spectral);
+    tours.push_back(spectral);
+    tours.push_back(greedy);
+    tours.push_back(nearest);
+}
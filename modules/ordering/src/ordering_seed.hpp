@@ -0,0 +1,17 @@
+#ifndef ORDERING_SEED_H
+#define ORDERING_SEED_H
+
+#include <cstdint>
+
+#include "ordering_type.hpp"
+
+/* Greedy chain merge of the strongest links */
+void ordering_seed_greedy(const std::vector<ORDERING_LINK>& edges, int32_t size, HMR_CONTIG_ID_VEC& tour);
+/* Walk to the strongest linked unvisited contig from the start contig */
+void ordering_seed_nearest(const ORDERING_LINKS& links, int32_t start, const HMR_CONTIG_ID_VEC& fallback, HMR_CONTIG_ID_VEC& tour);
+/* Sort the contigs by the Fiedler vector of the link graph Laplacian */
+void ordering_seed_spectral(const std::vector<ORDERING_LINK>& edges, int32_t size, const HMR_CONTIG_ID_VEC& guess, HMR_CONTIG_ID_VEC& tour);
+/* Build all the initial tours, the contigs are in local index */
+void ordering_seed_tours(const ORDERING_LINKS& links, std::vector<HMR_CONTIG_ID_VEC>& tours);
+
+#endif // ORDERING_SEED_H
@@ -9,13 +9,35 @@ typedef struct ORDERING_TIG
     int32_t length;
 } ORDERING_TIG;
 
-typedef std::unordered_map<int32_t, int32_t> CONTIG_COUNTS;
-typedef std::unordered_map<int32_t, CONTIG_COUNTS> ORDERING_COUNTS;
+typedef struct ORDERING_LINK
+{
+    int32_t a;
+    int32_t b;
+    float count;
+} ORDERING_LINK;
+
+typedef struct ORDERING_LINKS
+{
+    //Contig indices are the local indices of the group, 0..size-1.
+    int32_t size = 0;
+    bool dense = true;
+    //Dense mode, size x size link counts.
+    std::vector<float> matrix;
+    //Dense mode, bit map of the linked pairs, rejects most of the pairs without touching the matrix.
+    std::vector<uint32_t> linked;
+    int32_t linked_words = 0;
+    //Sparse mode, sorted CSR neighbour lists, each row has an open addressing hash of its positions.
+    std::vector<int32_t> offsets, neighbours;
+    std::vector<float> counts;
+    std::vector<int32_t> slot_offsets, slots;
+} ORDERING_LINKS;
 
 typedef struct ORDERING_INFO
 {
     ORDERING_TIG* init_genome;
-    ORDERING_COUNTS edges;
+    HMR_CONTIG_ID_VEC contig_ids; //Local index to contig id, sorted.
+    std::vector<std::vector<ORDERING_TIG> > seeds; //Constructed tours placed in the initial population.
+    ORDERING_LINKS edges;
     int32_t contig_size;
 
     double best;
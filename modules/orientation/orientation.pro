@@ -12,10 +12,12 @@ SOURCES = \
     ../shared/hmr_bin_file.cpp \
     ../shared/hmr_contig_graph.cpp \
     ../shared/hmr_path.cpp \
+    ../shared/hmr_stats.cpp \
     ../shared/hmr_ui.cpp \
     src/args_orientation.cpp \
     src/main.cpp \
-    src/orientation.cpp
+    src/orientation.cpp \
+    src/orientation_refine.cpp
 
 HEADERS = \
     ../shared/hmr_args.hpp \
@@ -24,6 +26,9 @@ HEADERS = \
     ../shared/hmr_contig_graph.hpp \
     ../shared/hmr_contig_graph_type.hpp \
     ../shared/hmr_path.hpp \
+    ../shared/hmr_stats.hpp \
+    ../shared/hmr_task_scheduler.hpp \
     ../shared/hmr_ui.hpp \
     src/args_orientation.hpp \
-    src/orientation.hpp
+    src/orientation.hpp \
+    src/orientation_refine.hpp
@@ -9,6 +9,10 @@ HMR_ARGS opts;
 HMR_ARG_PARSER args_parser = {
     { {"-n", "--nodes"}, "NDOES", "HMR contig node file (.hmr_contig)", LAMBDA_PARSE_ARG {opts.nodes = arg[0]; }},
     { {"-r", "--reads"}, "READS", "HMR paired-reads file (.hmr_reads)", LAMBDA_PARSE_ARG { opts.reads = arg[0];}},
+    { {"--summary"}, "SUMMARY", "HMR paired-reads summary file (.hmr_summary), used instead of the paired-reads file", LAMBDA_PARSE_ARG { opts.summary = arg[0]; }},
     { {"-s", "--seq"}, "SEQ 1, SEQ 2...", "HMR sorted contig sequence file (.hmr_seq)", LAMBDA_PARSE_ARG { opts.seq = arg;}},
+    { {"-t", "--threads"}, "THREADS", "Number of threads (default: 1)", LAMBDA_PARSE_ARG { opts.threads = atoi(arg[0]); }},
     { {"-b", "--buffer-size"}, "BUFFER_SIZE", "HMR paired-reads buffer size (unit: K, default: 512)", LAMBDA_PARSE_ARG {opts.read_buffer_size = atoi(arg[0]); }},
+    { {"--refine"}, "", "Refine the orientation and adjacent order together by the contig end contacts", LAMBDA_PARSE_ARG { (void)arg; opts.refine = true; }},
+    { {"--stats"}, "STATS", "Save the stage timings, counters and peak memory as JSON", LAMBDA_PARSE_ARG {opts.stats = arg[0]; }},
 };
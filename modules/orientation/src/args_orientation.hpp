@@ -9,8 +9,11 @@ typedef struct HMR_ARGS
 {
     const char* nodes = NULL;
     const char* reads = NULL;
+    const char* summary = NULL;
+    const char* stats = NULL;
     std::vector<char*> seq;
-    int read_buffer_size = 512;
+    int threads = 1, read_buffer_size = 512;
+    bool refine = false;
 } HMR_ARGS;
 
 #endif // ARGS_ORIENTATION_H
@@ -5,10 +5,12 @@
 #include "hmr_args.hpp"
 #include "hmr_contig_graph.hpp"
 #include "hmr_path.hpp"
+#include "hmr_stats.hpp"
 #include "hmr_ui.hpp"
 
 #include "args_orientation.hpp"
 #include "orientation.hpp"
+#include "orientation_refine.hpp"
 
 extern HMR_ARGS opts;
 
@@ -16,11 +18,16 @@ int main(int argc, char *argv[])
 {
     //Parse the arguments.
     parse_arguments(argc, argv);
+    if (opts.stats) { hmr_stats_enable("hana_orientation", opts.stats); }
     //Check the arguments are meet the requirements.
     if (!opts.nodes) { help_exit(-1, "Missing HMR graph contig information file path."); }
     if (!path_can_read(opts.nodes)) { time_error(-1, "Cannot read HMR graph contig file %s", opts.nodes); }
-    if (!opts.reads) { help_exit(-1, "Missing HMR paired-reads file path."); }
-    if (!path_can_read(opts.reads)) { time_error(-1, "Cannot read HMR paired-reads file %s", opts.reads); }
+    if (!opts.reads && !opts.summary) { help_exit(-1, "Missing HMR paired-reads file path."); }
+    if (opts.summary)
+    {
+        if (!path_can_read(opts.summary)) { time_error(-1, "Cannot read HMR paired-reads summary file %s", opts.summary); }
+    }
+    else if (!path_can_read(opts.reads)) { time_error(-1, "Cannot read HMR paired-reads file %s", opts.reads); }
     if (opts.seq.empty()) { help_exit(-1, "Missing HMR ordered sequence file path."); }
     for (const char* seq_path : opts.seq)
     {
@@ -28,9 +35,11 @@ int main(int argc, char *argv[])
     }
     //if (!opts.output) { help_exit(-1, "Missing HMR chromosome sequence output file path."); }
     time_print("Execution configuration:");
+    time_print("\tThreads: %d", opts.threads);
     time_print("\tPaired-reads buffer: %dK", opts.read_buffer_size);
     opts.read_buffer_size <<= 10;
     time_print("\tOptimized sequences: %zu", opts.seq.size());
+    time_print("\tEnd contact refinement: %s", opts.refine ? "Yes" : "No");
     //Load the sequence file.
     ORIENTATION_INFO info;
     {
@@ -40,22 +49,59 @@ int main(int argc, char *argv[])
         time_print("%zu contig(s) loaded.", nodes.size());
         //Load the sequence file.
         time_print("Loading sequence indices...");
-        orientation_init(opts.seq, nodes, info);
+        orientation_init(opts.seq, nodes, opts.threads, opts.refine, info);
         time_print("%zu sequence(s) loaded.", opts.seq.size());
     }
     //Loading the reads and parse the sequence, it automatically find the best orientation.
-    time_print("Loading reads pair information from %s", opts.reads);
-    hmr_graph_load_reads(opts.reads, opts.read_buffer_size, orientation_calc_gradient, &info);
+    double gradient_start = hmr_stats_now();
+    if (opts.summary)
+    {
+        //The summary is collected by the draft, the reads file is not scanned again.
+        time_print("Loading reads pair summary from %s", opts.summary);
+        orientation_reduce(info);
+        HMR_READS_SUMMARY summary;
+        hmr_graph_load_reads_summary(opts.summary, summary);
+        time_print("%zu contig pair summaries loaded.", summary.pairs.size());
+        orientation_apply_summary(summary, info);
+    }
+    else
+    {
+        time_print("Loading reads pair information from %s", opts.reads);
+        hmr_graph_load_reads(opts.reads, opts.read_buffer_size, orientation_calc_gradient, &info);
+        orientation_reduce(info);
+    }
+    hmr_stats_stage("orientation.gradient", gradient_start);
     time_print("Reads information loaded, direction gradient calculated.");
     //Based on the gradient, extract the direction.
     time_print("Extracting direction results...");
     std::vector<CHROMOSOME_CONTIGS> chromosomes;
     chromosomes.reserve(info.sequences.size());
+    double extract_start = hmr_stats_now();
     //Extract the chromosome sequence from the result.
     for (const auto& chromosome_sequence : info.sequences)
     {
         chromosomes.push_back(orientation_extract(chromosome_sequence));
+        if (opts.refine)
+        {
+            //Decide the directions and the adjacent swaps together, compare with the independent decision.
+            CHROMOSOME_CONTIGS refined;
+            size_t swaps = orientation_refine(chromosome_sequence, refined), flipped = 0;
+            const CHROMOSOME_CONTIGS& independent = chromosomes.back();
+            for (size_t i = 0; i < refined.size(); ++i)
+            {
+                //A swapped contig moves to the next or the previous position.
+                size_t pos = i;
+                if (independent[pos].id != refined[i].id)
+                {
+                    pos = (i > 0 && independent[i - 1].id == refined[i].id) ? i - 1 : i + 1;
+                }
+                flipped += independent[pos].direction != refined[i].direction;
+            }
+            time_print("Refined sequence %zu: %zu adjacent swap(s), %zu direction(s) changed.", chromosomes.size(), swaps, flipped);
+            chromosomes.back() = refined;
+        }
     }
+    hmr_stats_stage("orientation.extract", extract_start);
     time_print("%zu sequence of orientation generated.", chromosomes.size());
     //Dump the data to the output file.
     for (size_t i = 0; i < opts.seq.size(); ++i)
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 
 #include "hmr_contig_graph.hpp"
@@ -5,27 +6,23 @@
 
 #include "orientation.hpp"
 
-void orientation_init(std::vector<char*> seq_paths, const HMR_NODES& nodes, ORIENTATION_INFO& info)
+void orientation_init(std::vector<char*> seq_paths, const HMR_NODES& nodes, int32_t threads, bool refine, ORIENTATION_INFO& info)
 {
     //Expand the info.
-    info.belongs.resize(nodes.size());
+    info.positions.resize(nodes.size());
     info.sequences.resize(seq_paths.size());
-    //Clear the belongs.
+    //Clear the positions.
     for (size_t i = 0; i < nodes.size(); ++i)
     {
-        info.belongs[i] = -1;
+        info.positions[i] = ORIENTATION_POSITION{ -1, -1 };
     }
     //Load the sequences from path.
+    size_t total_cost = 0, total_contacts = 0;
     for (int32_t i = 0, total_seqs = static_cast<int32_t>(seq_paths.size()); i < total_seqs; ++i)
     {
         time_print("Loading sequence from %s", seq_paths[i]);
         auto &seq = info.sequences[i];
         hmr_graph_load_contig_ids(seq_paths[i], seq.contig_id_seq);
-        //Set belongs of the sequence.
-        for (int32_t contig_id : seq.contig_id_seq)
-        {
-            info.belongs[contig_id] = i;
-        }
         //Allocate memory for the sequences.
         const size_t buffer_size = seq.contig_id_seq.size() << 1;
         seq.cost_buffer = static_cast<double*>(malloc(sizeof(double) * buffer_size));
@@ -40,6 +37,21 @@ void orientation_init(std::vector<char*> seq_paths, const HMR_NODES& nodes, ORIE
         }
         seq.cost_matrix[DIRECTION_POSITIVE] = seq.cost_buffer;
         seq.cost_matrix[DIRECTION_NEGATIVE] = seq.cost_buffer + seq.contig_id_seq.size();
+        info.cost_offsets.push_back(total_cost);
+        total_cost += buffer_size;
+        //The end contact table is only needed for the refinement.
+        seq.end_contacts = NULL;
+        if (refine)
+        {
+            const size_t contacts_size = orientation_end_index(static_cast<int32_t>(seq.contig_id_seq.size()), 1, 0, 0);
+            seq.end_contacts = static_cast<uint64_t*>(calloc(contacts_size ? contacts_size : 1, sizeof(uint64_t)));
+            if (!seq.end_contacts)
+            {
+                time_error(-1, "Failed to allocate memory for the end contact table.");
+            }
+            info.contact_offsets.push_back(total_contacts);
+            total_contacts += contacts_size;
+        }
         //Prepare the memory for the contig length.
         seq.contig_size = static_cast<double*>(malloc(sizeof(double) * seq.contig_id_seq.size()));
         if (!seq.contig_size)
@@ -47,43 +59,229 @@ void orientation_init(std::vector<char*> seq_paths, const HMR_NODES& nodes, ORIE
             time_error(-1, "Failed to allocate memory for contig sizes.");
         }
         assert(seq.contig_size);
-        //Build the contig->index hash map for storage.
+        //Record the position of each contig, the reads are mapped by a direct lookup.
         for (size_t j = 0; j < seq.contig_id_seq.size(); ++j)
         {
-            seq.contig_id_map.insert(std::make_pair(seq.contig_id_seq[j], static_cast<int32_t>(j)));
+            info.positions[seq.contig_id_seq[j]] = ORIENTATION_POSITION{ i, static_cast<int32_t>(j) };
             seq.contig_size[j] = static_cast<double>(nodes[seq.contig_id_seq[j]].length);
         }
     }
+    //Each thread accumulates the costs in its own copy, the copies are reduced at the end.
+    info.threads = threads < 1 ? 1 : threads;
+    info.refine = refine;
+    info.scheduler = info.threads > 1 ? new hmr::task_scheduler(info.threads) : NULL;
+    info.thread_costs.resize(info.threads);
+    for (int32_t i = 0; i < info.threads; ++i)
+    {
+        info.thread_costs[i] = static_cast<double*>(malloc(sizeof(double) * (total_cost ? total_cost : 1)));
+        if (!info.thread_costs[i])
+        {
+            time_error(-1, "Failed to allocate memory for the thread cost matrix.");
+        }
+        for (size_t j = 0; j < total_cost; ++j)
+        {
+            info.thread_costs[i][j] = 0.0;
+        }
+        if (refine)
+        {
+            info.thread_contacts.push_back(static_cast<uint64_t*>(calloc(total_contacts ? total_contacts : 1, sizeof(uint64_t))));
+            if (!info.thread_contacts[i])
+            {
+                time_error(-1, "Failed to allocate memory for the thread end contact table.");
+            }
+        }
+    }
 }
 
-void orientation_calc_gradient(HMR_MAPPING* mapping, int32_t buf_size, void* user)
+void orientation_gradient_range(const HMR_MAPPING* mapping, int32_t start_idx, int32_t end_idx, const ORIENTATION_INFO* info, double* costs, uint64_t* contacts)
 {
-    ORIENTATION_INFO* info = static_cast<ORIENTATION_INFO*>(user);
-    for (int32_t i = 0; i < buf_size; ++i)
+    const ORIENTATION_POSITION* positions = info->positions.data();
+    for (int32_t i = start_idx; i < end_idx; ++i)
     {
         const HMR_MAPPING& pair = mapping[i];
         //Find whether all the contig ids are in the sequence.
-        if (info->belongs[pair.refID] != info->belongs[pair.next_refID] || info->belongs[pair.refID] == -1)
+        const ORIENTATION_POSITION& pos_a = positions[pair.refID], & pos_b = positions[pair.next_refID];
+        if (pos_a.seq != pos_b.seq || pos_a.seq == -1)
         {
             continue;
         }
         //Check the position of contig a and b.
-        auto& seq = info->sequences[info->belongs[pair.refID]];
-        int32_t pos_a_in_seq = seq.contig_id_map.find(pair.refID)->second,
-            pos_b_in_seq = seq.contig_id_map.find(pair.next_refID)->second;
+        const auto& seq = info->sequences[pos_a.seq];
+        const size_t seq_size = seq.contig_id_seq.size();
+        double* cost_positive = costs + info->cost_offsets[pos_a.seq], * cost_negative = cost_positive + seq_size;
+        int32_t pos_a_in_seq = pos_a.pos, pos_b_in_seq = pos_b.pos;
         if (pos_a_in_seq > pos_b_in_seq)
         {
-            seq.cost_matrix[DIRECTION_POSITIVE][pos_a_in_seq] += static_cast<double>(pair.pos);
-            seq.cost_matrix[DIRECTION_NEGATIVE][pos_a_in_seq] += seq.contig_size[pos_a_in_seq] - static_cast<double>(pair.pos);
-            seq.cost_matrix[DIRECTION_POSITIVE][pos_b_in_seq] += seq.contig_size[pos_b_in_seq] - static_cast<double>(pair.next_pos);
-            seq.cost_matrix[DIRECTION_NEGATIVE][pos_b_in_seq] += static_cast<double>(pair.next_pos);
+            cost_positive[pos_a_in_seq] += static_cast<double>(pair.pos);
+            cost_negative[pos_a_in_seq] += seq.contig_size[pos_a_in_seq] - static_cast<double>(pair.pos);
+            cost_positive[pos_b_in_seq] += seq.contig_size[pos_b_in_seq] - static_cast<double>(pair.next_pos);
+            cost_negative[pos_b_in_seq] += static_cast<double>(pair.next_pos);
         }
         else
         {
-            seq.cost_matrix[DIRECTION_POSITIVE][pos_a_in_seq] += seq.contig_size[pos_a_in_seq] - static_cast<double>(pair.pos);
-            seq.cost_matrix[DIRECTION_NEGATIVE][pos_a_in_seq] += static_cast<double>(pair.pos);
-            seq.cost_matrix[DIRECTION_POSITIVE][pos_b_in_seq] += static_cast<double>(pair.next_pos);
-            seq.cost_matrix[DIRECTION_NEGATIVE][pos_b_in_seq] += seq.contig_size[pos_b_in_seq] - static_cast<double>(pair.next_pos);
+            cost_positive[pos_a_in_seq] += seq.contig_size[pos_a_in_seq] - static_cast<double>(pair.pos);
+            cost_negative[pos_a_in_seq] += static_cast<double>(pair.pos);
+            cost_positive[pos_b_in_seq] += static_cast<double>(pair.next_pos);
+            cost_negative[pos_b_in_seq] += seq.contig_size[pos_b_in_seq] - static_cast<double>(pair.next_pos);
+        }
+        //Count the reads between the ends of the nearby contigs.
+        if (contacts)
+        {
+            int32_t distance = pos_a_in_seq > pos_b_in_seq ? pos_a_in_seq - pos_b_in_seq : pos_b_in_seq - pos_a_in_seq;
+            if (distance > 0 && distance <= ORIENTATION_END_SPAN)
+            {
+                int32_t end_a = static_cast<double>(pair.pos) * 2.0 < seq.contig_size[pos_a_in_seq] ? CONTIG_END_HEAD : CONTIG_END_TAIL,
+                    end_b = static_cast<double>(pair.next_pos) * 2.0 < seq.contig_size[pos_b_in_seq] ? CONTIG_END_HEAD : CONTIG_END_TAIL;
+                uint64_t* seq_contacts = contacts + info->contact_offsets[pos_a.seq];
+                if (pos_a_in_seq < pos_b_in_seq)
+                {
+                    ++seq_contacts[orientation_end_index(pos_a_in_seq, distance, end_a, end_b)];
+                }
+                else
+                {
+                    ++seq_contacts[orientation_end_index(pos_b_in_seq, distance, end_b, end_a)];
+                }
+            }
+        }
+    }
+}
+
+void orientation_gradient_worker(const int32_t idx, const int32_t threads, const HMR_MAPPING* mapping, int32_t buf_size, const ORIENTATION_INFO* info)
+{
+    //Each thread takes a continuous range of the buffer.
+    int32_t step = (buf_size + threads - 1) / threads, start_idx = idx * step, end_idx = start_idx + step;
+    if (start_idx > buf_size)
+    {
+        start_idx = buf_size;
+    }
+    if (end_idx > buf_size)
+    {
+        end_idx = buf_size;
+    }
+    orientation_gradient_range(mapping, start_idx, end_idx, info, info->thread_costs[idx], info->refine ? info->thread_contacts[idx] : NULL);
+}
+
+void orientation_calc_gradient(HMR_MAPPING* mapping, int32_t buf_size, void* user)
+{
+    ORIENTATION_INFO* info = static_cast<ORIENTATION_INFO*>(user);
+    if (info->threads < 2)
+    {
+        orientation_gradient_range(mapping, 0, buf_size, info, info->thread_costs[0], info->refine ? info->thread_contacts[0] : NULL);
+        return;
+    }
+    //The workers are kept between the buffers, each task still owns one private copy.
+    hmr::task_group gradient_group(*info->scheduler);
+    for (int32_t i = 0; i < info->threads; ++i)
+    {
+        gradient_group.run([i, mapping, buf_size, info] { orientation_gradient_worker(i, info->threads, mapping, buf_size, info); });
+    }
+    gradient_group.wait();
+}
+
+void orientation_reduce(ORIENTATION_INFO& info)
+{
+    //Sum the private copies into the cost buffer of each sequence.
+    //The costs are sums of integer coordinates, which are exact in double, so the thread count does not matter.
+    for (size_t i = 0; i < info.sequences.size(); ++i)
+    {
+        auto& seq = info.sequences[i];
+        const size_t buffer_size = seq.contig_id_seq.size() << 1;
+        for (int32_t t = 0; t < info.threads; ++t)
+        {
+            const double* costs = info.thread_costs[t] + info.cost_offsets[i];
+            for (size_t j = 0; j < buffer_size; ++j)
+            {
+                seq.cost_buffer[j] += costs[j];
+            }
+        }
+        if (info.refine)
+        {
+            const size_t contacts_size = orientation_end_index(static_cast<int32_t>(seq.contig_id_seq.size()), 1, 0, 0);
+            for (int32_t t = 0; t < info.threads; ++t)
+            {
+                const uint64_t* contacts = info.thread_contacts[t] + info.contact_offsets[i];
+                for (size_t j = 0; j < contacts_size; ++j)
+                {
+                    seq.end_contacts[j] += contacts[j];
+                }
+            }
+        }
+    }
+    for (int32_t t = 0; t < info.threads; ++t)
+    {
+        free(info.thread_costs[t]);
+        if (info.refine)
+        {
+            free(info.thread_contacts[t]);
+        }
+    }
+    info.thread_costs.clear();
+    info.thread_contacts.clear();
+    delete info.scheduler;
+    info.scheduler = NULL;
+}
+
+void orientation_apply_summary(const HMR_READS_SUMMARY& summary, ORIENTATION_INFO& info)
+{
+    //The summary keeps the position sums, which expand to the same integer costs as adding the reads one by one.
+    const ORIENTATION_POSITION* positions = info.positions.data();
+    for (size_t i = 0; i < summary.contigs.size() && i < info.positions.size(); ++i)
+    {
+        const HMR_CONTIG_SUMMARY& contig = summary.contigs[i];
+        if (contig.count == 0 || positions[i].seq == -1)
+        {
+            continue;
+        }
+        auto& seq = info.sequences[positions[i].seq];
+        const int32_t pos = positions[i].pos;
+        const double total_size = static_cast<double>(contig.count) * seq.contig_size[pos];
+        seq.cost_matrix[DIRECTION_POSITIVE][pos] += total_size - static_cast<double>(contig.pos_sum[0]) + static_cast<double>(contig.pos_sum[1]);
+        seq.cost_matrix[DIRECTION_NEGATIVE][pos] += static_cast<double>(contig.pos_sum[0]) + total_size - static_cast<double>(contig.pos_sum[1]);
+    }
+    for (const HMR_PAIR_SUMMARY& pair : summary.pairs)
+    {
+        const ORIENTATION_POSITION& pos_first = positions[pair.first], & pos_second = positions[pair.second];
+        if (pos_first.seq != pos_second.seq || pos_first.seq == -1)
+        {
+            continue;
+        }
+        auto& seq = info.sequences[pos_first.seq];
+        double* cost_positive = seq.cost_matrix[DIRECTION_POSITIVE], * cost_negative = seq.cost_matrix[DIRECTION_NEGATIVE];
+        //The latter contig prefers the reads near its head, the former one prefers the reads near its tail.
+        int32_t pos_latter = pos_first.pos, pos_former = pos_second.pos;
+        uint64_t sum_latter = pair.pos_sum[0], sum_former = pair.pos_sum[1];
+        if (pos_latter < pos_former)
+        {
+            std::swap(pos_latter, pos_former);
+            std::swap(sum_latter, sum_former);
+        }
+        const double count = static_cast<double>(pair.count);
+        cost_positive[pos_latter] += static_cast<double>(sum_latter);
+        cost_negative[pos_latter] += count * seq.contig_size[pos_latter] - static_cast<double>(sum_latter);
+        cost_positive[pos_former] += count * seq.contig_size[pos_former] - static_cast<double>(sum_former);
+        cost_negative[pos_former] += static_cast<double>(sum_former);
+        //Count the reads between the ends of the nearby contigs.
+        if (info.refine)
+        {
+            int32_t distance = pos_latter - pos_former;
+            if (distance <= ORIENTATION_END_SPAN)
+            {
+                for (int32_t end_first = CONTIG_END_HEAD; end_first <= CONTIG_END_TAIL; ++end_first)
+                {
+                    for (int32_t end_second = CONTIG_END_HEAD; end_second <= CONTIG_END_TAIL; ++end_second)
+                    {
+                        uint64_t contacts = pair.ends[(end_first << 1) | end_second];
+                        if (pos_first.pos < pos_second.pos)
+                        {
+                            seq.end_contacts[orientation_end_index(pos_first.pos, distance, end_first, end_second)] += contacts;
+                        }
+                        else
+                        {
+                            seq.end_contacts[orientation_end_index(pos_second.pos, distance, end_second, end_first)] += contacts;
+                        }
+                    }
+                }
+            }
         }
     }
 }
@@ -1,28 +1,57 @@
 #ifndef ORIENTATION_H
 #define ORIENTATION_H
 
+#include <cstddef>
+
 #include "hmr_contig_graph_type.hpp"
+#include "hmr_task_scheduler.hpp"
 
 constexpr auto DIRECTION_POSITIVE = 0;
 constexpr auto DIRECTION_NEGATIVE = 1;
 
+constexpr auto CONTIG_END_HEAD = 0;
+constexpr auto CONTIG_END_TAIL = 1;
+//Contig pairs up to this distance in the sequence are kept in the end contact table.
+constexpr int32_t ORIENTATION_END_SPAN = 3;
+
 typedef struct ORIENTATION_SEQUENCE
 {
     HMR_CONTIG_ID_VEC contig_id_seq;
-    std::unordered_map<int32_t, int32_t> contig_id_map;
     double* contig_size;
     double* cost_buffer;
     double* cost_matrix[2];
+    //Reads between the ends of the nearby contigs, [position][distance - 1][end of the first][end of the second].
+    uint64_t* end_contacts;
 } ORIENTATION_SEQUENCE;
 
+typedef struct ORIENTATION_POSITION
+{
+    int32_t seq; // Index of the sequence, -1 when the contig is not in any sequence.
+    int32_t pos; // Index of the contig in the sequence.
+} ORIENTATION_POSITION;
+
 typedef struct ORIENTATION_INFO
 {
     std::vector<ORIENTATION_SEQUENCE> sequences;
-    std::vector<int32_t> belongs;
+    std::vector<ORIENTATION_POSITION> positions; // Contig id to its position.
+    int32_t threads;
+    hmr::task_scheduler* scheduler; // Runs the gradient of each mapping buffer, NULL for a single thread.
+    std::vector<double*> thread_costs; // Private copies of all the cost buffers, one for each thread.
+    std::vector<size_t> cost_offsets; // Offset of each sequence cost buffer in the private copies.
+    bool refine; // Collect the end contacts for the refinement.
+    std::vector<uint64_t*> thread_contacts;
+    std::vector<size_t> contact_offsets;
 } ORIENTATION_INFO;
 
-void orientation_init(std::vector<char*> seq_paths, const HMR_NODES& nodes, ORIENTATION_INFO& info);
+void orientation_init(std::vector<char*> seq_paths, const HMR_NODES& nodes, int32_t threads, bool refine, ORIENTATION_INFO& info);
 void orientation_calc_gradient(HMR_MAPPING* mapping, int32_t buf_size, void* user);
+void orientation_reduce(ORIENTATION_INFO& info);
+void orientation_apply_summary(const HMR_READS_SUMMARY& summary, ORIENTATION_INFO& info);
 CHROMOSOME_CONTIGS orientation_extract(const ORIENTATION_SEQUENCE& sequence);
 
+inline size_t orientation_end_index(int32_t pos, int32_t distance, int32_t end_a, int32_t end_b)
+{
+    return ((static_cast<size_t>(pos) * ORIENTATION_END_SPAN + (distance - 1)) << 2) + (end_a << 1) + end_b;
+}
+
 #endif // ORIENTATION_H
\ No newline at end of file
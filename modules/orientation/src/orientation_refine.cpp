@@ -0,0 +1,198 @@
+#include <cstring>
+#include <vector>
+
+#include "orientation_refine.hpp"
+
+enum ORIENTATION_BLOCK
+{
+    ORIENTATION_BLOCK_SINGLE, // Place the next contig.
+    ORIENTATION_BLOCK_SWAP    // Place the next two contigs in the swapped order.
+};
+
+typedef struct ORIENTATION_SCORE
+{
+    //Compared in order: more reads between the facing ends, fewer swaps, better agreement with the gradient.
+    double contacts;
+    int32_t swaps;
+    double agreement;
+} ORIENTATION_SCORE;
+
+typedef struct ORIENTATION_STATE
+{
+    ORIENTATION_SCORE score;
+    bool reached;
+    //The block which reaches the state, and the state before it.
+    int32_t block, prev_block, prev_direction, first_direction;
+} ORIENTATION_STATE;
+
+inline bool orientation_score_better(const ORIENTATION_SCORE& lhs, const ORIENTATION_SCORE& rhs)
+{
+    if (lhs.contacts != rhs.contacts)
+    {
+        return lhs.contacts > rhs.contacts;
+    }
+    if (lhs.swaps != rhs.swaps)
+    {
+        return lhs.swaps < rhs.swaps;
+    }
+    return lhs.agreement > rhs.agreement;
+}
+
+inline int32_t orientation_right_end(int32_t direction)
+{
+    return direction == DIRECTION_POSITIVE ? CONTIG_END_TAIL : CONTIG_END_HEAD;
+}
+
+inline int32_t orientation_left_end(int32_t direction)
+{
+    return direction == DIRECTION_POSITIVE ? CONTIG_END_HEAD : CONTIG_END_TAIL;
+}
+
+double orientation_facing_contacts(const ORIENTATION_SEQUENCE& sequence, int32_t left, int32_t left_direction, int32_t right, int32_t right_direction)
+{
+    //Reads between the right end of the left contig and the left end of the right contig.
+    int32_t left_end = orientation_right_end(left_direction), right_end = orientation_left_end(right_direction);
+    if (left < right)
+    {
+        return static_cast<double>(sequence.end_contacts[orientation_end_index(left, right - left, left_end, right_end)]);
+    }
+    return static_cast<double>(sequence.end_contacts[orientation_end_index(right, left - right, right_end, left_end)]);
+}
+
+double orientation_agreement(const ORIENTATION_SEQUENCE& sequence, int32_t pos, int32_t direction)
+{
+    //The relative margin of the gradient decision, positive when the direction is what the gradient prefers.
+    double cost_positive = sequence.cost_matrix[DIRECTION_POSITIVE][pos], cost_negative = sequence.cost_matrix[DIRECTION_NEGATIVE][pos],
+        total = cost_positive + cost_negative;
+    if (total <= 0.0)
+    {
+        return 0.0;
+    }
+    double margin = (cost_positive - cost_negative) / total;
+    return direction == DIRECTION_NEGATIVE ? margin : -margin;
+}
+
+inline void orientation_refine_set(HMR_DIRECTED_CONTIG& contig, int32_t id, int32_t direction)
+{
+    //Set the fields only, the cleared padding is written to the output file.
+    contig.id = id;
+    contig.direction = direction == DIRECTION_NEGATIVE;
+}
+
+size_t orientation_refine(const ORIENTATION_SEQUENCE& sequence, CHROMOSOME_CONTIGS& result)
+{
+    //Dynamic programming over the sequence cut into blocks of a single contig or a swapped adjacent pair.
+    //State [i][block][direction]: the first i positions are placed, the last block type and the direction of the last placed contig.
+    //The last placed contig is i - 1 after a single block and i - 2 after a swap, so every adjacent pair is in the contact table.
+    const int32_t seq_size = static_cast<int32_t>(sequence.contig_id_seq.size());
+    result.clear();
+    if (seq_size == 0)
+    {
+        return 0;
+    }
+    std::vector<ORIENTATION_STATE> states(static_cast<size_t>(seq_size + 1) * 4);
+    auto state_at = [&](int32_t i, int32_t block, int32_t direction) -> ORIENTATION_STATE&
+    {
+        return states[(static_cast<size_t>(i) << 2) + (block << 1) + direction];
+    };
+    auto relax = [&](int32_t i, int32_t block, int32_t direction, const ORIENTATION_SCORE& score, int32_t prev_block, int32_t prev_direction, int32_t first_direction)
+    {
+        ORIENTATION_STATE& state = state_at(i, block, direction);
+        if (!state.reached || orientation_score_better(score, state.score))
+        {
+            state = ORIENTATION_STATE{ score, true, block, prev_block, prev_direction, first_direction };
+        }
+    };
+    for (ORIENTATION_STATE& state : states)
+    {
+        state.reached = false;
+    }
+    //Place the first block.
+    for (int32_t direction = 0; direction < 2; ++direction)
+    {
+        relax(1, ORIENTATION_BLOCK_SINGLE, direction, ORIENTATION_SCORE{ 0.0, 0, orientation_agreement(sequence, 0, direction) }, -1, -1, -1);
+        if (seq_size < 2)
+        {
+            continue;
+        }
+        for (int32_t second = 0; second < 2; ++second)
+        {
+            ORIENTATION_SCORE score{ orientation_facing_contacts(sequence, 1, direction, 0, second), 1,
+                orientation_agreement(sequence, 1, direction) + orientation_agreement(sequence, 0, second) };
+            relax(2, ORIENTATION_BLOCK_SWAP, second, score, -1, -1, direction);
+        }
+    }
+    for (int32_t i = 1; i < seq_size; ++i)
+    {
+        for (int32_t block = 0; block < 2; ++block)
+        {
+            for (int32_t direction = 0; direction < 2; ++direction)
+            {
+                const ORIENTATION_STATE& state = state_at(i, block, direction);
+                if (!state.reached)
+                {
+                    continue;
+                }
+                int32_t last = block == ORIENTATION_BLOCK_SINGLE ? i - 1 : i - 2;
+                for (int32_t next = 0; next < 2; ++next)
+                {
+                    //Place contig i.
+                    ORIENTATION_SCORE score = state.score;
+                    score.contacts += orientation_facing_contacts(sequence, last, direction, i, next);
+                    score.agreement += orientation_agreement(sequence, i, next);
+                    relax(i + 1, ORIENTATION_BLOCK_SINGLE, next, score, block, direction, -1);
+                    //Place contig i + 1 then contig i.
+                    if (i + 1 < seq_size)
+                    {
+                        for (int32_t second = 0; second < 2; ++second)
+                        {
+                            ORIENTATION_SCORE swap_score = state.score;
+                            swap_score.contacts += orientation_facing_contacts(sequence, last, direction, i + 1, next) +
+                                orientation_facing_contacts(sequence, i + 1, next, i, second);
+                            swap_score.agreement += orientation_agreement(sequence, i + 1, next) + orientation_agreement(sequence, i, second);
+                            ++swap_score.swaps;
+                            relax(i + 2, ORIENTATION_BLOCK_SWAP, second, swap_score, block, direction, next);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    //Find the best final state.
+    int32_t best_block = -1, best_direction = -1;
+    for (int32_t block = 0; block < 2; ++block)
+    {
+        for (int32_t direction = 0; direction < 2; ++direction)
+        {
+            const ORIENTATION_STATE& state = state_at(seq_size, block, direction);
+            if (state.reached && (best_block == -1 || orientation_score_better(state.score, state_at(seq_size, best_block, best_direction).score)))
+            {
+                best_block = block;
+                best_direction = direction;
+            }
+        }
+    }
+    //Trace back the blocks from the end.
+    result.resize(seq_size);
+    memset(result.data(), 0, sizeof(HMR_DIRECTED_CONTIG) * seq_size);
+    size_t swaps = 0;
+    for (int32_t i = seq_size, block = best_block, direction = best_direction; i > 0; )
+    {
+        const ORIENTATION_STATE& state = state_at(i, block, direction);
+        if (block == ORIENTATION_BLOCK_SINGLE)
+        {
+            orientation_refine_set(result[i - 1], sequence.contig_id_seq[i - 1], direction);
+            --i;
+        }
+        else
+        {
+            orientation_refine_set(result[i - 2], sequence.contig_id_seq[i - 1], state.first_direction);
+            orientation_refine_set(result[i - 1], sequence.contig_id_seq[i - 2], direction);
+            i -= 2;
+            ++swaps;
+        }
+        block = state.prev_block;
+        direction = state.prev_direction;
+    }
+    return swaps;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#ifndef ORIENTATION_REFINE_H
+#define ORIENTATION_REFINE_H
+
+#include "orientation.hpp"
+
+/* Decide the orientation and the adjacent swaps of a sequence together from the end contacts, returns the number of swaps */
+size_t orientation_refine(const ORIENTATION_SEQUENCE& sequence, CHROMOSOME_CONTIGS& result);
+
+#endif // ORIENTATION_REFINE_H
\ No newline at end of file
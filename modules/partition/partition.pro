@@ -12,10 +12,12 @@ SOURCES += \
     ../shared/hmr_bin_file.cpp \
     ../shared/hmr_contig_graph.cpp \
     ../shared/hmr_path.cpp \
+    ../shared/hmr_stats.cpp \
     ../shared/hmr_ui.cpp \
     src/args_partition.cpp \
     src/main.cpp \
-    src/partition.cpp
+    src/partition.cpp \
+    src/partition_trace.cpp
 
 HEADERS += \
     ../shared/hmr_args.hpp \
@@ -24,7 +26,10 @@ HEADERS += \
     ../shared/hmr_contig_graph.hpp \
     ../shared/hmr_contig_graph_type.hpp \
     ../shared/hmr_path.hpp \
+    ../shared/hmr_stats.hpp \
+    ../shared/hmr_task_scheduler.hpp \
     ../shared/hmr_ui.hpp \
     src/args_partition.hpp \
     src/partition.hpp \
+    src/partition_trace.hpp \
     src/partition_type.hpp
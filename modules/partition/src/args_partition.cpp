@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 
 #include "args_partition.hpp"
 
@@ -10,8 +11,16 @@ HMR_ARG_PARSER args_parser = {
     { {"-n", "--nodes"}, "NODES", "HMR contig node file (.hmr_nodes)", LAMBDA_PARSE_ARG {opts.nodes = arg[0]; }},
     { {"-e", "--edges"}, "EDGES", "HMR edges file (.hmr_edges)", LAMBDA_PARSE_ARG { opts.edges = arg[0];}},
     { {"-a", "--allele"}, "ALLELE_TABLE", "HMR allele table file (.hmr_allele_table)", LAMBDA_PARSE_ARG { opts.allele = arg[0]; }},
-    { {"-g", "--group"}, "GROUP", "Number of groups to be partitioned", LAMBDA_PARSE_ARG {opts.groups = atoi(arg[0]); }},
+    { {"-g", "--group"}, "GROUP", "Number of groups to be partitioned, or a range (e.g. 10-14) to sweep", LAMBDA_PARSE_ARG {
+        opts.groups = atoi(arg[0]);
+        const char* range_end = strchr(arg[0], '-');
+        opts.groups_max = range_end ? atoi(range_end + 1) : opts.groups; }},
     { {"-o", "--output"}, "OUTPUT", "Output partition file (.hmr_partition)", LAMBDA_PARSE_ARG {opts.output = arg[0]; }},
+    { {"-t", "--threads"}, "THREADS", "Number of threads (default: 1)", LAMBDA_PARSE_ARG { opts.threads = atoi(arg[0]); }},
     { {"-b", "--buffer-size"}, "BUFFER_SIZE", "HMR edge buffer size (unit: K, default: 512)", LAMBDA_PARSE_ARG {opts.read_buffer_size = atoi(arg[0]); }},
     { {"--non-informative-ratio"}, "NON_INFO_RATIO", "Skipped contigs recover cutoff (default: 3)", LAMBDA_PARSE_ARG {opts.non_informative_ratio = atoi(arg[0]); }},
+    { {"--checkpoint"}, "TRACE", "Save the merge trace periodically to the file", LAMBDA_PARSE_ARG {opts.checkpoint = arg[0]; }},
+    { {"--checkpoint-interval"}, "SECONDS", "Merge trace saving interval (unit: second, default: 600)", LAMBDA_PARSE_ARG {opts.checkpoint_interval = atoi(arg[0]); }},
+    { {"--resume"}, "TRACE", "Resume the merge stage from the trace file, a complete trace skips merging", LAMBDA_PARSE_ARG {opts.resume = arg[0]; }},
+    { {"--stats"}, "STATS", "Save the stage timings, counters and peak memory as JSON", LAMBDA_PARSE_ARG {opts.stats = arg[0]; }},
 };
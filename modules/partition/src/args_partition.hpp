@@ -10,7 +10,11 @@ typedef struct HMR_ARGS
     const char* edges = NULL;
     const char* allele = NULL;
     const char* output = NULL;
-    int groups = -1, read_buffer_size = 512, non_informative_ratio = 3;
+    const char* checkpoint = NULL;
+    const char* resume = NULL;
+    const char* stats = NULL;
+    int checkpoint_interval = 600;
+    int groups = -1, groups_max = -1, threads = 1, read_buffer_size = 512, non_informative_ratio = 3;
 } HMR_ARGS;
 
 #endif // ARGS_PARTITION_H
@@ -1,34 +1,82 @@
 #include <algorithm>
+#include <ctime>
 
 #include "hmr_args.hpp"
 #include "hmr_path.hpp"
+#include "hmr_stats.hpp"
 #include "hmr_ui.hpp"
 
 #include "args_partition.hpp"
 #include "hmr_contig_graph.hpp"
 
 #include "partition.hpp"
+#include "partition_trace.hpp"
 
 extern HMR_ARGS opts;
 
+typedef struct PARTITION_CHECKPOINT
+{
+    const char* path;
+    time_t interval;
+    time_t last_save;
+} PARTITION_CHECKPOINT;
+
+void partition_checkpoint_proc(const CLUSTER_INFO& info, const CLUSTER_DENDROGRAM& dendrogram, void* user)
+{
+    PARTITION_CHECKPOINT* checkpoint = static_cast<PARTITION_CHECKPOINT*>(user);
+    time_t now = time(0);
+    if (now - checkpoint->last_save < checkpoint->interval)
+    {
+        return;
+    }
+    if (partition_trace_save(checkpoint->path, info, dendrogram))
+    {
+        time_print("Merge trace saved to %s (%zu merge step(s)).", checkpoint->path, dendrogram.steps.size());
+    }
+    checkpoint->last_save = now;
+}
+
 int main(int argc, char* argv[])
 {
     //Parse the arguments.
     parse_arguments(argc, argv);
+    if (opts.stats) { hmr_stats_enable("hana_partition", opts.stats); }
     //Check the arguments are meet the requirements.
     if (!opts.nodes) { help_exit(-1, "Missing HMR graph contig information file path."); }
     if (!path_can_read(opts.nodes)) { time_error(-1, "Cannot read HMR graph contig file %s", opts.nodes); }
     if (!opts.edges) { help_exit(-1, "Missing HMR graph edge weight file path."); }
     if (!path_can_read(opts.edges)) { time_error(-1, "Cannot read HMR graph edge weight file %s", opts.edges); }
-    if (opts.groups < 1) { time_error(-1, "Please specify the group to be separated."); }
+    if (opts.groups < 1 && !opts.resume) { time_error(-1, "Please specify the group to be separated."); }
+    if (opts.groups_max < opts.groups) { time_error(-1, "Invalid group range %d-%d.", opts.groups, opts.groups_max); }
+    if (opts.resume && !path_can_read(opts.resume)) { time_error(-1, "Cannot read partition trace file %s", opts.resume); }
     if (!opts.output) { help_exit(-1, "Missing output HMR partition file path."); }
     //Print the execution configuration.
     time_print("Execution configuration:");
-    time_print("\tNumber of Partitions: %d", opts.groups);
+    if (opts.groups < 1)
+    {
+        time_print("\tNumber of Partitions: From trace");
+    }
+    else if (opts.groups == opts.groups_max)
+    {
+        time_print("\tNumber of Partitions: %d", opts.groups);
+    }
+    else
+    {
+        time_print("\tNumber of Partitions: %d-%d", opts.groups, opts.groups_max);
+    }
     time_print("\tAllele mode: %s", opts.allele ? "Yes" : "No");
+    time_print("\tThreads: %d", opts.threads);
     time_print("\tEdge buffer: %dK", opts.read_buffer_size);
     opts.read_buffer_size <<= 10;
     time_print("\tNon informative ratio: %d", opts.non_informative_ratio);
+    if (opts.checkpoint)
+    {
+        time_print("\tCheckpoint: %s (every %d seconds)", opts.checkpoint, opts.checkpoint_interval);
+    }
+    if (opts.resume)
+    {
+        time_print("\tResume from: %s", opts.resume);
+    }
     //Load the contig node information.
     HMR_NODES nodes;
     time_print("Loading contig information from %s", opts.nodes);
@@ -64,65 +112,143 @@ int main(int argc, char* argv[])
     {
         partition_info.allele_map = &allele_map;
     }
-    hmr_graph_load_edges(opts.edges, opts.read_buffer_size, partition_edge_size_proc, partition_edge_proc, &partition_info);
+    double load_start = hmr_stats_now();
+    if (hmr_graph_edges_is_undirected(opts.edges))
+    {
+        hmr_graph_load_undirected_edges(opts.edges, opts.read_buffer_size, partition_undirected_edge_size_proc, partition_undirected_edge_proc, &partition_info);
+    }
+    else
+    {
+        hmr_graph_load_edges(opts.edges, opts.read_buffer_size, partition_edge_size_proc, partition_edge_proc, &partition_info);
+    }
+    hmr_stats_stage("partition.load_edges", load_start);
+    hmr_stats_count("partition.merge_operations", partition_info.merge_size);
     time_print("%zu merge operations built.", partition_info.merge_size);
+    CLUSTER_DENDROGRAM dendrogram;
+    if (opts.resume)
+    {
+        //Restore the clustering state from the trace.
+        time_print("Loading partition trace from %s", opts.resume);
+        partition_trace_load(opts.resume, partition_info, dendrogram);
+        time_print("%zu merge step(s), %zu cluster(s) and %zu merge operation(s) restored.", dendrogram.steps.size(), partition_info.cluster_size, partition_info.merge_size);
+        if (opts.groups < 1)
+        {
+            opts.groups = dendrogram.min_groups;
+            opts.groups_max = dendrogram.max_groups;
+        }
+        if (opts.groups < dendrogram.min_groups || opts.groups_max > dendrogram.max_groups)
+        {
+            time_error(-1, "Group range %d-%d is not covered by the trace range %d-%d.", opts.groups, opts.groups_max, dendrogram.min_groups, dendrogram.max_groups);
+        }
+    }
+    else
+    {
+        dendrogram.min_groups = opts.groups;
+        dendrogram.max_groups = opts.groups_max;
+        partition_dendrogram_init(partition_info, dendrogram);
+    }
     //Start clustering.
-    time_print("Clustering %zu informative contigs with target of %d groups...", partition_info.cluster_size, opts.groups);
-    partition_cluster(partition_info, opts.groups);
-    time_print("Merge stage complete, %zu cluster(s) left.", partition_info.cluster_size);
-    //Ignore the clusters only have 1 contig.
-    time_print("Filtering individual node clusters...");
-    std::vector<HMR_CONTIG_ID_VEC*> clusters;
-    clusters.reserve(partition_info.cluster_size);
-    for (size_t i = 0; i < partition_info.cluster_size; ++i)
+    if (partition_trace_is_complete(dendrogram))
+    {
+        time_print("Merge trace is complete, skip merging.");
+    }
+    else
     {
-        //Ignore the individual node cluster.
-        if (partition_info.clusters[i]->size() == 1)
+        time_print("Clustering %zu informative contigs with target of %d-%d groups...", partition_info.cluster_size, dendrogram.min_groups, dendrogram.max_groups);
+        PARTITION_CHECKPOINT checkpoint{ opts.checkpoint, static_cast<time_t>(opts.checkpoint_interval), time(0) };
+        double cluster_start = hmr_stats_now();
+        partition_cluster(partition_info, dendrogram, opts.checkpoint ? partition_checkpoint_proc : NULL, &checkpoint);
+        hmr_stats_stage("partition.cluster", cluster_start);
+        hmr_stats_count("partition.merge_steps", dendrogram.steps.size());
+        time_print("Merge stage complete, %zu merge step(s) recorded.", dendrogram.steps.size());
+        if (opts.checkpoint && partition_trace_save(opts.checkpoint, partition_info, dendrogram))
         {
-            int32_t contig_id = (*partition_info.clusters[i])[0];
-            //Add contig id to invalid contig.
-            invalid_nodes.emplace_back(contig_id);
-            //Reset the belongs flag.
-            partition_info.belongs[contig_id] = NULL;
-            free(partition_info.clusters[i]);
-            continue;
+            time_print("Merge trace saved to %s", opts.checkpoint);
         }
-        //Save the clusters.
-        clusters.emplace_back(partition_info.clusters[i]);
+    }
+    //The clusters are rebuilt from the dendrogram for each group number.
+    for (size_t i = 0; i < partition_info.cluster_size; ++i)
+    {
+        delete partition_info.clusters[i];
     }
     partition_info.cluster_size = 0;
-    time_print("%zu clusters remain.", clusters.size());
-    //Try to recover previously skipped contigs.
-    time_print("Recovering skipped contigs...");
-    //Find out the best matched cluster, but do not add them in.
     std::sort(invalid_nodes.begin(), invalid_nodes.end());
-    partition_recover(clusters, invalid_nodes, opts.non_informative_ratio, partition_info);
-    time_print("Gathering contig clusters...");
-    for (int32_t contig_id : invalid_nodes)
+    for (int32_t num_of_groups = opts.groups; num_of_groups <= opts.groups_max; ++num_of_groups)
     {
-        //Add the contig id to the cluster groups.
-        if (partition_info.belongs[contig_id])
+        //Cut the dendrogram at the group number.
+        time_print("Cutting the merge dendrogram for %d groups...", num_of_groups);
+        std::vector<HMR_CONTIG_ID_VEC*> group_clusters;
+        CLUSTER_CUT_INFO cut_info = partition_dendrogram_cut(dendrogram, num_of_groups, partition_info, group_clusters);
+        //Ignore the clusters only have 1 contig.
+        time_print("Filtering individual node clusters...");
+        HMR_CONTIG_ID_VEC group_invalid_nodes(invalid_nodes);
+        std::vector<HMR_CONTIG_ID_VEC*> clusters;
+        clusters.reserve(group_clusters.size());
+        for (HMR_CONTIG_ID_VEC* cluster : group_clusters)
         {
-            partition_info.belongs[contig_id]->emplace_back(contig_id);
+            //Ignore the individual node cluster.
+            if (cluster->size() == 1)
+            {
+                //Add contig id to invalid contig.
+                group_invalid_nodes.emplace_back((*cluster)[0]);
+                delete cluster;
+                continue;
+            }
+            //Save the clusters.
+            clusters.emplace_back(cluster);
         }
-    }
-    //Dumping the result to the output file.
-    int32_t cluster_total = static_cast<int32_t>(clusters.size());
-    for (int32_t i = 0; i < cluster_total; ++i)
-    {
-        std::string cluster_path = hmr_graph_path_cluster_name(opts.output, i+1, cluster_total);
-        HMR_CONTIG_ID_VEC* group_cluster = clusters[i];
-        int32_t total_re = 0;
-        int64_t total_bp = 0;
-        for(const int32_t contig_id: *group_cluster)
+        time_print("%zu clusters remain.", clusters.size());
+        //Reset the belongs flag of the invalid contigs.
+        for (int32_t contig_id : group_invalid_nodes)
         {
-            total_re += nodes[contig_id].enzyme_count;
-            total_bp += nodes[contig_id].length;
+            partition_info.belongs[contig_id] = NULL;
         }
-        time_print("Saving cluster %zu (%zu contigs, %d RE total, avg 1 per %d bp) to %s", i + 1, group_cluster->size(), total_re, total_bp / total_re, cluster_path.c_str());
-        std::sort(clusters[i]->begin(), clusters[i]->end());
+        //Try to recover previously skipped contigs.
+        time_print("Recovering skipped contigs...");
+        //Find out the best matched cluster, but do not add them in.
+        std::sort(group_invalid_nodes.begin(), group_invalid_nodes.end());
+        {
+            HMR_STATS_SCOPE recover_scope("partition.recover");
+            partition_recover(clusters, group_invalid_nodes, opts.non_informative_ratio, opts.threads, partition_info);
+        }
+        time_print("Gathering contig clusters...");
+        size_t recovered = 0;
+        for (int32_t contig_id : group_invalid_nodes)
+        {
+            //Add the contig id to the cluster groups.
+            if (partition_info.belongs[contig_id])
+            {
+                partition_info.belongs[contig_id]->emplace_back(contig_id);
+                ++recovered;
+            }
+        }
+        //Dumping the result to the output file, sweep results are saved with the group number prefix.
+        std::string group_prefix = opts.groups == opts.groups_max ? std::string(opts.output) :
+            std::string(opts.output) + "_g" + std::to_string(num_of_groups);
+        int32_t cluster_total = static_cast<int32_t>(clusters.size());
+        size_t placed_contigs = 0;
+        int64_t placed_bp = 0;
+        for (int32_t i = 0; i < cluster_total; ++i)
+        {
+            std::string cluster_path = hmr_graph_path_cluster_name(group_prefix.c_str(), i+1, cluster_total);
+            HMR_CONTIG_ID_VEC* group_cluster = clusters[i];
+            int32_t total_re = 0;
+            int64_t total_bp = 0;
+            for(const int32_t contig_id: *group_cluster)
+            {
+                total_re += nodes[contig_id].enzyme_count;
+                total_bp += nodes[contig_id].length;
+            }
+            placed_contigs += group_cluster->size();
+            placed_bp += total_bp;
+            time_print("Saving cluster %zu (%zu contigs, %d RE total, avg 1 per %d bp) to %s", i + 1, group_cluster->size(), total_re, total_bp / total_re, cluster_path.c_str());
+            std::sort(clusters[i]->begin(), clusters[i]->end());
 
-        hmr_graph_save_contig_ids(cluster_path.c_str(), *clusters[i]);
+            hmr_graph_save_contig_ids(cluster_path.c_str(), *clusters[i]);
+            delete clusters[i];
+        }
+        time_print("Groups %d: %d cluster(s), %zu contig(s) / %lld bp placed, %zu recovered, %zu merge(s), %zu allele rejected, last merge score %.4lf",
+            num_of_groups, cluster_total, placed_contigs, static_cast<long long>(placed_bp), recovered, cut_info.merges, cut_info.rejected, cut_info.last_score);
     }
     partition_free_clusters(partition_info);
     time_print("Partition complete.");
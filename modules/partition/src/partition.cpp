@@ -3,7 +3,9 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cmath>
+#include <cstdint>
 
+#include "hmr_task_scheduler.hpp"
 #include "hmr_ui.hpp"
 
 #include "partition.hpp"
@@ -126,6 +128,23 @@ void partition_edge_size_proc(uint64_t edge_size, void* user)
     }
     assert(info->merge);
     info->merge_size = 0;
+    info->merge_capacity = edge_size >> 1;
+}
+
+inline void partition_edge_merge_op(CLUSTER_INFO* info, int32_t start, int32_t end, double score)
+{
+    //Check contig is invalid or not.
+    if (info->belongs[start] == NULL || info->belongs[end] == NULL)
+    {
+        return;
+    }
+    //Construct the merge operation.
+    CLUSTER_MERGE_OP& op = info->merge[info->merge_size];
+    op.a = info->belongs[start];
+    op.b = info->belongs[end];
+    op.score = score;
+    op.is_valid = true;
+    ++info->merge_size;
 }
 
 void partition_edge_proc(HMR_EDGE_INFO* edges, int32_t edge_size, void* user)
@@ -137,24 +156,43 @@ void partition_edge_proc(HMR_EDGE_INFO* edges, int32_t edge_size, void* user)
         const auto &edge = edges[i];
         //Build the edge densities.
         info->link_densities[edge.start].insert(std::make_pair(edge.end, edge.weights));
-        //Check contig is invalid or not.
-        if (info->belongs[edge.start] == NULL || info->belongs[edge.end] == NULL)
-        {
-            continue;
-        }
         //Construct the merge operation.
         if (edge.start < edge.end)
         {
-            CLUSTER_MERGE_OP& op = info->merge[info->merge_size];
-            op.a = info->belongs[edge.start];
-            op.b = info->belongs[edge.end];
-            op.score = edge.weights;
-            op.is_valid = true;
-            ++info->merge_size;
+            partition_edge_merge_op(info, edge.start, edge.end, edge.weights);
         }
     }
 }
 
+void partition_undirected_edge_size_proc(uint64_t edge_size, void* user)
+{
+    CLUSTER_INFO* info = static_cast<CLUSTER_INFO*>(user);
+    //Each undirected edge is one merge operation.
+    info->merge = new CLUSTER_MERGE_OP[edge_size];
+    if (!info->merge)
+    {
+        time_error(-1, "Failed to allocate density info memory.");
+    }
+    assert(info->merge);
+    info->merge_size = 0;
+    info->merge_capacity = edge_size;
+}
+
+void partition_undirected_edge_proc(HMR_UNDIRECTED_EDGE_INFO* edges, int32_t edge_size, void* user)
+{
+    CLUSTER_INFO* info = static_cast<CLUSTER_INFO*>(user);
+    //Loop through the partition, construct the edge and link densities in both directions.
+    for (int32_t i = 0; i < edge_size; ++i)
+    {
+        const auto &edge = edges[i];
+        //Build the edge densities.
+        info->link_densities[edge.start].insert(std::make_pair(edge.end, edge.weights[0]));
+        info->link_densities[edge.end].insert(std::make_pair(edge.start, edge.weights[1]));
+        //Construct the merge operation.
+        partition_edge_merge_op(info, edge.start, edge.end, edge.weights[0]);
+    }
+}
+
 inline double get_density(int32_t node_id, const CONTIG_LINK_DENSITY& node_density)
 {
     const auto& iter = node_density.find(node_id);
@@ -178,17 +216,54 @@ double get_total_linkage(HMR_CONTIG_ID_VEC* group_a, HMR_CONTIG_ID_VEC* group_b,
     return total_linkage;
 }
 
-void partition_cluster(CLUSTER_INFO& cluster_info, int32_t num_of_groups)
+inline size_t partition_dendrogram_check_cuts(CLUSTER_DENDROGRAM& dendrogram, size_t cluster_size, size_t non_singleton_clusters, bool merge_enough)
+{
+    //Cut the dendrogram for the group numbers which reach their stop state at current step.
+    size_t pending = 0;
+    for (int32_t num_of_groups = dendrogram.min_groups; num_of_groups <= dendrogram.max_groups; ++num_of_groups)
+    {
+        size_t& cut = dendrogram.cuts[num_of_groups - dendrogram.min_groups];
+        if (cut != SIZE_MAX)
+        {
+            continue;
+        }
+        if (cluster_size <= static_cast<size_t>(num_of_groups) ||
+            (merge_enough && non_singleton_clusters == static_cast<size_t>(num_of_groups)))
+        {
+            cut = dendrogram.steps.size();
+            continue;
+        }
+        ++pending;
+    }
+    return pending;
+}
+
+void partition_dendrogram_init(const CLUSTER_INFO& cluster_info, CLUSTER_DENDROGRAM& dendrogram)
+{
+    //Record the initial clusters of the dendrogram.
+    dendrogram.contigs.reserve(cluster_info.cluster_size);
+    for (size_t i = 0; i < cluster_info.cluster_size; ++i)
+    {
+        dendrogram.contigs.push_back((*cluster_info.clusters[i])[0]);
+    }
+    dendrogram.cuts.assign(dendrogram.max_groups - dendrogram.min_groups + 1, SIZE_MAX);
+    dendrogram.merged = 0;
+    dendrogram.non_singletons = 0;
+}
+
+void partition_cluster(CLUSTER_INFO& cluster_info, CLUSTER_DENDROGRAM& dendrogram, CLUSTER_CHECKPOINT_PROC checkpoint_proc, void* user)
 {
     auto& merges = cluster_info.merge;
     auto& groups = cluster_info.clusters;
     //Loop until:
     //   - Nothing to merge
-    //   - Cluster number reaches request.
-    uint64_t op_counter = 0;
-    size_t non_singleton_clusters = 0;
-    const size_t non_skipped = (cluster_info.cluster_size >> 1);
-    while (cluster_info.merge_size > 0 && cluster_info.cluster_size > static_cast<size_t>(num_of_groups))
+    //   - Cluster number reaches all the requests.
+    //The merge counters are kept in the dendrogram, so a resumed clustering continues from them.
+    uint64_t& op_counter = dendrogram.merged;
+    size_t& non_singleton_clusters = dendrogram.non_singletons;
+    const size_t non_skipped = (dendrogram.contigs.size() >> 1);
+    size_t pending_cuts = partition_dendrogram_check_cuts(dendrogram, cluster_info.cluster_size, non_singleton_clusters, op_counter > non_skipped);
+    while (cluster_info.merge_size > 0 && pending_cuts > 0)
     {
         //Find out the maximum weight in merge request.
         size_t max_weight_id = 0;
@@ -214,9 +289,11 @@ void partition_cluster(CLUSTER_INFO& cluster_info, int32_t num_of_groups)
         {
             //Mark the merge operation is not accepted.
             op_accept = false;
+            dendrogram.steps.push_back(CLUSTER_MERGE_STEP{ (*group_a)[0], (*group_b)[0], op.score, false });
         }
         else
         {
+            dendrogram.steps.push_back(CLUSTER_MERGE_STEP{ (*group_a)[0], (*group_b)[0], op.score, true });
             //What this magic?
             if (group_a->size() == 1)
             {
@@ -313,83 +390,193 @@ void partition_cluster(CLUSTER_INFO& cluster_info, int32_t num_of_groups)
         //UI hints.
         ++op_counter;
         //Analyze the current clusters if enough merges occured.
-        if (op_counter > non_skipped && non_singleton_clusters <= static_cast<size_t>(num_of_groups))
-        {
-            if (non_singleton_clusters == static_cast<size_t>(num_of_groups))
-            {
-                break;
-            }
-        }
+        pending_cuts = partition_dendrogram_check_cuts(dendrogram, cluster_info.cluster_size, non_singleton_clusters, op_counter > non_skipped);
         if (op_counter % 50 == 0)
         {
             time_print("%zu cluster(s) left.", cluster_info.cluster_size);
         }
+        //Let the caller save the clustering state.
+        if (checkpoint_proc)
+        {
+            checkpoint_proc(cluster_info, dendrogram, user);
+        }
+    }
+    //The rest of the group numbers stop when no merge operation left.
+    for (size_t& cut : dendrogram.cuts)
+    {
+        if (cut == SIZE_MAX)
+        {
+            cut = dendrogram.steps.size();
+        }
     }
 }
 
-double partition_contig_cluster_linkage(int32_t contig_id, HMR_CONTIG_ID_VEC* cluster, const GRAPH_LINK_DENSITY& link_density, bool *has_linkage)
+inline int32_t partition_dendrogram_find(std::vector<int32_t>& parent, int32_t contig_id)
 {
-    //Get the contig id to cluster.
-    double total_linkage = 0.0;
-    //Extract its node map.
-    const CONTIG_LINK_DENSITY& node_link_density = link_density[contig_id];
-    for (int32_t group_id : *cluster)
+    //Find the root with path halving.
+    while (parent[contig_id] != contig_id)
+    {
+        parent[contig_id] = parent[parent[contig_id]];
+        contig_id = parent[contig_id];
+    }
+    return contig_id;
+}
+
+CLUSTER_CUT_INFO partition_dendrogram_cut(const CLUSTER_DENDROGRAM& dendrogram, int32_t num_of_groups, CLUSTER_INFO& info, std::vector<HMR_CONTIG_ID_VEC*>& clusters)
+{
+    CLUSTER_CUT_INFO cut_info{ 0, 0, 0.0 };
+    size_t num_of_contigs = info.link_densities.size(),
+        cut = dendrogram.cuts[num_of_groups - dendrogram.min_groups];
+    //Replay the merge steps before the cut.
+    std::vector<int32_t> parent(num_of_contigs), last_merge(num_of_contigs, -1);
+    for (size_t i = 0; i < num_of_contigs; ++i)
+    {
+        parent[i] = static_cast<int32_t>(i);
+    }
+    for (size_t i = 0; i < cut; ++i)
     {
-        auto group_id_iter = node_link_density.find(group_id);
-        if (group_id_iter != node_link_density.end())
+        const CLUSTER_MERGE_STEP& step = dendrogram.steps[i];
+        if (!step.accepted)
         {
-            *has_linkage = true;
-            total_linkage += group_id_iter->second;
+            ++cut_info.rejected;
+            continue;
         }
+        int32_t root_a = partition_dendrogram_find(parent, step.a),
+            root_b = partition_dendrogram_find(parent, step.b);
+        parent[root_b] = root_a;
+        last_merge[root_a] = static_cast<int32_t>(i);
+        ++cut_info.merges;
+        cut_info.last_score = step.score;
     }
-    return total_linkage / static_cast<double>(cluster->size());
+    //Gather the clusters from the roots.
+    std::vector<HMR_CONTIG_ID_VEC*> root_cluster(num_of_contigs, NULL);
+    std::vector<int32_t> cluster_roots;
+    for (const int32_t contig_id : dendrogram.contigs)
+    {
+        int32_t root = partition_dendrogram_find(parent, contig_id);
+        if (root_cluster[root] == NULL)
+        {
+            root_cluster[root] = new HMR_CONTIG_ID_VEC();
+            cluster_roots.push_back(root);
+        }
+        root_cluster[root]->push_back(contig_id);
+        info.belongs[contig_id] = root_cluster[root];
+    }
+    //Unmerged clusters keep their original order, merged clusters follow by their last merge.
+    std::stable_sort(cluster_roots.begin(), cluster_roots.end(),
+        [&last_merge](int32_t lhs, int32_t rhs)
+        {
+            return last_merge[lhs] < last_merge[rhs];
+        });
+    clusters.reserve(cluster_roots.size());
+    for (const int32_t root : cluster_roots)
+    {
+        clusters.push_back(root_cluster[root]);
+    }
+    return cut_info;
 }
 
 typedef struct RECOVER_LINKAGE
 {
-    HMR_CONTIG_ID_VEC* cluster;
+    int32_t cluster_id;
     double average_linkage;
 } RECOVER_LINKAGE;
 
-bool partition_recover_linkage_greater(const RECOVER_LINKAGE& lhs, const RECOVER_LINKAGE& rhs)
+void partition_recover_worker(int32_t worker_id, int32_t threads, const std::vector<HMR_CONTIG_ID_VEC*>& clusters, const std::vector<int32_t>& contig_cluster,
+    const HMR_CONTIG_ID_VEC& invalid_ids, double non_info_ratio, const CLUSTER_INFO& info, HMR_CONTIG_ID_VEC** recovered)
 {
-    return lhs.average_linkage > rhs.average_linkage;
-}
-
-void partition_recover(const std::vector<HMR_CONTIG_ID_VEC*>& clusters, const HMR_CONTIG_ID_VEC& invalid_ids, const int32_t non_info_ratio, CLUSTER_INFO& info)
-{
-    RECOVER_LINKAGE *contig_linkages = new RECOVER_LINKAGE[clusters.size()];
-    double non_info_ratio_f = static_cast<double>(non_info_ratio);
-    assert(contig_linkages);
-    //Loop and check all the cluster linkages.
-    bool has_linkage;
-    for (const int32_t contig_id : invalid_ids)
+    //Per-cluster total linkage of the current contig, only the touched clusters are reset.
+    std::vector<double> cluster_linkage(clusters.size(), 0.0);
+    std::vector<bool> cluster_touched(clusters.size(), false);
+    std::vector<int32_t> touched;
+    for (size_t i = worker_id; i < invalid_ids.size(); i += threads)
     {
-        size_t linkage_size = 0;
-        for (HMR_CONTIG_ID_VEC* cluster : clusters)
+        //Walk through the neighbours of the contig once.
+        for (const auto& neighbour : info.link_densities[invalid_ids[i]])
         {
-            //Calculate the contig to cluster linkage.
-            has_linkage = false;
-            double linkage = partition_contig_cluster_linkage(contig_id, cluster, info.link_densities, &has_linkage);
-            if (has_linkage)
+            int32_t cluster_id = contig_cluster[neighbour.first];
+            if (cluster_id < 0)
+            {
+                continue;
+            }
+            if (!cluster_touched[cluster_id])
             {
-                contig_linkages[linkage_size] = RECOVER_LINKAGE{ cluster, linkage };
-                ++linkage_size;
+                cluster_touched[cluster_id] = true;
+                touched.push_back(cluster_id);
             }
+            cluster_linkage[cluster_id] += neighbour.second;
         }
-        if (linkage_size == 0)
+        if (touched.empty())
         {
             continue;
         }
-        //Calculate the pass ratio. (why it is a boolean equation?)
-        std::sort(contig_linkages, contig_linkages + linkage_size, partition_recover_linkage_greater);
-        const auto& best = contig_linkages[0];
-        const auto& second_best = contig_linkages[1];
-        if (best.average_linkage >= non_info_ratio_f &&
-            ((linkage_size == 1) || (second_best.average_linkage == 0.0) || (best.average_linkage / second_best.average_linkage >= non_info_ratio_f)))
+        //Keep the best two average linkages, ties keep the cluster comes first.
+        std::sort(touched.begin(), touched.end());
+        RECOVER_LINKAGE best{ -1, 0.0 }, second_best{ -1, 0.0 };
+        for (const int32_t cluster_id : touched)
+        {
+            double linkage = cluster_linkage[cluster_id] / static_cast<double>(clusters[cluster_id]->size());
+            if (best.cluster_id == -1 || linkage > best.average_linkage)
+            {
+                second_best = best;
+                best = RECOVER_LINKAGE{ cluster_id, linkage };
+            }
+            else if (second_best.cluster_id == -1 || linkage > second_best.average_linkage)
+            {
+                second_best = RECOVER_LINKAGE{ cluster_id, linkage };
+            }
+            cluster_linkage[cluster_id] = 0.0;
+            cluster_touched[cluster_id] = false;
+        }
+        touched.clear();
+        //Calculate the pass ratio.
+        if (best.average_linkage >= non_info_ratio &&
+            ((second_best.cluster_id == -1) || (second_best.average_linkage == 0.0) || (best.average_linkage / second_best.average_linkage >= non_info_ratio)))
+        {
+            recovered[i] = clusters[best.cluster_id];
+        }
+    }
+}
+
+void partition_recover(const std::vector<HMR_CONTIG_ID_VEC*>& clusters, const HMR_CONTIG_ID_VEC& invalid_ids, const int32_t non_info_ratio, int32_t threads, CLUSTER_INFO& info)
+{
+    //Build the contig to cluster index.
+    std::vector<int32_t> contig_cluster(info.link_densities.size(), -1);
+    for (size_t i = 0; i < clusters.size(); ++i)
+    {
+        for (const int32_t contig_id : *clusters[i])
+        {
+            contig_cluster[contig_id] = static_cast<int32_t>(i);
+        }
+    }
+    //The workers only write their own results, belongs is updated after all of them complete.
+    HMR_CONTIG_ID_VEC** recovered = static_cast<HMR_CONTIG_ID_VEC**>(malloc(sizeof(HMR_CONTIG_ID_VEC*) * invalid_ids.size()));
+    if (!recovered && !invalid_ids.empty())
+    {
+        time_error(-1, "Failed to allocate memory for recovered contigs.");
+    }
+    std::fill(recovered, recovered + invalid_ids.size(), static_cast<HMR_CONTIG_ID_VEC*>(NULL));
+    double non_info_ratio_f = static_cast<double>(non_info_ratio);
+    if (threads < 2)
+    {
+        partition_recover_worker(0, 1, clusters, contig_cluster, invalid_ids, non_info_ratio_f, info, recovered);
+    }
+    else
+    {
+        hmr::task_scheduler scheduler(threads);
+        hmr::task_group recover_group(scheduler);
+        for (int32_t i = 0; i < threads; ++i)
+        {
+            recover_group.run([&, i] { partition_recover_worker(i, threads, clusters, contig_cluster, invalid_ids, non_info_ratio_f, info, recovered); });
+        }
+        recover_group.wait();
+    }
+    for (size_t i = 0; i < invalid_ids.size(); ++i)
+    {
+        if (recovered[i])
         {
-            info.belongs[contig_id] = best.cluster;
+            info.belongs[invalid_ids[i]] = recovered[i];
         }
     }
-    delete[] contig_linkages;
+    free(recovered);
 }
@@ -8,10 +8,15 @@ void partition_free_clusters(CLUSTER_INFO& info);
 
 void partition_edge_size_proc(uint64_t edge_size, void* user);
 void partition_edge_proc(HMR_EDGE_INFO* edges, int32_t edge_size, void* user);
+void partition_undirected_edge_size_proc(uint64_t edge_size, void* user);
+void partition_undirected_edge_proc(HMR_UNDIRECTED_EDGE_INFO* edges, int32_t edge_size, void* user);
 
-void partition_cluster(CLUSTER_INFO& cluster_info, int32_t num_of_groups);
+typedef void (*CLUSTER_CHECKPOINT_PROC)(const CLUSTER_INFO& info, const CLUSTER_DENDROGRAM& dendrogram, void* user);
 
-double partition_contig_cluster_linkage(int32_t contig_id, HMR_CONTIG_ID_VEC* cluster, const GRAPH_LINK_DENSITY& link_density, bool* has_linkage);
-void partition_recover(const std::vector<HMR_CONTIG_ID_VEC*>& clusters, const HMR_CONTIG_ID_VEC& invalid_ids, const int32_t non_info_ratio, CLUSTER_INFO& info);
+void partition_dendrogram_init(const CLUSTER_INFO& cluster_info, CLUSTER_DENDROGRAM& dendrogram);
+void partition_cluster(CLUSTER_INFO& cluster_info, CLUSTER_DENDROGRAM& dendrogram, CLUSTER_CHECKPOINT_PROC checkpoint_proc, void* user);
+CLUSTER_CUT_INFO partition_dendrogram_cut(const CLUSTER_DENDROGRAM& dendrogram, int32_t num_of_groups, CLUSTER_INFO& info, std::vector<HMR_CONTIG_ID_VEC*>& clusters);
+
+void partition_recover(const std::vector<HMR_CONTIG_ID_VEC*>& clusters, const HMR_CONTIG_ID_VEC& invalid_ids, const int32_t non_info_ratio, int32_t threads, CLUSTER_INFO& info);
 
 #endif // PARTITION_H
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+
+#include "hmr_bin_file.hpp"
+#include "hmr_ui.hpp"
+
+#include "partition_trace.hpp"
+
+typedef struct CLUSTER_TRACE_HEADER
+{
+    int32_t num_of_contigs;
+    int32_t min_groups;
+    int32_t max_groups;
+    int32_t num_of_clusters;
+    uint64_t merged;
+    uint64_t non_singletons;
+    uint64_t num_of_initials;
+    uint64_t num_of_steps;
+    uint64_t num_of_merges;
+} CLUSTER_TRACE_HEADER;
+
+typedef struct CLUSTER_TRACE_MERGE
+{
+    int32_t a;
+    int32_t b;
+    double score;
+} CLUSTER_TRACE_MERGE;
+
+bool partition_trace_save(const char* filepath, const CLUSTER_INFO& info, const CLUSTER_DENDROGRAM& dendrogram)
+{
+    //Write to a temporary file first, a killed process would never leave a broken trace.
+    std::string temp_path = std::string(filepath) + ".tmp";
+    FILE* trace_file;
+    if (!bin_open(temp_path.c_str(), &trace_file, "wb"))
+    {
+        time_print("Failed to save partition trace to %s", temp_path.c_str());
+        return false;
+    }
+    CLUSTER_TRACE_HEADER header;
+    header.num_of_contigs = static_cast<int32_t>(info.link_densities.size());
+    header.min_groups = dendrogram.min_groups;
+    header.max_groups = dendrogram.max_groups;
+    header.num_of_clusters = static_cast<int32_t>(info.cluster_size);
+    header.merged = dendrogram.merged;
+    header.non_singletons = dendrogram.non_singletons;
+    header.num_of_initials = dendrogram.contigs.size();
+    header.num_of_steps = dendrogram.steps.size();
+    header.num_of_merges = info.merge_size;
+    fwrite(&header, sizeof(CLUSTER_TRACE_HEADER), 1, trace_file);
+    //Write the merge steps of the dendrogram.
+    fwrite(dendrogram.contigs.data(), sizeof(int32_t), dendrogram.contigs.size(), trace_file);
+    fwrite(dendrogram.steps.data(), sizeof(CLUSTER_MERGE_STEP), dendrogram.steps.size(), trace_file);
+    for (const size_t cut : dendrogram.cuts)
+    {
+        uint64_t cut_pos = cut == SIZE_MAX ? UINT64_MAX : static_cast<uint64_t>(cut);
+        fwrite(&cut_pos, sizeof(uint64_t), 1, trace_file);
+    }
+    //Write the union-find parent array, each contig points to the first contig of its cluster.
+    std::vector<int32_t> parent(info.link_densities.size(), -1), cluster_roots;
+    cluster_roots.reserve(info.cluster_size);
+    for (size_t i = 0; i < info.cluster_size; ++i)
+    {
+        const HMR_CONTIG_ID_VEC& cluster = *info.clusters[i];
+        for (const int32_t contig_id : cluster)
+        {
+            parent[contig_id] = cluster[0];
+        }
+        cluster_roots.push_back(cluster[0]);
+    }
+    fwrite(parent.data(), sizeof(int32_t), parent.size(), trace_file);
+    //Write the live clusters in their current order.
+    fwrite(cluster_roots.data(), sizeof(int32_t), cluster_roots.size(), trace_file);
+    //Write the pending merge operations.
+    for (size_t i = 0; i < info.merge_size; ++i)
+    {
+        const CLUSTER_MERGE_OP& op = info.merge[i];
+        CLUSTER_TRACE_MERGE record{ (*op.a)[0], (*op.b)[0], op.score };
+        fwrite(&record, sizeof(CLUSTER_TRACE_MERGE), 1, trace_file);
+    }
+    bool written = !ferror(trace_file);
+    fclose(trace_file);
+    if (!written)
+    {
+        time_print("Failed to write partition trace to %s", temp_path.c_str());
+        return false;
+    }
+    //Replace the previous trace.
+    remove(filepath);
+    if (rename(temp_path.c_str(), filepath) != 0)
+    {
+        time_print("Failed to replace partition trace %s", filepath);
+        return false;
+    }
+    return true;
+}
+
+void partition_trace_load(const char* filepath, CLUSTER_INFO& info, CLUSTER_DENDROGRAM& dendrogram)
+{
+    FILE* trace_file;
+    if (!bin_open(filepath, &trace_file, "rb"))
+    {
+        time_error(-1, "Failed to load partition trace from %s", filepath);
+    }
+    CLUSTER_TRACE_HEADER header;
+    if (fread(&header, sizeof(CLUSTER_TRACE_HEADER), 1, trace_file) != 1)
+    {
+        time_error(-1, "Failed to read partition trace header from %s", filepath);
+    }
+    size_t num_of_contigs = info.link_densities.size();
+    if (static_cast<size_t>(header.num_of_contigs) != num_of_contigs)
+    {
+        time_error(-1, "Partition trace %s is built from %d contig(s), but %zu contig(s) are loaded.", filepath, header.num_of_contigs, num_of_contigs);
+    }
+    //Read the merge steps of the dendrogram.
+    dendrogram.min_groups = header.min_groups;
+    dendrogram.max_groups = header.max_groups;
+    dendrogram.merged = header.merged;
+    dendrogram.non_singletons = static_cast<size_t>(header.non_singletons);
+    dendrogram.contigs.resize(header.num_of_initials);
+    dendrogram.steps.resize(header.num_of_steps);
+    dendrogram.cuts.resize(header.max_groups - header.min_groups + 1);
+    std::vector<uint64_t> cuts(dendrogram.cuts.size());
+    std::vector<int32_t> parent(num_of_contigs), cluster_roots(header.num_of_clusters);
+    std::vector<CLUSTER_TRACE_MERGE> merges(header.num_of_merges);
+    if (fread(dendrogram.contigs.data(), sizeof(int32_t), dendrogram.contigs.size(), trace_file) != dendrogram.contigs.size() ||
+        fread(dendrogram.steps.data(), sizeof(CLUSTER_MERGE_STEP), dendrogram.steps.size(), trace_file) != dendrogram.steps.size() ||
+        fread(cuts.data(), sizeof(uint64_t), cuts.size(), trace_file) != cuts.size() ||
+        fread(parent.data(), sizeof(int32_t), parent.size(), trace_file) != parent.size() ||
+        fread(cluster_roots.data(), sizeof(int32_t), cluster_roots.size(), trace_file) != cluster_roots.size() ||
+        fread(merges.data(), sizeof(CLUSTER_TRACE_MERGE), merges.size(), trace_file) != merges.size())
+    {
+        time_error(-1, "Partition trace %s is truncated.", filepath);
+    }
+    fclose(trace_file);
+    for (size_t i = 0; i < cuts.size(); ++i)
+    {
+        dendrogram.cuts[i] = cuts[i] == UINT64_MAX ? SIZE_MAX : static_cast<size_t>(cuts[i]);
+    }
+    //Rebuild the live clusters from the parent array.
+    for (size_t i = 0; i < info.cluster_size; ++i)
+    {
+        delete info.clusters[i];
+    }
+    free(info.clusters);
+    info.clusters = static_cast<HMR_CONTIG_ID_VEC**>(malloc(sizeof(HMR_CONTIG_ID_VEC*) * cluster_roots.size()));
+    if (!info.clusters)
+    {
+        time_error(-1, "Failed to allocate memory for clusters.");
+    }
+    assert(info.clusters);
+    for (size_t i = 0; i < num_of_contigs; ++i)
+    {
+        int32_t root = parent[i];
+        if (root < 0)
+        {
+            info.belongs[i] = NULL;
+            continue;
+        }
+        //The root is the smallest contig of the cluster, which is always visited first.
+        info.belongs[i] = static_cast<size_t>(root) == i ? new HMR_CONTIG_ID_VEC() : info.belongs[root];
+        info.belongs[i]->push_back(static_cast<int32_t>(i));
+    }
+    for (size_t i = 0; i < cluster_roots.size(); ++i)
+    {
+        info.clusters[i] = info.belongs[cluster_roots[i]];
+    }
+    info.cluster_size = cluster_roots.size();
+    //Rebuild the pending merge operations.
+    if (info.merge_capacity < merges.size())
+    {
+        delete[] info.merge;
+        info.merge = new CLUSTER_MERGE_OP[merges.size()];
+        info.merge_capacity = merges.size();
+    }
+    for (size_t i = 0; i < merges.size(); ++i)
+    {
+        info.merge[i] = CLUSTER_MERGE_OP{ info.belongs[merges[i].a], info.belongs[merges[i].b], merges[i].score, true };
+    }
+    info.merge_size = merges.size();
+}
+
+bool partition_trace_is_complete(const CLUSTER_DENDROGRAM& dendrogram)
+{
+    for (const size_t cut : dendrogram.cuts)
+    {
+        if (cut == SIZE_MAX)
+        {
+            return false;
+        }
+    }
+    return true;
+}
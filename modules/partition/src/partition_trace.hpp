@@ -0,0 +1,15 @@
+#ifndef PARTITION_TRACE_H
+#define PARTITION_TRACE_H
+
+#include "partition_type.hpp"
+
+/* Save the clustering state and the merge steps into a partition trace file */
+bool partition_trace_save(const char* filepath, const CLUSTER_INFO& info, const CLUSTER_DENDROGRAM& dendrogram);
+
+/* Restore the clustering state and the merge steps from a partition trace file, the edges should be loaded before */
+void partition_trace_load(const char* filepath, CLUSTER_INFO& info, CLUSTER_DENDROGRAM& dendrogram);
+
+/* Check whether all the group numbers in the trace have been cut */
+bool partition_trace_is_complete(const CLUSTER_DENDROGRAM& dendrogram);
+
+#endif // PARTITION_TRACE_H
@@ -16,13 +16,38 @@ typedef struct CLUSTER_MERGE_OP
     bool is_valid;
 } CLUSTER_MERGE_OP;
 
+typedef struct CLUSTER_MERGE_STEP
+{
+    int32_t a;
+    int32_t b;
+    double score;
+    bool accepted;
+} CLUSTER_MERGE_STEP;
+
+typedef struct CLUSTER_DENDROGRAM
+{
+    int32_t min_groups, max_groups;
+    HMR_CONTIG_ID_VEC contigs;
+    std::vector<CLUSTER_MERGE_STEP> steps;
+    std::vector<size_t> cuts;
+    uint64_t merged = 0;
+    size_t non_singletons = 0;
+} CLUSTER_DENDROGRAM;
+
+typedef struct CLUSTER_CUT_INFO
+{
+    size_t merges;
+    size_t rejected;
+    double last_score;
+} CLUSTER_CUT_INFO;
+
 typedef struct CLUSTER_INFO
 {
     HMR_CONTIG_ID_VEC** belongs = NULL;
     HMR_CONTIG_ID_VEC** clusters = NULL;
     size_t cluster_size = 0;
     CLUSTER_MERGE_OP* merge = NULL;
-    size_t merge_size = 0;
+    size_t merge_size = 0, merge_capacity = 0;
     HMR_ALLELE_MAP* allele_map = NULL;
     GRAPH_LINK_DENSITY link_densities;
 } CLUSTER_INFO;
@@ -3,6 +3,7 @@
 #include "hmr_bgzf.hpp"
 #include "hmr_bin_queue.hpp"
 #include "hmr_global.hpp"
+#include "hmr_stats.hpp"
 #include "hmr_ui.hpp"
 
 #include "hmr_bam.hpp"
@@ -32,9 +33,10 @@ void hmr_bam_read(const char* filepath, BAM_MAPPING_PROC proc, void* user, int t
         //Format:
         // [name length] [name] [seq length]
         // name length include '\0'
-        uint32_t l_name = hmr_bin_buf_fetch_uint32(buf, queue);
-        char* name = hmr_bin_buf_fetch(buf, queue, l_name);
-        uint32_t l_ref = hmr_bin_buf_fetch_uint32(buf, queue);
+        uint32_t l_name = hmr_bin_buf_fetch_uint32(buf, queue), l_ref;
+        //The name and the length are fetched together, the name is only valid until the next fetch.
+        char* name = hmr_bin_buf_fetch(buf, queue, l_name + 4);
+        memcpy(&l_ref, name + l_name, sizeof(uint32_t));
         proc.proc_contig(l_name - 1, name, l_ref, user);
     }
     //Fetch the rest of the data (align data).
@@ -52,6 +54,10 @@ void hmr_bam_read(const char* filepath, BAM_MAPPING_PROC proc, void* user, int t
         //Fetch the next block.
         block_size_data = hmr_bin_buf_fetch(buf, queue, 4);
     }
+    if (hmr_stats_enabled())
+    {
+        hmr_stats_count("bam.records", block_id);
+    }
     //Close the BGZF file.
     hmr_bgzf_close(bgzf_handler);
 }
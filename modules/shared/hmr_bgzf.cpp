@@ -1,10 +1,12 @@
 #include <cassert>
+#include <cstring>
 #include <zlib.h>
 
 #include "hmr_bin_file.hpp"
 #include "hmr_bin_queue.hpp"
+#include "hmr_stats.hpp"
+#include "hmr_task_scheduler.hpp"
 #include "hmr_ui.hpp"
-#include "hmr_thread_pool.hpp"
 #include "hmr_global.hpp"
 
 #include "hmr_bgzf.hpp"
@@ -44,71 +46,55 @@ typedef struct HMR_BGZF_DECOMPRESS
     size_t raw_size;
 } HMR_BGZF_DECOMPRESS;
 
-typedef struct BGZF_UNPACK_PARAM
+void hmr_bgzf_decompress(HMR_BGZF_DECOMPRESS* pool, int32_t start, int32_t end, char* bgzf_raw)
 {
-    int id;
-    bool finished;
-    int32_t max_work;
-    HMR_BGZF_DECOMPRESS* pool;
-    char* bgzf_raw;
-    int32_t *worker_completed;
-} BGZF_UNPACK_PARAM;
-
-void hmr_bgzf_decompress(int32_t thread_count, std::mutex &mutex, std::mutex& complete_mutex, std::condition_variable &cv, std::condition_variable &join_cv, BGZF_UNPACK_PARAM *param)
-{
-    //The thread id and decompress pool would never changed.
-    const int id = param->id;
-    HMR_BGZF_DECOMPRESS* pool = param->pool;
-    while (true)
+    //Loop and decompress the data.
+    for (int32_t i = start; i < end; ++i)
     {
-        //Keep wait.
-        std::unique_lock<std::mutex> lock(mutex);
-        cv.wait(lock);
-        if (param->finished)
-        {
-            break;
-        }
-        //Or else, we have to do the work.
-        char* bgzf_raw = param->bgzf_raw;
-        //Loop and decompress the data.
-        for (int i = id * WORK_PER_THREAD, target = hMin(param->max_work, (id + 1) * WORK_PER_THREAD); i < target; ++i)
-        {
-            z_stream strm;
-            strm.zalloc = Z_NULL;
-            strm.zfree = Z_NULL;
-            strm.opaque = Z_NULL;
-            strm.next_in = reinterpret_cast<Bytef*>(pool[i].cdata);
-            strm.avail_in = pool[i].cdata_size;
-            strm.next_out = reinterpret_cast<Bytef*>(bgzf_raw + pool[i].offset);
-            strm.avail_out = static_cast<uInt>(pool[i].raw_size);
-            //Add 32 to enable zlib and gzip decoding with header detection.
-            if (Z_OK != inflateInit2(&strm, -15))
-            {
-                time_error(-1, "Failed to initialize decompressor stream.");
-            }
-            //Decompress the data.
-            int error = inflate(&strm, Z_FULL_FLUSH);
-            HMR_UNUSED(error)
-            //Recover the compress data memory.
-            free(pool[i].cdata);
-            //Close the zlib stream.
-            inflateEnd(&strm);
-        }
-        //Okay, mission complete, increase the counter.
+        z_stream strm;
+        strm.zalloc = Z_NULL;
+        strm.zfree = Z_NULL;
+        strm.opaque = Z_NULL;
+        strm.next_in = reinterpret_cast<Bytef*>(pool[i].cdata);
+        strm.avail_in = pool[i].cdata_size;
+        strm.next_out = reinterpret_cast<Bytef*>(bgzf_raw + pool[i].offset);
+        strm.avail_out = static_cast<uInt>(pool[i].raw_size);
+        //Add 32 to enable zlib and gzip decoding with header detection.
+        if (Z_OK != inflateInit2(&strm, -15))
         {
-            std::unique_lock<std::mutex> counter_lock(complete_mutex);
-            ++(*param->worker_completed);
-            //Notify the join cv.
-            if (*param->worker_completed == thread_count)
-            {
-                join_cv.notify_one();
-            }
+            time_error(-1, "Failed to initialize decompressor stream.");
         }
+        //Decompress the data.
+        int error = inflate(&strm, Z_FULL_FLUSH);
+        HMR_UNUSED(error)
+        //Recover the compress data memory.
+        free(pool[i].cdata);
+        //Close the zlib stream.
+        inflateEnd(&strm);
+    }
+}
+
+void hmr_bgzf_inflate(hmr::task_group& inflate_group, HMR_BGZF_DECOMPRESS* pool, int32_t max_work, char* bgzf_raw)
+{
+    double inflate_start = hmr_stats_enabled() ? hmr_stats_now() : 0.0;
+    //Each slice of the blocks is a task, wait for all the slices before pushing the data.
+    for (int32_t start = 0; start < max_work; start += WORK_PER_THREAD)
+    {
+        int32_t end = hMin(max_work, start + WORK_PER_THREAD);
+        inflate_group.run([pool, start, end, bgzf_raw] { hmr_bgzf_decompress(pool, start, end, bgzf_raw); });
+    }
+    inflate_group.wait();
+    if (hmr_stats_enabled())
+    {
+        hmr_stats_stage("bgzf.inflate", inflate_start);
     }
 }
 
 void hmr_bgzf_parse(FILE* bgzf_file, HMR_BIN_QUEUE* queue, int threads)
 {
+    //The reading time is the parse time without the inflate and the queue waiting.
+    HMR_STATS_SCOPE parse_scope("bgzf.parse");
+    uint64_t num_of_blocks = 0, compressed_bytes = 0, raw_bytes = 0;
     //Get the total file size.
     fseek(bgzf_file, 0L, SEEK_END);
 #ifdef _MSC_VER
@@ -131,33 +117,8 @@ void hmr_bgzf_parse(FILE* bgzf_file, HMR_BIN_QUEUE* queue, int threads)
     }
     assert(bgzf_buf);
     //Create the working pool.
-    int32_t worker_completed = 0;
-    std::mutex worker_complete_mutex;
-    std::mutex* worker_mutex = new std::mutex[threads], join_mutex;
-    if (!worker_mutex)
-    {
-        time_error(-1, "Not enough memory for creating BGZF mutex.");
-    }
-    std::condition_variable *worker_cv = new std::condition_variable[threads], join_cv;
-    if (!worker_cv)
-    {
-        time_error(-1, "Not enough memory for creating BGZF condition variable.");
-    }
-    std::thread* workers = new std::thread[threads];
-    if (!worker_cv)
-    {
-        time_error(-1, "Not enough memory for creating BGZF worker threads.");
-    }
-    BGZF_UNPACK_PARAM* worker_params = new BGZF_UNPACK_PARAM[threads];
-    if (!worker_params)
-    {
-        time_error(-1, "Not enough memory for creating BGZF worker parameters.");
-    }
-    for (int32_t i = 0; i < threads; ++i)
-    {
-        worker_params[i] = BGZF_UNPACK_PARAM { i , false, buf_size, bgzf_buf, NULL, &worker_completed };
-        workers[i] = std::thread(hmr_bgzf_decompress, threads, std::ref(worker_mutex[i]), std::ref(worker_complete_mutex), std::ref(worker_cv[i]), std::ref(join_cv), & worker_params[i]);
-    }
+    hmr::task_scheduler scheduler(threads);
+    hmr::task_group inflate_group(scheduler);
     //Read while to the end of the file.
     while (!queue->finish && fread(&header_buf, sizeof(BGZF_HEADER), 1, bgzf_file) > 0)
     {
@@ -191,6 +152,9 @@ void hmr_bgzf_parse(FILE* bgzf_file, HMR_BIN_QUEUE* queue, int threads)
         fread(cdata, cdata_size, 1, bgzf_file);
         //Fetch the footer data.
         fread(&footer_buf, sizeof(BGZF_FOOTER), 1, bgzf_file);
+        ++num_of_blocks;
+        compressed_bytes += static_cast<uint64_t>(bsize) + 1;
+        raw_bytes += footer_buf.ISIZE;
         //Buffer until reach the decompress limit.
         bgzf_buf[buf_used] = HMR_BGZF_DECOMPRESS{ cdata, cdata_size, block_offset, footer_buf.ISIZE };
         ++buf_used;
@@ -199,23 +163,13 @@ void hmr_bgzf_parse(FILE* bgzf_file, HMR_BIN_QUEUE* queue, int threads)
         //Check whether we are reaching the decompression limitation.
         if (buf_used == buf_size)
         {
-            //Create the pool.
-            char* bgzf_raw = static_cast<char*>(malloc(block_offset));
+            //Take a slice from the queue pool.
+            HMR_BIN_SLICE bgzf_raw = hmr_bin_queue_acquire(queue, block_offset);
             //Decompress the data.
-            worker_completed = 0;
-            for (int i = 0; i < threads; ++i)
-            {
-                //Update the bgzf raw for the parameter.
-                worker_params[i].bgzf_raw = bgzf_raw;
-                worker_cv[i].notify_one();
-            }
-            //Wait for all the threads complete.
-            {
-                std::unique_lock<std::mutex> join_lock(join_mutex);
-                join_cv.wait(join_lock);
-            }
+            hmr_bgzf_inflate(inflate_group, bgzf_buf, buf_used, bgzf_raw.data);
             //Push the data to the parsing queue.
-            hmr_bin_queue_push(queue, bgzf_raw, block_offset);
+            bgzf_raw.data_size = block_offset;
+            hmr_bin_queue_push(queue, bgzf_raw);
             //Reset the buffer used.
             buf_used = 0;
             block_offset = 0;
@@ -236,38 +190,26 @@ void hmr_bgzf_parse(FILE* bgzf_file, HMR_BIN_QUEUE* queue, int threads)
     //Check whether we still have data left.
     if (buf_used > 0)
     {
-        //Create the pool.
-        char* bgzf_raw = static_cast<char*>(malloc(block_offset));
+        //Take a slice from the queue pool.
+        HMR_BIN_SLICE bgzf_raw = hmr_bin_queue_acquire(queue, block_offset);
         //Decompress the data.
-        worker_completed = 0;
-        for (int i = 0; i < threads; ++i)
-        {
-            //Update the bgzf raw for the parameter.
-            worker_params[i].max_work = buf_used;
-            worker_params[i].bgzf_raw = bgzf_raw;
-            worker_cv[i].notify_one();
-        }
-        //Wait for all the threads complete.
-        {
-            std::unique_lock<std::mutex> join_lock(join_mutex);
-            join_cv.wait(join_lock, [&] { return worker_completed == threads; });
-        }
+        hmr_bgzf_inflate(inflate_group, bgzf_buf, buf_used, bgzf_raw.data);
         //Push the data to the parsing queue.
-        hmr_bin_queue_push(queue, bgzf_raw, block_offset);
+        bgzf_raw.data_size = block_offset;
+        hmr_bin_queue_push(queue, bgzf_raw);
     }
-    //Let the workers complete their jobs.
-    for (int i = 0; i < threads; ++i)
+    free(bgzf_buf);
+    if (hmr_stats_enabled())
     {
-        worker_params[i].finished = true;
-        worker_cv[i].notify_one();
-        workers[i].join();
+        hmr_stats_count("bgzf.blocks", num_of_blocks);
+        hmr_stats_count("bgzf.compressed_bytes", compressed_bytes);
+        hmr_stats_count("bgzf.raw_bytes", raw_bytes);
     }
-    delete[] workers;
     //Mark BGZF parsing complete.
     hmr_bin_queue_finish(queue);
 }
 
-HMR_BGZF_HANDLER* hmr_bgzf_open(const char* filepath, int threads)
+HMR_BGZF_HANDLER* hmr_bgzf_open(const char* filepath, int threads, size_t queue_depth)
 {
     //Read the BGZF file.
     HMR_BGZF_HANDLER* bgzf_handler = new HMR_BGZF_HANDLER();
@@ -277,8 +219,8 @@ HMR_BGZF_HANDLER* hmr_bgzf_open(const char* filepath, int threads)
         time_error(-1, "Failed to read BGZF file %s\n", filepath);
     }
     bgzf_handler->bgzf_file = bgzf_file;
-    //Allocate the processing queue, 3 for triple buffer.
-    hmr_bin_queue_create(&(bgzf_handler->queue), 3);
+    //Allocate the processing queue.
+    hmr_bin_queue_create(&(bgzf_handler->queue), queue_depth);
     //Prepare the buffer.
     hmr_bin_buf_create(&bgzf_handler->buffer);
     //Start the BGZF parsing thread.
@@ -302,3 +244,52 @@ void hmr_bgzf_close(HMR_BGZF_HANDLER* bgzf_handler)
     //Close the file.
     fclose(bgzf_handler->bgzf_file);
 }
+
+size_t hmr_bgzf_deflate_block(const char* data, size_t data_size, char* block, int level)
+{
+    //Header with the BC sub field, the block size is filled after the compression.
+    const size_t header_size = sizeof(BGZF_HEADER) + sizeof(BGZF_SUB_HEADER) + sizeof(uint16_t);
+    BGZF_HEADER header{ 31, 139, 8, 4, 0, 0, 255, static_cast<uint16_t>(sizeof(BGZF_SUB_HEADER) + sizeof(uint16_t)) };
+    BGZF_SUB_HEADER subfield{ 66, 67, 2 };
+    memcpy(block, &header, sizeof(BGZF_HEADER));
+    memcpy(block + sizeof(BGZF_HEADER), &subfield, sizeof(BGZF_SUB_HEADER));
+    //Raw deflate the data, incompressible data is stored when it could not fit the block.
+    size_t cdata_size = 0;
+    for (int attempt_level : { level, 0 })
+    {
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+        if (deflateInit2(&stream, attempt_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            time_error(-1, "Failed to initialize the BGZF compressor.");
+        }
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream.avail_in = static_cast<uInt>(data_size);
+        stream.next_out = reinterpret_cast<Bytef*>(block + header_size);
+        stream.avail_out = static_cast<uInt>(HMR_BGZF_BLOCK_MAX - header_size - sizeof(BGZF_FOOTER));
+        int result = deflate(&stream, Z_FINISH);
+        cdata_size = stream.total_out;
+        deflateEnd(&stream);
+        if (result == Z_STREAM_END)
+        {
+            break;
+        }
+        if (attempt_level == 0)
+        {
+            time_error(-1, "Failed to compress the BGZF block.");
+        }
+    }
+    BGZF_FOOTER footer{ static_cast<uint32_t>(crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(data), static_cast<uInt>(data_size))), static_cast<uint32_t>(data_size) };
+    memcpy(block + header_size + cdata_size, &footer, sizeof(BGZF_FOOTER));
+    //The BSIZE is the total block size minus 1.
+    size_t block_size = header_size + cdata_size + sizeof(BGZF_FOOTER);
+    uint16_t bsize = static_cast<uint16_t>(block_size - 1);
+    memcpy(block + sizeof(BGZF_HEADER) + sizeof(BGZF_SUB_HEADER), &bsize, sizeof(uint16_t));
+    return block_size;
+}
+
+void hmr_bgzf_write_eof(FILE* bgzf_file)
+{
+    static const uint8_t eof_block[28] = { 31, 139, 8, 4, 0, 0, 0, 0, 0, 255, 6, 0, 66, 67, 2, 0, 27, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    fwrite(eof_block, 1, sizeof(eof_block), bgzf_file);
+}
@@ -1,11 +1,11 @@
 #ifndef HMR_BGZF_H
 #define HMR_BGZF_H
 
+#include <cstdint>
 #include <cstdio>
 #include <thread>
 
-typedef struct HMR_BIN_QUEUE HMR_BIN_QUEUE;
-typedef struct HMR_BIN_DATA_BUF HMR_BIN_DATA_BUF;
+#include "hmr_bin_queue.hpp"
 
 /* BGFZ file handler */
 typedef struct HMR_BGZF_HANDLER
@@ -17,7 +17,14 @@ typedef struct HMR_BGZF_HANDLER
 } HMR_BGZF_HANDLER;
 
 /* BGFZ file process functions */
-HMR_BGZF_HANDLER* hmr_bgzf_open(const char* filepath, int threads = 1);
+HMR_BGZF_HANDLER* hmr_bgzf_open(const char* filepath, int threads = 1, size_t queue_depth = HMR_BIN_QUEUE_DEPTH);
 void hmr_bgzf_close(HMR_BGZF_HANDLER* bgzf_handler);
 
+/* BGZF block compression, a block holds at most HMR_BGZF_BLOCK_DATA bytes of data */
+constexpr size_t HMR_BGZF_BLOCK_DATA = 0xff00;
+constexpr size_t HMR_BGZF_BLOCK_MAX = 0x10000;
+size_t hmr_bgzf_deflate_block(const char* data, size_t data_size, char* block, int level = -1);
+/* Write the empty block marks the end of the BGZF file */
+void hmr_bgzf_write_eof(FILE* bgzf_file);
+
 #endif // HMR_BGZF_H
\ No newline at end of file
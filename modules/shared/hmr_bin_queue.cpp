@@ -1,11 +1,97 @@
 #include <cassert>
 #include <cstring>
+#include <thread>
 
+#include "hmr_global.hpp"
+#include "hmr_stats.hpp"
 #include "hmr_ui.hpp"
 
 #include "hmr_bin_queue.hpp"
 
-void hmr_bin_queue_create(HMR_BIN_QUEUE **queue, size_t size)
+//Sides of the queue sleeping on the condition variables.
+constexpr int32_t BIN_QUEUE_SLEEP_POP = 1;
+constexpr int32_t BIN_QUEUE_SLEEP_PUSH = 2;
+//Times to yield before a side goes to sleep.
+constexpr int32_t BIN_QUEUE_SPIN = 64;
+
+void hmr_bin_ring_create(HMR_BIN_RING* ring, size_t capacity)
+{
+    //One slot is kept empty to tell full from empty.
+    ring->size = capacity + 1;
+    ring->slices = static_cast<HMR_BIN_SLICE*>(malloc(sizeof(HMR_BIN_SLICE) * ring->size));
+    if (!ring->slices)
+    {
+        time_error(-1, "Failed to create binary buffer queue slices, no enough memory.");
+    }
+    ring->head.store(0);
+    ring->tail.store(0);
+}
+
+inline bool hmr_bin_ring_full(HMR_BIN_RING* ring)
+{
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    return (tail + 1 == ring->size ? 0 : tail + 1) == ring->head.load(std::memory_order_acquire);
+}
+
+inline bool hmr_bin_ring_empty(HMR_BIN_RING* ring)
+{
+    return ring->head.load(std::memory_order_relaxed) == ring->tail.load(std::memory_order_acquire);
+}
+
+inline size_t hmr_bin_ring_count(HMR_BIN_RING* ring)
+{
+    size_t head = ring->head.load(std::memory_order_relaxed), tail = ring->tail.load(std::memory_order_acquire);
+    return tail >= head ? tail - head : tail + ring->size - head;
+}
+
+bool hmr_bin_ring_push(HMR_BIN_RING* ring, const HMR_BIN_SLICE& slice)
+{
+    //Only the pushing side changes the tail.
+    size_t tail = ring->tail.load(std::memory_order_relaxed), next = (tail + 1 == ring->size) ? 0 : (tail + 1);
+    if (next == ring->head.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    ring->slices[tail] = slice;
+    ring->tail.store(next, std::memory_order_release);
+    return true;
+}
+
+bool hmr_bin_ring_pop(HMR_BIN_RING* ring, HMR_BIN_SLICE& slice)
+{
+    //Only the popping side changes the head.
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    if (head == ring->tail.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    slice = ring->slices[head];
+    ring->head.store((head + 1 == ring->size) ? 0 : (head + 1), std::memory_order_release);
+    return true;
+}
+
+void hmr_bin_ring_free(HMR_BIN_RING* ring)
+{
+    HMR_BIN_SLICE slice;
+    while (hmr_bin_ring_pop(ring, slice))
+    {
+        free(slice.data);
+    }
+    free(ring->slices);
+}
+
+void hmr_bin_queue_wake(HMR_BIN_QUEUE* queue, int32_t side, std::condition_variable& cv)
+{
+    //Either the sleeping side sees the ring change, or the flag is seen here.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (queue->sleeping.load(std::memory_order_relaxed) & side)
+    {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        cv.notify_one();
+    }
+}
+
+void hmr_bin_queue_create(HMR_BIN_QUEUE **queue, size_t depth)
 {
     //Allocate the queue.
     (*queue) = new HMR_BIN_QUEUE();
@@ -13,71 +99,155 @@ void hmr_bin_queue_create(HMR_BIN_QUEUE **queue, size_t size)
     {
         time_error(-1, "Failed to create binary buffer queue, no enough memory.");
     }
-    //Create the slices buffer.
-    (*queue)->slices = static_cast<HMR_BIN_SLICE *>(malloc(sizeof(HMR_BIN_SLICE) * size));
-    if (!((*queue)->slices))
+    if (depth < 1)
     {
-        time_error(-1, "Failed to create binary buffer queue slices, no enough memory.");
+        depth = 1;
     }
-    (*queue)->size = size;
-    (*queue)->head = 0;
-    (*queue)->tail = 0;
-    (*queue)->finish = false;
+    //Create the slices buffer, the pool also holds the slices used by the producer and the consumer.
+    hmr_bin_ring_create(&((*queue)->filled), depth);
+    hmr_bin_ring_create(&((*queue)->pool), depth + 2);
+    (*queue)->sleeping.store(0);
+    (*queue)->finish.store(false);
 }
 
 void hmr_bin_queue_free(HMR_BIN_QUEUE *queue)
 {
     //Clear the queue slices.
-    free(queue->slices);
+    hmr_bin_ring_free(&(queue->filled));
+    hmr_bin_ring_free(&(queue->pool));
     //Clear the queue.
     delete queue;
 }
 
-void hmr_bin_queue_push(HMR_BIN_QUEUE *queue, char *raw_data, size_t raw_data_size)
+HMR_BIN_SLICE hmr_bin_queue_acquire(HMR_BIN_QUEUE *queue, size_t size)
+{
+    //Reuse a released slice, only allocate when the pool is empty or the slice is too small.
+    HMR_BIN_SLICE slice;
+    if (!hmr_bin_ring_pop(&(queue->pool), slice))
+    {
+        slice = HMR_BIN_SLICE{ NULL, 0, 0 };
+    }
+    if (slice.reserve < size)
+    {
+        free(slice.data);
+        slice.data = static_cast<char*>(malloc(size));
+        if (!slice.data)
+        {
+            time_error(-1, "Failed to allocate binary buffer slice, no enough memory.");
+        }
+        slice.reserve = size;
+    }
+    slice.data_size = 0;
+    return slice;
+}
+
+void hmr_bin_queue_push(HMR_BIN_QUEUE *queue, HMR_BIN_SLICE slice)
 {
-    //Check whether the queue is full.
-    std::unique_lock<std::mutex> push_lock(queue->mutex);
-    queue->push_cv.wait(push_lock, [queue]
+    int32_t spin = 0;
+    double wait_start = -1.0;
+    while (!hmr_bin_ring_push(&(queue->filled), slice))
+    {
+        //The consumer stops reading, drop the slice.
+        if (queue->finish.load())
+        {
+            free(slice.data);
+            return;
+        }
+        //The producer waits for the consumer.
+        if (wait_start < 0.0 && hmr_stats_enabled())
+        {
+            wait_start = hmr_stats_now();
+        }
+        if (++spin < BIN_QUEUE_SPIN)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        //Sleep until the consumer takes a slice.
+        std::unique_lock<std::mutex> push_lock(queue->mutex);
+        queue->sleeping.fetch_or(BIN_QUEUE_SLEEP_PUSH);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        queue->push_cv.wait(push_lock, [queue]
+        {
+            return !hmr_bin_ring_full(&(queue->filled)) || queue->finish.load();
+        });
+        queue->sleeping.fetch_and(~BIN_QUEUE_SLEEP_PUSH);
+        spin = 0;
+    }
+    if (wait_start >= 0.0)
     {
-        return !((queue->tail+1==queue->head) || (queue->head==0&&queue->tail==queue->size - 1));
-    });
-    //Push the data to the queue.
-    queue->slices[queue->tail] = HMR_BIN_SLICE {raw_data, raw_data_size};
-    queue->tail = (queue->tail+1 == queue->size) ? 0 : (queue->tail+1);
-    //Notify the conditional variable.
-    queue->pop_cv.notify_one();
+        hmr_stats_stage("bin_queue.push_wait", wait_start);
+    }
+    //Notify the consumer.
+    hmr_bin_queue_wake(queue, BIN_QUEUE_SLEEP_POP, queue->pop_cv);
 }
 
 HMR_BIN_SLICE hmr_bin_queue_pop(HMR_BIN_QUEUE *queue)
 {
-    //Wait until the queue is not empty.
-    std::unique_lock<std::mutex> pop_lock(queue->mutex);
-    queue->pop_cv.wait(pop_lock, [queue]
+    HMR_BIN_SLICE slice;
+    int32_t spin = 0;
+    double wait_start = -1.0;
+    if (hmr_stats_enabled())
     {
-        return (queue->head != queue->tail) || queue->finish;
-    });
-    //Extract the data.
-    HMR_BIN_SLICE slice = queue->slices[queue->head];
-    if(queue->finish && queue->head == queue->tail)
+        hmr_stats_sample("bin_queue.occupancy", static_cast<double>(hmr_bin_ring_count(&(queue->filled))));
+    }
+    while (!hmr_bin_ring_pop(&(queue->filled), slice))
     {
-        slice.data = NULL;
-        slice.data_size = 0;
+        if (queue->finish.load())
+        {
+            //The slices pushed before finishing are still in the ring.
+            if (hmr_bin_ring_pop(&(queue->filled), slice))
+            {
+                break;
+            }
+            return HMR_BIN_SLICE{ NULL, 0, 0 };
+        }
+        //The consumer waits for the producer.
+        if (wait_start < 0.0 && hmr_stats_enabled())
+        {
+            wait_start = hmr_stats_now();
+        }
+        if (++spin < BIN_QUEUE_SPIN)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        //Sleep until the producer pushes a slice.
+        std::unique_lock<std::mutex> pop_lock(queue->mutex);
+        queue->sleeping.fetch_or(BIN_QUEUE_SLEEP_POP);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        queue->pop_cv.wait(pop_lock, [queue]
+        {
+            return !hmr_bin_ring_empty(&(queue->filled)) || queue->finish.load();
+        });
+        queue->sleeping.fetch_and(~BIN_QUEUE_SLEEP_POP);
+        spin = 0;
     }
-    else
+    if (wait_start >= 0.0)
     {
-        queue->head = (queue->head+1 == queue->size) ? 0 : (queue->head+1);
+        hmr_stats_stage("bin_queue.pop_wait", wait_start);
     }
-    //Notify the push variable.
-    queue->push_cv.notify_one();
+    //Notify the producer.
+    hmr_bin_queue_wake(queue, BIN_QUEUE_SLEEP_PUSH, queue->push_cv);
     return slice;
 }
 
+void hmr_bin_queue_release(HMR_BIN_QUEUE *queue, HMR_BIN_SLICE slice)
+{
+    //Return the slice to the producer, the pool is large enough to hold all the slices.
+    if (!hmr_bin_ring_push(&(queue->pool), slice))
+    {
+        free(slice.data);
+    }
+}
+
 void hmr_bin_queue_finish(HMR_BIN_QUEUE* queue)
 {
+    //Mark queue is finished using, wake up both sides.
+    queue->finish.store(true);
     std::unique_lock<std::mutex> finish_lock(queue->mutex);
-    //Mark queue is finished using.
-    queue->finish = true;
-    queue->pop_cv.notify_one();
+    queue->pop_cv.notify_all();
+    queue->push_cv.notify_all();
 }
 
 void hmr_bin_buf_create(HMR_BIN_DATA_BUF** buf)
@@ -89,81 +259,75 @@ void hmr_bin_buf_create(HMR_BIN_DATA_BUF** buf)
         time_error(-1, "Failed to create binary buffer structure, no enough memory.");
     }
     //Initial the structure.
-    buffer->data = NULL;
+    buffer->slice = HMR_BIN_SLICE{ NULL, 0, 0 };
     buffer->offset = 0;
-    buffer->reserve = 0;
-    buffer->size = 0;
+    buffer->spill = NULL;
+    buffer->spill_size = 0;
+    buffer->spill_reserve = 0;
     *buf = buffer;
 }
 
-char *hmr_bin_buf_fetch(HMR_BIN_DATA_BUF *buf, HMR_BIN_QUEUE *queue, size_t size)
+void hmr_bin_buf_spill(HMR_BIN_DATA_BUF* buf, const char* data, size_t size)
 {
-    //Check the left data is enough.
-    size_t residual = buf->size - buf->offset;
-    if(residual >= size)
+    //Increase the spill buffer size when necessary.
+    size_t spill_size = buf->spill_size + size;
+    if (spill_size > buf->spill_reserve)
     {
-        //Enough to hold the data.
-        char *data = buf->data + buf->offset;
-        buf->offset += size;
-        return data;
+        size_t reserve = hMax(spill_size, buf->spill_reserve << 1);
+        char* expected = static_cast<char*>(realloc(buf->spill, reserve));
+        if (!expected)
+        {
+            time_error(-1, "Failed to expand the binary spill buffer, no enough memory.");
+        }
+        buf->spill = expected;
+        buf->spill_reserve = reserve;
     }
-    //Well, we have to fill the buffer with the queue data size.
-    while(residual < size)
+    memcpy(buf->spill + buf->spill_size, data, size);
+    buf->spill_size = spill_size;
+}
+
+bool hmr_bin_buf_next(HMR_BIN_DATA_BUF* buf, HMR_BIN_QUEUE* queue)
+{
+    //The slice is used up, return it to the pool.
+    if (buf->slice.data)
     {
-        //Fetch the data from the queue.
-        HMR_BIN_SLICE bin_slice = hmr_bin_queue_pop(queue);
-        if(bin_slice.data == NULL)
+        hmr_bin_queue_release(queue, buf->slice);
+    }
+    buf->slice = hmr_bin_queue_pop(queue);
+    buf->offset = 0;
+    return buf->slice.data != NULL;
+}
+
+char *hmr_bin_buf_fetch(HMR_BIN_DATA_BUF *buf, HMR_BIN_QUEUE *queue, size_t size)
+{
+    buf->spill_size = 0;
+    for (;;)
+    {
+        size_t residual = buf->slice.data_size - buf->offset;
+        if (buf->spill_size == 0 && residual >= size)
         {
-            //Reach the end of the data, still cannot fulfill, failed to fetch.
-            return NULL;
+            //Enough to hold the data.
+            char *data = buf->slice.data + buf->offset;
+            buf->offset += size;
+            return data;
         }
-        //Check whether we can fast swap to the slice memory.
-        if(residual == 0)
+        if (residual > 0)
         {
-            //Directly use the slice memory.
-            if(buf->data)
+            //The data is across the slices, only copy it to the spill buffer.
+            size_t copy_size = hMin(residual, size - buf->spill_size);
+            hmr_bin_buf_spill(buf, buf->slice.data + buf->offset, copy_size);
+            buf->offset += copy_size;
+            if (buf->spill_size == size)
             {
-                free(buf->data);
+                return buf->spill;
             }
-            //Update the buffer.
-            buf->data = bin_slice.data;
-            buf->size = bin_slice.data_size;
-            buf->reserve = bin_slice.data_size;
         }
-        else
+        if (!hmr_bin_buf_next(buf, queue))
         {
-            //Copy the residual data.
-            assert(buf->data + buf->offset);
-            memcpy(buf->data, buf->data + buf->offset, residual);
-            //Calculate the new buffer size.
-            size_t data_size = residual + bin_slice.data_size;
-            //Increase the buffer size when necessary.
-            if(data_size > buf->reserve)
-            {
-                char *expected = static_cast<char *>(realloc(buf->data, data_size));
-                if (!expected)
-                {
-                    time_error(-1, "Failed to expand the binary buffer, no enough memory.");
-                }
-                assert(expected);
-                buf->data = expected;
-                buf->reserve = data_size;
-            }
-            //Copy the slice data to buffer.
-            memcpy(buf->data + residual, bin_slice.data, bin_slice.data_size);
-            //Update the data size.
-            buf->size = data_size;
-            //Release the slice data.
-            free(bin_slice.data);
+            //Reach the end of the data, still cannot fulfill, failed to fetch.
+            return NULL;
         }
-        //Update the residual data.
-        buf->offset = 0;
-        residual = buf->size;
     }
-    //Now the data should be enough.
-    char *data = buf->data;
-    buf->offset = size;
-    return data;
 }
 
 char hmr_bin_buf_getc(HMR_BIN_DATA_BUF* buf, HMR_BIN_QUEUE* queue)
@@ -178,11 +342,48 @@ char hmr_bin_buf_getc(HMR_BIN_DATA_BUF* buf, HMR_BIN_QUEUE* queue)
     return result[0];
 }
 
-void hmr_bin_buf_free(HMR_BIN_DATA_BUF* buf)
+char *hmr_bin_buf_fetch_line(HMR_BIN_DATA_BUF* buf, HMR_BIN_QUEUE* queue, size_t* line_size)
 {
-    if (buf->data)
+    buf->spill_size = 0;
+    for (;;)
     {
-        free(buf->data);
+        size_t residual = buf->slice.data_size - buf->offset;
+        if (residual > 0)
+        {
+            //Try to find '\n' inside the slice.
+            char* data = buf->slice.data + buf->offset,
+                * pos = static_cast<char*>(memchr(data, '\n', residual));
+            size_t data_size = pos ? static_cast<size_t>(pos - data + 1) : residual;
+            buf->offset += data_size;
+            if (pos && buf->spill_size == 0)
+            {
+                //The line is inside the slice.
+                *line_size = data_size;
+                return data;
+            }
+            hmr_bin_buf_spill(buf, data, data_size);
+            if (pos)
+            {
+                *line_size = buf->spill_size;
+                return buf->spill;
+            }
+        }
+        if (!hmr_bin_buf_next(buf, queue))
+        {
+            //Pass the rest of the data.
+            if (buf->spill_size > 0)
+            {
+                *line_size = buf->spill_size;
+                return buf->spill;
+            }
+            return NULL;
+        }
     }
+}
+
+void hmr_bin_buf_free(HMR_BIN_DATA_BUF* buf)
+{
+    free(buf->slice.data);
+    free(buf->spill);
     free(buf);
 }
@@ -1,43 +1,71 @@
 #ifndef HMR_BIN_QUEUE_H
 #define HMR_BIN_QUEUE_H
 
+#include <cstdint>
+#include <cstdlib>
+
+#include <atomic>
 #include <condition_variable>
+#include <mutex>
+
+//Number of slices decoded ahead of the consumer.
+constexpr size_t HMR_BIN_QUEUE_DEPTH = 2;
 
 typedef struct HMR_BIN_SLICE
 {
     char *data;
-    size_t data_size;
+    size_t data_size, reserve;
 } HMR_BIN_SLICE;
 
-typedef struct HMR_BIN_QUEUE
+/* Bounded ring of slices, lock-free for one producer and one consumer */
+typedef struct HMR_BIN_RING
 {
-    bool finish, force_end;
     HMR_BIN_SLICE *slices;
-    size_t head, tail, size;
+    size_t size;
+    std::atomic<size_t> head, tail;
+} HMR_BIN_RING;
+
+typedef struct HMR_BIN_QUEUE
+{
+    std::atomic<bool> finish;
+    //Decoded slices to the consumer, and the used slices back to the producer.
+    HMR_BIN_RING filled, pool;
+    //The mutex is only used when a side has to sleep.
+    std::atomic<int32_t> sleeping;
     std::mutex mutex;
     std::condition_variable pop_cv, push_cv;
 } HMR_BIN_QUEUE;
 
 typedef struct HMR_BIN_DATA_BUF
 {
-    char *data;
-    size_t size, reserve, offset;
+    HMR_BIN_SLICE slice;
+    size_t offset;
+    //The records across the slices are collected here.
+    char *spill;
+    size_t spill_size, spill_reserve;
 } HMR_BIN_DATA_BUF;
 
-void hmr_bin_queue_create(HMR_BIN_QUEUE **queue, size_t size);
+void hmr_bin_queue_create(HMR_BIN_QUEUE **queue, size_t depth);
 void hmr_bin_queue_free(HMR_BIN_QUEUE *queue);
 
-void hmr_bin_queue_push(HMR_BIN_QUEUE *queue, char *raw_data, size_t raw_data_size);
-HMR_BIN_SLICE hmr_bin_queue_pop(HMR_BIN_QUEUE *queue);
+/* Producer side, the slice is taken from the pool and has at least the given reserve */
+HMR_BIN_SLICE hmr_bin_queue_acquire(HMR_BIN_QUEUE *queue, size_t size);
+void hmr_bin_queue_push(HMR_BIN_QUEUE *queue, HMR_BIN_SLICE slice);
 void hmr_bin_queue_finish(HMR_BIN_QUEUE* queue);
+/* Consumer side, a popped slice should be released back to the pool */
+HMR_BIN_SLICE hmr_bin_queue_pop(HMR_BIN_QUEUE *queue);
+void hmr_bin_queue_release(HMR_BIN_QUEUE *queue, HMR_BIN_SLICE slice);
 
 void hmr_bin_buf_create(HMR_BIN_DATA_BUF **buf);
+/* The fetched data is only valid until the next fetch, which may release its slice to the producer or reuse the spill buffer */
 char *hmr_bin_buf_fetch(HMR_BIN_DATA_BUF *buf, HMR_BIN_QUEUE *queue, size_t size);
 inline uint32_t hmr_bin_buf_fetch_uint32(HMR_BIN_DATA_BUF* buf, HMR_BIN_QUEUE* queue)
 {
     return *(reinterpret_cast<uint32_t*>(hmr_bin_buf_fetch(buf, queue, 4)));
 }
 char hmr_bin_buf_getc(HMR_BIN_DATA_BUF* buf, HMR_BIN_QUEUE* queue);
+/* Fetch the data until '\n', the last line may not have '\n', NULL when reaching the end */
+char *hmr_bin_buf_fetch_line(HMR_BIN_DATA_BUF* buf, HMR_BIN_QUEUE* queue, size_t* line_size);
 void hmr_bin_buf_free(HMR_BIN_DATA_BUF* buf);
 
 #endif // HMR_BIN_QUEUE_H
@@ -12,6 +12,9 @@
 
 #include "hmr_contig_graph.hpp"
 
+//The highest bit of the edge file size header marks the undirected edge file.
+constexpr uint64_t HMR_EDGE_UNDIRECTED_FLAG = 0x8000000000000000ULL;
+
 template<typename T>
 struct GRAPH_LOAD_BUFFER
 {
@@ -71,7 +74,7 @@ void hmr_graph_buffer_loader(const char* filepath, GRAPH_BUF_LOADER<T>& loader,
         //Read the size from the file.
         uint64_t item_size;
         fread(&item_size, sizeof(uint64_t), 1, data_file);
-        size_proc(item_size, user);
+        size_proc(item_size & (~HMR_EDGE_UNDIRECTED_FLAG), user);
     }
     //Loop until all the data is loaded.
     while (!loader.finished)
@@ -166,6 +169,11 @@ std::string hmr_graph_path_reads(const char* prefix)
     return std::string(prefix) + ".hmr_reads";
 }
 
+std::string hmr_graph_path_reads_summary(const char* prefix)
+{
+    return std::string(prefix) + ".hmr_summary";
+}
+
 std::string hmr_graph_path_nodes_invalid(const char* contig_path)
 {
     return std::string(contig_path) + "_invalid";
@@ -191,6 +199,11 @@ std::string hmr_graph_path_cluster_name(const char* prefix, const int32_t index,
     return std::string(prefix) + "_" + std::to_string(index) + "g" + std::to_string(total) + ".hmr_group";
 }
 
+std::string hmr_graph_path_seq_name(const char* group_path)
+{
+    return std::string(path_basename(group_path) + ".hmr_seq");
+}
+
 std::string hmr_graph_path_chromo_name(const char* seq_path)
 {
     return std::string(path_basename(seq_path) + ".hmr_chromo");
@@ -394,11 +407,127 @@ bool hmr_graph_save_edges(const char* filepath, const HMR_EDGE_COUNTERS& edges)
     return false;
 }
 
+bool hmr_graph_edges_is_undirected(const char* filepath)
+{
+    FILE* edge_file;
+    if (!bin_open(filepath, &edge_file, "rb"))
+    {
+        time_error(-1, "Failed to open edge file %s", filepath);
+    }
+    //Read the size header of the edge file.
+    uint64_t edge_sizes = 0;
+    fread(&edge_sizes, sizeof(uint64_t), 1, edge_file);
+    fclose(edge_file);
+    return (edge_sizes & HMR_EDGE_UNDIRECTED_FLAG) != 0;
+}
+
+void hmr_graph_load_undirected_edges(const char* filepath, int32_t buf_size, GRAPH_EDGE_SIZE_PROC size_proc, GRAPH_UNDIRECTED_EDGE_PROC proc, void* user)
+{
+    hmr_graph_load_with_buffer(filepath, buf_size, size_proc, proc, user);
+}
+
+bool hmr_graph_save_undirected_edges(const char* filepath, const HMR_UNDIRECTED_EDGE_COUNTERS& edges)
+{
+    FILE* edge_file;
+    if (!bin_open(filepath, &edge_file, "wb"))
+    {
+        time_error(-1, "Failed to save edges to file %s", filepath);
+    }
+    //Write the number of edges with the undirected flag.
+    uint64_t edge_sizes = static_cast<uint64_t>(edges.size());
+    uint64_t edge_header = edge_sizes | HMR_EDGE_UNDIRECTED_FLAG;
+    fwrite(&edge_header, sizeof(uint64_t), 1, edge_file);
+    //Write the edge data.
+    fwrite(edges.data(), sizeof(HMR_UNDIRECTED_EDGE_INFO), edge_sizes, edge_file);
+    fclose(edge_file);
+    return true;
+}
+
+bool hmr_graph_undirected_edges_open(const char* filepath, FILE** edge_file)
+{
+    if (!bin_open(filepath, edge_file, "wb"))
+    {
+        time_error(-1, "Failed to save edges to file %s", filepath);
+    }
+    //Reserve the size header, it is updated when closing.
+    uint64_t edge_header = HMR_EDGE_UNDIRECTED_FLAG;
+    fwrite(&edge_header, sizeof(uint64_t), 1, *edge_file);
+    return true;
+}
+
+void hmr_graph_undirected_edges_write(FILE* edge_file, const HMR_UNDIRECTED_EDGE_INFO* edges, size_t edge_size)
+{
+    fwrite(edges, sizeof(HMR_UNDIRECTED_EDGE_INFO), edge_size, edge_file);
+}
+
+void hmr_graph_undirected_edges_close(FILE* edge_file, uint64_t edge_size)
+{
+    //Write the number of edges with the undirected flag.
+    uint64_t edge_header = edge_size | HMR_EDGE_UNDIRECTED_FLAG;
+    fseek(edge_file, 0, SEEK_SET);
+    fwrite(&edge_header, sizeof(uint64_t), 1, edge_file);
+    fclose(edge_file);
+}
+
 void hmr_graph_load_reads(const char* filepath, int32_t buf_size, HMR_READS_PROC proc, void* user)
 {
     hmr_graph_load_with_buffer(filepath, buf_size, NULL, proc, user);
 }
 
+void hmr_graph_reads_multi_proc(HMR_MAPPING* mapping, int32_t buf_size, void* user)
+{
+    const std::vector<HMR_READS_CONSUMER>* consumers = static_cast<const std::vector<HMR_READS_CONSUMER>*>(user);
+    for (const HMR_READS_CONSUMER& consumer : *consumers)
+    {
+        consumer.proc(mapping, buf_size, consumer.user);
+    }
+}
+
+void hmr_graph_load_reads_multi(const char* filepath, int32_t buf_size, const std::vector<HMR_READS_CONSUMER>& consumers)
+{
+    hmr_graph_load_with_buffer(filepath, buf_size, NULL, hmr_graph_reads_multi_proc, const_cast<std::vector<HMR_READS_CONSUMER>*>(&consumers));
+}
+
+void hmr_graph_load_reads_summary(const char* filepath, HMR_READS_SUMMARY& summary)
+{
+    FILE* summary_file;
+    if (!bin_open(filepath, &summary_file, "rb"))
+    {
+        time_error(-1, "Failed to load paired-reads summary from %s", filepath);
+    }
+    //Read the contig summaries.
+    int32_t contig_sizes = 0;
+    fread(&contig_sizes, sizeof(int32_t), 1, summary_file);
+    summary.contigs.resize(contig_sizes);
+    fread(summary.contigs.data(), sizeof(HMR_CONTIG_SUMMARY), contig_sizes, summary_file);
+    //Read the contig pair summaries.
+    uint64_t pair_sizes = 0;
+    fread(&pair_sizes, sizeof(uint64_t), 1, summary_file);
+    summary.pairs.resize(pair_sizes);
+    fread(summary.pairs.data(), sizeof(HMR_PAIR_SUMMARY), pair_sizes, summary_file);
+    fclose(summary_file);
+}
+
+bool hmr_graph_save_reads_summary(const char* filepath, const HMR_READS_SUMMARY& summary)
+{
+    FILE* summary_file;
+    if (!bin_open(filepath, &summary_file, "wb"))
+    {
+        time_error(-1, "Failed to save paired-reads summary to file %s", filepath);
+        return false;
+    }
+    //Write the contig summaries.
+    int32_t contig_sizes = static_cast<int32_t>(summary.contigs.size());
+    fwrite(&contig_sizes, sizeof(int32_t), 1, summary_file);
+    fwrite(summary.contigs.data(), sizeof(HMR_CONTIG_SUMMARY), contig_sizes, summary_file);
+    //Write the contig pair summaries.
+    uint64_t pair_sizes = static_cast<uint64_t>(summary.pairs.size());
+    fwrite(&pair_sizes, sizeof(uint64_t), 1, summary_file);
+    fwrite(summary.pairs.data(), sizeof(HMR_PAIR_SUMMARY), pair_sizes, summary_file);
+    fclose(summary_file);
+    return true;
+}
+
 void hmr_graph_load_chromosome(const char* filepath, CHROMOSOME_CONTIGS& seq)
 {
     FILE* chromosome_file;
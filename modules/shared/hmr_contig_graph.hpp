@@ -1,6 +1,7 @@
 #ifndef HMR_CONTIG_GRAPH_H
 #define HMR_CONTIG_GRAPH_H
 
+#include <cstdio>
 #include <string>
 
 #include "hmr_contig_graph_type.hpp"
@@ -36,17 +37,19 @@ inline uint64_t hmr_graph_edge_data(int32_t edge_node_a, int32_t edge_node_b)
 inline void hmr_graph_edge_pos(uint64_t data, int32_t& start, int32_t& end)
 {
     start = static_cast<int32_t>(data >> 32);
-    end = static_cast<int32_t>(data & 0xFFFF);
+    end = static_cast<int32_t>(data & 0xFFFFFFFF);
 }
 
 /* Graph path generated functions */
 std::string hmr_graph_path_contigs(const char* prefix);
 std::string hmr_graph_path_edge(const char* prefix);
 std::string hmr_graph_path_reads(const char* prefix);
+std::string hmr_graph_path_reads_summary(const char* prefix);
 std::string hmr_graph_path_nodes_invalid(const char* contig_path);
 std::string hmr_graph_path_contigs_invalid(const char* prefix);
 std::string hmr_graph_path_allele_table(const char* prefix);
 std::string hmr_graph_path_cluster_name(const char* prefix, const int32_t index, const int32_t total);
+std::string hmr_graph_path_seq_name(const char* group_path);
 std::string hmr_graph_path_chromo_name(const char* seq_path);
 
 /* Node operations */
@@ -70,9 +73,30 @@ typedef void (*GRAPH_EDGE_PROC)(HMR_EDGE_INFO* edges, int32_t edge_size, void* u
 void hmr_graph_load_edges(const char* filepath, int32_t buf_size, GRAPH_EDGE_SIZE_PROC size_proc, GRAPH_EDGE_PROC proc, void *user);
 bool hmr_graph_save_edges(const char* filepath, const HMR_EDGE_COUNTERS& edges);
 
+/* Undirected edge vector operations, the edge file header is flagged */
+typedef void (*GRAPH_UNDIRECTED_EDGE_PROC)(HMR_UNDIRECTED_EDGE_INFO* edges, int32_t edge_size, void* user);
+bool hmr_graph_edges_is_undirected(const char* filepath);
+void hmr_graph_load_undirected_edges(const char* filepath, int32_t buf_size, GRAPH_EDGE_SIZE_PROC size_proc, GRAPH_UNDIRECTED_EDGE_PROC proc, void* user);
+bool hmr_graph_save_undirected_edges(const char* filepath, const HMR_UNDIRECTED_EDGE_COUNTERS& edges);
+/* Streaming undirected edge writer, the edge size header is written when closing */
+bool hmr_graph_undirected_edges_open(const char* filepath, FILE** edge_file);
+void hmr_graph_undirected_edges_write(FILE* edge_file, const HMR_UNDIRECTED_EDGE_INFO* edges, size_t edge_size);
+void hmr_graph_undirected_edges_close(FILE* edge_file, uint64_t edge_size);
+
 /* Paired-reads operations */
 typedef void (*HMR_READS_PROC)(HMR_MAPPING* mapping, int32_t buf_size, void *user);
 void hmr_graph_load_reads(const char* filepath, int32_t buf_size, HMR_READS_PROC proc, void *user);
+/* Feed every buffer of a single reads pass to several consumers in turn */
+typedef struct HMR_READS_CONSUMER
+{
+    HMR_READS_PROC proc;
+    void* user;
+} HMR_READS_CONSUMER;
+void hmr_graph_load_reads_multi(const char* filepath, int32_t buf_size, const std::vector<HMR_READS_CONSUMER>& consumers);
+
+/* Paired-reads summary operations */
+void hmr_graph_load_reads_summary(const char* filepath, HMR_READS_SUMMARY& summary);
+bool hmr_graph_save_reads_summary(const char* filepath, const HMR_READS_SUMMARY& summary);
 
 /* Chromosome sequence operations */
 void hmr_graph_load_chromosome(const char* filepath, CHROMOSOME_CONTIGS& seq);
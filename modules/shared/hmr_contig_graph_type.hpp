@@ -48,6 +48,17 @@ typedef struct HMR_EDGE_INFO
 
 typedef std::vector<HMR_EDGE_INFO> HMR_EDGE_COUNTERS;
 
+/* Undirected edge, start < end, weights[0] is start->end, weights[1] is end->start */
+typedef struct HMR_UNDIRECTED_EDGE_INFO
+{
+    int32_t start;
+    int32_t end;
+    uint64_t pairs;
+    double weights[2];
+} HMR_UNDIRECTED_EDGE_INFO;
+
+typedef std::vector<HMR_UNDIRECTED_EDGE_INFO> HMR_UNDIRECTED_EDGE_COUNTERS;
+
 typedef struct HMR_MAPPING
 {
     int32_t refID;
@@ -56,6 +67,33 @@ typedef struct HMR_MAPPING
     int32_t next_pos;
 } HMR_MAPPING;
 
+//Number of log2 bins of the mate distance histogram.
+constexpr int32_t HMR_DISTANCE_BINS = 32;
+
+/* Paired-reads between two contigs, first < second */
+typedef struct HMR_PAIR_SUMMARY
+{
+    int32_t first;
+    int32_t second;
+    uint64_t count;
+    uint64_t pos_sum[2]; // Sum of the read positions on the first and the second contig.
+    uint64_t ends[4]; // Reads between [end of the first][end of the second], 0 is the head half, 1 is the tail half.
+} HMR_PAIR_SUMMARY;
+
+/* Paired-reads inside a contig */
+typedef struct HMR_CONTIG_SUMMARY
+{
+    uint64_t count;
+    uint64_t pos_sum[2]; // Sum of the read and the mate positions.
+    uint64_t distances[HMR_DISTANCE_BINS]; // Histogram of log2(mate distance + 1).
+} HMR_CONTIG_SUMMARY;
+
+typedef struct HMR_READS_SUMMARY
+{
+    std::vector<HMR_CONTIG_SUMMARY> contigs;
+    std::vector<HMR_PAIR_SUMMARY> pairs; // Sorted by the first and the second contig.
+} HMR_READS_SUMMARY;
+
 typedef std::vector<int32_t> HMR_CONTIG_ID_VEC;
 typedef std::unordered_set<int32_t> HMR_CONTIG_ID_SET;
 typedef std::list<int32_t> HMR_CONTIG_ID_CHAIN;
@@ -3,6 +3,7 @@
 #include <cstdio>
 #include <cstdint>
 #include <cstring>
+#include <vector>
 
 #include "hmr_text_file.hpp"
 #include "hmr_bin_file.hpp"
@@ -115,3 +116,177 @@ void hmr_fasta_read(const char *filepath, FASTA_PROC parser, void *user)
     //Close the file.
     text_close_read_line(&line_handle);
 }
+
+std::string hmr_fasta_index_path(const char* filepath)
+{
+    return std::string(filepath) + ".fai";
+}
+
+bool hmr_fasta_index_load(const char* filepath, HMR_FASTA_INDEX& index)
+{
+    TEXT_LINE_HANDLE line_handle;
+    if (!text_open_read_line(filepath, &line_handle))
+    {
+        return false;
+    }
+    char* line = NULL;
+    size_t len = 0, line_length = 0;
+    ssize_t line_size = 0;
+    index.clear();
+    while ((line_size = (line_handle.parser(&line, &len, &line_handle.buf, line_handle.file_handle))) != -1)
+    {
+        line_length = static_cast<size_t>(line_size);
+        trimmed_right(line, line_length);
+        //Split the 5 columns: name, length, offset, line bases and line width.
+        size_t tab_stops[4];
+        int32_t tab_stop_count = 0;
+        for (size_t i = 0; i < line_length && tab_stop_count < 4; ++i)
+        {
+            if (line[i] == '\t')
+            {
+                tab_stops[tab_stop_count++] = i;
+                line[i] = '\0';
+            }
+        }
+        if (tab_stop_count < 4)
+        {
+            continue;
+        }
+        HMR_FASTA_INDEX_ITEM item;
+        item.name = std::string(line, tab_stops[0]);
+        item.length = strtoull(line + tab_stops[0] + 1, NULL, 10);
+        item.offset = strtoull(line + tab_stops[1] + 1, NULL, 10);
+        item.line_bases = strtoull(line + tab_stops[2] + 1, NULL, 10);
+        item.line_width = strtoull(line + tab_stops[3] + 1, NULL, 10);
+        index.push_back(item);
+    }
+    text_close_read_line(&line_handle);
+    return true;
+}
+
+inline void fasta_index_line_end(HMR_FASTA_INDEX& index, uint64_t line_bases, uint64_t line_bytes, bool& short_line)
+{
+    if (index.empty() || line_bytes == 0)
+    {
+        return;
+    }
+    HMR_FASTA_INDEX_ITEM& item = index.back();
+    if (line_bases == 0)
+    {
+        //Empty lines are only allowed at the end of the sequence.
+        short_line = true;
+        return;
+    }
+    if (item.line_bases == 0)
+    {
+        item.line_bases = line_bases;
+        item.line_width = line_bytes;
+    }
+    else if (short_line || line_bases > item.line_bases || (line_bases == item.line_bases && line_bytes != item.line_width))
+    {
+        time_error(-1, "Different line length in sequence %s, please reformat the FASTA file.", item.name.c_str());
+    }
+    short_line = line_bases < item.line_bases;
+    item.length += line_bases;
+}
+
+void hmr_fasta_index_build(const char* filepath, HMR_FASTA_INDEX& index)
+{
+    FILE* fasta_file;
+    if (!bin_open(filepath, &fasta_file, "rb"))
+    {
+        time_error(-1, "Failed to read FASTA file %s", filepath);
+    }
+    const size_t chunk_size = 4 << 20;
+    std::vector<char> chunk(chunk_size);
+    index.clear();
+    uint64_t file_pos = 0, line_bases = 0, line_bytes = 0;
+    bool line_start = true, in_name = false, name_end = false, short_line = false;
+    std::string name;
+    size_t read_size;
+    while ((read_size = fread(chunk.data(), 1, chunk_size, fasta_file)) > 0)
+    {
+        for (size_t i = 0; i < read_size; ++i, ++file_pos)
+        {
+            char c = chunk[i];
+            if (line_start && c == '>')
+            {
+                //Start a new sequence record.
+                in_name = true;
+                name_end = false;
+                name.clear();
+                line_start = false;
+                continue;
+            }
+            line_start = (c == '\n');
+            if (in_name)
+            {
+                if (c == '\n')
+                {
+                    //The first base is at the next line.
+                    index.push_back(HMR_FASTA_INDEX_ITEM{ name, 0, file_pos + 1, 0, 0 });
+                    in_name = false;
+                    short_line = false;
+                }
+                else if (!name_end)
+                {
+                    //Only keep the name before the first spacing.
+                    name_end = is_space(c);
+                    if (!name_end)
+                    {
+                        name.push_back(c);
+                    }
+                }
+                continue;
+            }
+            ++line_bytes;
+            if (c == '\n')
+            {
+                fasta_index_line_end(index, line_bases, line_bytes, short_line);
+                line_bases = 0;
+                line_bytes = 0;
+            }
+            else if (c != '\r')
+            {
+                ++line_bases;
+            }
+        }
+    }
+    //The last line may not have the line break.
+    if (in_name)
+    {
+        index.push_back(HMR_FASTA_INDEX_ITEM{ name, 0, file_pos, 0, 0 });
+    }
+    else if (line_bases > 0 && !index.empty())
+    {
+        HMR_FASTA_INDEX_ITEM& item = index.back();
+        if (short_line || (line_bases > item.line_bases && item.line_bases > 0))
+        {
+            time_error(-1, "Different line length in sequence %s, please reformat the FASTA file.", item.name.c_str());
+        }
+        if (item.line_bases == 0)
+        {
+            item.line_bases = line_bases;
+            item.line_width = line_bytes + 1;
+        }
+        item.length += line_bases;
+    }
+    fclose(fasta_file);
+}
+
+bool hmr_fasta_index_save(const char* filepath, const HMR_FASTA_INDEX& index)
+{
+    FILE* index_file;
+    if (!text_open_write(filepath, &index_file))
+    {
+        return false;
+    }
+    for (const HMR_FASTA_INDEX_ITEM& item : index)
+    {
+        fprintf(index_file, "%s\t%llu\t%llu\t%llu\t%llu\n", item.name.c_str(),
+                static_cast<unsigned long long>(item.length), static_cast<unsigned long long>(item.offset),
+                static_cast<unsigned long long>(item.line_bases), static_cast<unsigned long long>(item.line_width));
+    }
+    fclose(index_file);
+    return true;
+}
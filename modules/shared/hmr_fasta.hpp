@@ -2,6 +2,8 @@
 #define HMR_FASTA_H
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 /* FASTA file processing function type */
 /* Please notice, `name` and `seq` needs to be free by the PROC function */
@@ -10,4 +12,27 @@ typedef void (*FASTA_PROC)(int32_t index, char *name, size_t name_size, char *se
 /* FASTA file parser */
 void hmr_fasta_read(const char *filepath, FASTA_PROC parser, void *user);
 
+/* FASTA index record, the same columns as the samtools .fai file */
+typedef struct HMR_FASTA_INDEX_ITEM
+{
+    std::string name;
+    uint64_t length;
+    uint64_t offset; // File offset of the first base.
+    uint64_t line_bases;
+    uint64_t line_width; // Bytes of a line, including the line break.
+} HMR_FASTA_INDEX_ITEM;
+
+typedef std::vector<HMR_FASTA_INDEX_ITEM> HMR_FASTA_INDEX;
+
+/* FASTA index operations, the index could only be built for the uncompressed FASTA */
+std::string hmr_fasta_index_path(const char* filepath);
+bool hmr_fasta_index_load(const char* filepath, HMR_FASTA_INDEX& index);
+void hmr_fasta_index_build(const char* filepath, HMR_FASTA_INDEX& index);
+bool hmr_fasta_index_save(const char* filepath, const HMR_FASTA_INDEX& index);
+/* File offset of the base at the position of the record */
+inline uint64_t hmr_fasta_index_offset(const HMR_FASTA_INDEX_ITEM& item, uint64_t pos)
+{
+    return item.offset + pos / item.line_bases * item.line_width + pos % item.line_bases;
+}
+
 #endif // HMR_FASTA_H
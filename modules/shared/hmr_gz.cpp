@@ -6,6 +6,7 @@
 #include "hmr_ui.hpp"
 #include "hmr_global.hpp"
 #include "hmr_bin_queue.hpp"
+#include "hmr_stats.hpp"
 
 #include "hmr_gz.hpp"
 
@@ -59,20 +60,29 @@ void hmr_gzip_parse(FILE *gz_file, HMR_BIN_QUEUE *queue)
     strm.next_in = reinterpret_cast<Bytef *>(gz_buffer);
     strm.avail_in = static_cast<uInt>(gz_buffer_size);
     int error = Z_OK;
+    uint64_t raw_bytes = 0;
+    double inflate_seconds = 0.0, read_seconds = 0.0;
     while (Z_STREAM_END != error && !queue->finish)
     {
         //Assume all the compression ratio to be 2x.
         size_t slice_reserved = DATA_CHUNK << 2;
-        char* slice_data = static_cast<char*>(malloc(slice_reserved));
-        strm.next_out = reinterpret_cast<Bytef*>(slice_data);
+        HMR_BIN_SLICE slice = hmr_bin_queue_acquire(queue, slice_reserved);
+        strm.next_out = reinterpret_cast<Bytef*>(slice.data);
         strm.avail_out = static_cast<uInt>(slice_reserved);
         //Decompress the stream.
+        double inflate_start = hmr_stats_enabled() ? hmr_stats_now() : 0.0;
         error = inflate(&strm, Z_NO_FLUSH);
+        if (hmr_stats_enabled())
+        {
+            inflate_seconds += hmr_stats_now() - inflate_start;
+        }
         //While the data is valid, push the output data to data slice.
         if (Z_OK == error || Z_STREAM_END == error)
         {
             //Send the data.
-            hmr_bin_queue_push(queue, slice_data, slice_reserved - strm.avail_out);
+            slice.data_size = slice_reserved - strm.avail_out;
+            raw_bytes += slice.data_size;
+            hmr_bin_queue_push(queue, slice);
         }
         else
         {
@@ -82,8 +92,8 @@ void hmr_gzip_parse(FILE *gz_file, HMR_BIN_QUEUE *queue)
         if (strm.avail_in > 0)
         {
             //Move the data to the beginning of the header.
-            size_t gz_buffer_used = DATA_CHUNK - strm.avail_in;
-            memcpy(gz_buffer, gz_buffer + gz_buffer_used, strm.avail_in);
+            size_t gz_buffer_used = reinterpret_cast<char*>(strm.next_in) - gz_buffer;
+            memmove(gz_buffer, gz_buffer + gz_buffer_used, strm.avail_in);
         }
         //Reset the next input at the start of the buffer.
         strm.next_in = reinterpret_cast<Bytef*>(gz_buffer);
@@ -92,10 +102,23 @@ void hmr_gzip_parse(FILE *gz_file, HMR_BIN_QUEUE *queue)
         {
             size_t bytes_expected = hMin(total_size - gz_file_offset, static_cast<size_t>(DATA_CHUNK - strm.avail_in));
             //Fill the buffer.
-            fread(gz_buffer + strm.avail_in, 1, bytes_expected, gz_file);
+            double read_start = hmr_stats_enabled() ? hmr_stats_now() : 0.0;
+            bytes_expected = fread(gz_buffer + strm.avail_in, 1, bytes_expected, gz_file);
+            if (hmr_stats_enabled())
+            {
+                read_seconds += hmr_stats_now() - read_start;
+            }
+            gz_file_offset += bytes_expected;
             strm.avail_in += static_cast<uInt>(bytes_expected);
         }
     }
+    if (hmr_stats_enabled())
+    {
+        hmr_stats_stage_time("gzip.inflate", inflate_seconds);
+        hmr_stats_stage_time("gzip.read", read_seconds);
+        hmr_stats_count("gzip.compressed_bytes", gz_file_offset);
+        hmr_stats_count("gzip.raw_bytes", raw_bytes);
+    }
     //Mark GZIP parsing complete.
     hmr_bin_queue_finish(queue);
     // The parsing is completed, free the buffer.
@@ -104,7 +127,7 @@ void hmr_gzip_parse(FILE *gz_file, HMR_BIN_QUEUE *queue)
     inflateEnd(&strm);
 }
 
-HMR_GZ_HANDLER *hmr_gz_open_read(const char *filepath)
+HMR_GZ_HANDLER *hmr_gz_open_read(const char *filepath, size_t queue_depth)
 {
     //Read the GZIP file.
     HMR_GZ_HANDLER *gz_handler = new HMR_GZ_HANDLER();
@@ -119,8 +142,8 @@ HMR_GZ_HANDLER *hmr_gz_open_read(const char *filepath)
         time_error(1, "Failed to open GZIP file %s", filepath);
     }
     gz_handler->gz_file = gz_file;
-    //Allocate the processing queue, 3 for triple buffer.
-    hmr_bin_queue_create(&(gz_handler->queue), 3);
+    //Allocate the processing queue.
+    hmr_bin_queue_create(&(gz_handler->queue), queue_depth);
     //Prepare the buffer.
     hmr_bin_buf_create(&gz_handler->buffer);
     //Start the GZIP parsing thread.
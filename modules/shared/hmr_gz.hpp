@@ -4,8 +4,7 @@
 #include <cstdio>
 #include <thread>
 
-typedef struct HMR_BIN_QUEUE HMR_BIN_QUEUE;
-typedef struct HMR_BIN_DATA_BUF HMR_BIN_DATA_BUF;
+#include "hmr_bin_queue.hpp"
 
 typedef struct HMR_GZ_HANDLER
 {
@@ -15,7 +14,7 @@ typedef struct HMR_GZ_HANDLER
     std::thread parse_thread;
 } HMR_GZ_HANDLER;
 
-HMR_GZ_HANDLER *hmr_gz_open_read(const char *filepath);
+HMR_GZ_HANDLER *hmr_gz_open_read(const char *filepath, size_t queue_depth = HMR_BIN_QUEUE_DEPTH);
 void hmr_gz_close_read(HMR_GZ_HANDLER* gz_handler);
 
 #endif // HMR_GZ_H
@@ -0,0 +1,256 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#include "hmr_ui.hpp"
+
+#include "hmr_stats.hpp"
+
+typedef struct HMR_STATS_STAGE
+{
+    std::string name;
+    double seconds;
+    uint64_t calls;
+} HMR_STATS_STAGE;
+
+typedef struct HMR_STATS_COUNTER
+{
+    std::string name;
+    uint64_t value;
+} HMR_STATS_COUNTER;
+
+typedef struct HMR_STATS_SAMPLE
+{
+    std::string name;
+    uint64_t count;
+    double sum, max;
+} HMR_STATS_SAMPLE;
+
+typedef struct HMR_STATS_THREAD
+{
+    std::string pool;
+    int32_t index;
+    double busy, idle;
+} HMR_STATS_THREAD;
+
+typedef struct HMR_STATS
+{
+    std::string program, path;
+    double start;
+    std::mutex mutex;
+    //The entries are kept in the order they first appear.
+    std::vector<HMR_STATS_STAGE> stages;
+    std::vector<HMR_STATS_COUNTER> counters;
+    std::vector<HMR_STATS_SAMPLE> samples;
+    std::vector<HMR_STATS_THREAD> threads;
+} HMR_STATS;
+
+bool hmr_stats_active = false;
+HMR_STATS hmr_stats;
+
+template <typename T>
+T& hmr_stats_find(std::vector<T>& entries, const char* name, const T& init)
+{
+    for (T& entry : entries)
+    {
+        if (entry.name == name)
+        {
+            return entry;
+        }
+    }
+    entries.push_back(init);
+    return entries.back();
+}
+
+double hmr_stats_now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void hmr_stats_stage_time(const char* name, double seconds, uint64_t calls)
+{
+    if (!hmr_stats_active)
+    {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(hmr_stats.mutex);
+    HMR_STATS_STAGE& stage = hmr_stats_find(hmr_stats.stages, name, HMR_STATS_STAGE{ name, 0.0, 0 });
+    stage.seconds += seconds;
+    stage.calls += calls;
+}
+
+void hmr_stats_stage(const char* name, double start)
+{
+    hmr_stats_stage_time(name, hmr_stats_now() - start);
+}
+
+void hmr_stats_count(const char* name, uint64_t value)
+{
+    if (!hmr_stats_active)
+    {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(hmr_stats.mutex);
+    hmr_stats_find(hmr_stats.counters, name, HMR_STATS_COUNTER{ name, 0 }).value += value;
+}
+
+void hmr_stats_sample(const char* name, double value)
+{
+    if (!hmr_stats_active)
+    {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(hmr_stats.mutex);
+    HMR_STATS_SAMPLE& sample = hmr_stats_find(hmr_stats.samples, name, HMR_STATS_SAMPLE{ name, 0, 0.0, value });
+    ++sample.count;
+    sample.sum += value;
+    if (value > sample.max)
+    {
+        sample.max = value;
+    }
+}
+
+void hmr_stats_thread(const char* pool, double busy, double idle)
+{
+    if (!hmr_stats_active)
+    {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(hmr_stats.mutex);
+    int32_t index = 0;
+    for (const HMR_STATS_THREAD& thread : hmr_stats.threads)
+    {
+        if (thread.pool == pool)
+        {
+            ++index;
+        }
+    }
+    hmr_stats.threads.push_back(HMR_STATS_THREAD{ pool, index, busy, idle });
+}
+
+void hmr_stats_usage(uint64_t& peak_rss, double& user_seconds, double& system_seconds)
+{
+#ifdef _MSC_VER
+    PROCESS_MEMORY_COUNTERS memory;
+    peak_rss = GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory)) ? memory.PeakWorkingSetSize : 0;
+    FILETIME create_time, exit_time, kernel_time, user_time;
+    user_seconds = 0.0;
+    system_seconds = 0.0;
+    if (GetProcessTimes(GetCurrentProcess(), &create_time, &exit_time, &kernel_time, &user_time))
+    {
+        //The file times are in 100 ns.
+        user_seconds = static_cast<double>((static_cast<uint64_t>(user_time.dwHighDateTime) << 32) | user_time.dwLowDateTime) / 1e7;
+        system_seconds = static_cast<double>((static_cast<uint64_t>(kernel_time.dwHighDateTime) << 32) | kernel_time.dwLowDateTime) / 1e7;
+    }
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    //The max RSS is in KB on Linux.
+    peak_rss = static_cast<uint64_t>(usage.ru_maxrss) << 10;
+    user_seconds = static_cast<double>(usage.ru_utime.tv_sec) + static_cast<double>(usage.ru_utime.tv_usec) / 1e6;
+    system_seconds = static_cast<double>(usage.ru_stime.tv_sec) + static_cast<double>(usage.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+std::string hmr_stats_json_string(const std::string& text)
+{
+    std::string result = "\"";
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            result.push_back('\\');
+        }
+        result.push_back(c);
+    }
+    result.push_back('"');
+    return result;
+}
+
+bool hmr_stats_save(const char* path)
+{
+#ifdef _MSC_VER
+    FILE* stats_file = NULL;
+    if (fopen_s(&stats_file, path, "w") != 0 || !stats_file)
+#else
+    FILE* stats_file = fopen(path, "w");
+    if (!stats_file)
+#endif
+    {
+        return false;
+    }
+    uint64_t peak_rss;
+    double user_seconds, system_seconds;
+    hmr_stats_usage(peak_rss, user_seconds, system_seconds);
+    std::unique_lock<std::mutex> lock(hmr_stats.mutex);
+    fprintf(stats_file, "{\n  \"program\": %s,\n", hmr_stats_json_string(hmr_stats.program).c_str());
+    fprintf(stats_file, "  \"wall_seconds\": %.6f,\n", hmr_stats_now() - hmr_stats.start);
+    fprintf(stats_file, "  \"user_seconds\": %.6f,\n  \"system_seconds\": %.6f,\n", user_seconds, system_seconds);
+    fprintf(stats_file, "  \"peak_rss_bytes\": %llu,\n", static_cast<unsigned long long>(peak_rss));
+    fprintf(stats_file, "  \"stages\": [");
+    for (size_t i = 0; i < hmr_stats.stages.size(); ++i)
+    {
+        const HMR_STATS_STAGE& stage = hmr_stats.stages[i];
+        fprintf(stats_file, "%s\n    {\"name\": %s, \"seconds\": %.6f, \"calls\": %llu}", i ? "," : "",
+            hmr_stats_json_string(stage.name).c_str(), stage.seconds, static_cast<unsigned long long>(stage.calls));
+    }
+    fprintf(stats_file, "%s],\n  \"counters\": {", hmr_stats.stages.empty() ? "" : "\n  ");
+    for (size_t i = 0; i < hmr_stats.counters.size(); ++i)
+    {
+        const HMR_STATS_COUNTER& counter = hmr_stats.counters[i];
+        fprintf(stats_file, "%s\n    %s: %llu", i ? "," : "",
+            hmr_stats_json_string(counter.name).c_str(), static_cast<unsigned long long>(counter.value));
+    }
+    fprintf(stats_file, "%s},\n  \"samples\": {", hmr_stats.counters.empty() ? "" : "\n  ");
+    for (size_t i = 0; i < hmr_stats.samples.size(); ++i)
+    {
+        const HMR_STATS_SAMPLE& sample = hmr_stats.samples[i];
+        fprintf(stats_file, "%s\n    %s: {\"count\": %llu, \"mean\": %.6f, \"max\": %.6f}", i ? "," : "",
+            hmr_stats_json_string(sample.name).c_str(), static_cast<unsigned long long>(sample.count),
+            sample.count ? sample.sum / static_cast<double>(sample.count) : 0.0, sample.max);
+    }
+    fprintf(stats_file, "%s},\n  \"threads\": [", hmr_stats.samples.empty() ? "" : "\n  ");
+    for (size_t i = 0; i < hmr_stats.threads.size(); ++i)
+    {
+        const HMR_STATS_THREAD& thread = hmr_stats.threads[i];
+        fprintf(stats_file, "%s\n    {\"pool\": %s, \"index\": %d, \"busy_seconds\": %.6f, \"idle_seconds\": %.6f}", i ? "," : "",
+            hmr_stats_json_string(thread.pool).c_str(), thread.index, thread.busy, thread.idle);
+    }
+    fprintf(stats_file, "%s]\n}\n", hmr_stats.threads.empty() ? "" : "\n  ");
+    fclose(stats_file);
+    return true;
+}
+
+void hmr_stats_exit()
+{
+    if (hmr_stats_save(hmr_stats.path.c_str()))
+    {
+        time_print("Stats saved to %s", hmr_stats.path.c_str());
+    }
+    else
+    {
+        time_print("Failed to save stats to %s", hmr_stats.path.c_str());
+    }
+}
+
+void hmr_stats_enable(const char* program, const char* path)
+{
+    hmr_stats.program = program;
+    hmr_stats.path = path;
+    hmr_stats.start = hmr_stats_now();
+    hmr_stats_active = true;
+    //The report is also written when the program exits on an error.
+    atexit(hmr_stats_exit);
+}
@@ -0,0 +1,52 @@
+#ifndef HMR_STATS_H
+#define HMR_STATS_H
+
+#include <cstdint>
+
+/* Stage profiler, the records are dropped until it is enabled */
+extern bool hmr_stats_active;
+
+inline bool hmr_stats_enabled()
+{
+    return hmr_stats_active;
+}
+
+/* Enable the profiler, the JSON report is written to the path when the program exits */
+void hmr_stats_enable(const char* program, const char* path);
+bool hmr_stats_save(const char* path);
+
+/* Seconds from a steady clock, used as the start of a stage */
+double hmr_stats_now();
+/* Add the time from the start to a stage */
+void hmr_stats_stage(const char* name, double start);
+/* Add the time measured by the caller to a stage */
+void hmr_stats_stage_time(const char* name, double seconds, uint64_t calls = 1);
+/* Add to a counter, the hot loops should add in batches */
+void hmr_stats_count(const char* name, uint64_t value);
+/* Add a sample of a level, e.g. the occupancy of a queue */
+void hmr_stats_sample(const char* name, double value);
+/* Add the busy and idle time of a thread in a pool */
+void hmr_stats_thread(const char* pool, double busy, double idle);
+
+/* Time the scope as a stage */
+typedef struct HMR_STATS_SCOPE
+{
+    const char* name;
+    double start;
+
+    explicit HMR_STATS_SCOPE(const char* stage_name) :
+        name(stage_name),
+        start(hmr_stats_active ? hmr_stats_now() : 0.0)
+    {
+    }
+
+    ~HMR_STATS_SCOPE()
+    {
+        if (hmr_stats_active)
+        {
+            hmr_stats_stage(name, start);
+        }
+    }
+} HMR_STATS_SCOPE;
+
+#endif // HMR_STATS_H
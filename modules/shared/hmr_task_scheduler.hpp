@@ -0,0 +1,427 @@
+#ifndef HMR_TASK_SCHEDULER_H
+#define HMR_TASK_SCHEDULER_H
+
+#include <cstdint>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hmr_stats.hpp"
+#include "hmr_ui.hpp"
+
+namespace hmr
+{
+    class task_group;
+
+    typedef struct task_item
+    {
+        std::function<void()> run;
+        task_group* group;
+    } task_item;
+
+    /* Chase-Lev work stealing deque, the owner pushes and pops at the bottom, the thieves steal from the top */
+    class task_deque
+    {
+    public:
+        explicit task_deque(int64_t capacity = 256) :
+            m_top(0),
+            m_bottom(0),
+            m_ring(new ring(capacity))
+        {
+        }
+
+        ~task_deque()
+        {
+            delete m_ring.load(std::memory_order_relaxed);
+            for (ring* retired : m_retired)
+            {
+                delete retired;
+            }
+        }
+
+        void push(task_item* item)
+        {
+            int64_t bottom = m_bottom.load(std::memory_order_relaxed), top = m_top.load(std::memory_order_acquire);
+            ring* items = m_ring.load(std::memory_order_relaxed);
+            if (bottom - top > items->capacity - 1)
+            {
+                //The old ring may still be read by the thieves, it is kept until the deque is destroyed.
+                ring* grown = items->grow(bottom, top);
+                m_retired.push_back(items);
+                items = grown;
+                m_ring.store(items, std::memory_order_release);
+            }
+            items->put(bottom, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        task_item* pop()
+        {
+            int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            ring* items = m_ring.load(std::memory_order_relaxed);
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = m_top.load(std::memory_order_relaxed);
+            task_item* item = NULL;
+            if (top <= bottom)
+            {
+                item = items->get(bottom);
+                if (top == bottom)
+                {
+                    //The last item, race with the thieves.
+                    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    {
+                        item = NULL;
+                    }
+                    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                }
+            }
+            else
+            {
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        task_item* steal()
+        {
+            int64_t top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t bottom = m_bottom.load(std::memory_order_acquire);
+            if (top >= bottom)
+            {
+                return NULL;
+            }
+            task_item* item = m_ring.load(std::memory_order_acquire)->get(top);
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return NULL;
+            }
+            return item;
+        }
+
+    private:
+        struct ring
+        {
+            int64_t capacity;
+            std::atomic<task_item*>* items;
+
+            explicit ring(int64_t size) :
+                capacity(size),
+                items(new std::atomic<task_item*>[size])
+            {
+            }
+
+            ~ring()
+            {
+                delete[] items;
+            }
+
+            inline void put(int64_t index, task_item* item)
+            {
+                items[index & (capacity - 1)].store(item, std::memory_order_relaxed);
+            }
+
+            inline task_item* get(int64_t index) const
+            {
+                return items[index & (capacity - 1)].load(std::memory_order_relaxed);
+            }
+
+            ring* grow(int64_t bottom, int64_t top) const
+            {
+                ring* grown = new ring(capacity << 1);
+                for (int64_t i = top; i < bottom; ++i)
+                {
+                    grown->put(i, get(i));
+                }
+                return grown;
+            }
+        };
+
+        std::atomic<int64_t> m_top, m_bottom;
+        std::atomic<ring*> m_ring;
+        std::vector<ring*> m_retired;
+    };
+
+    /* Work stealing scheduler, each worker owns a deque, the tasks from the other threads go to the shared queue */
+    class task_scheduler
+    {
+    public:
+        explicit task_scheduler(int32_t thread_count = static_cast<int32_t>(std::thread::hardware_concurrency())) :
+            m_threadCount(thread_count < 1 ? 1 : thread_count),
+            m_threads(new std::thread[m_threadCount]),
+            m_epoch(0),
+            m_sleepers(0),
+            m_stop(false)
+        {
+            if (!m_threads)
+            {
+                time_error(-1, "Not enough memory to create thread array.");
+            }
+            for (int32_t i = 0; i < m_threadCount; ++i)
+            {
+                m_deques.push_back(new task_deque());
+            }
+            for (int32_t i = 0; i < m_threadCount; ++i)
+            {
+                m_threads[i] = std::thread(&task_scheduler::worker, this, i);
+            }
+        }
+
+        ~task_scheduler()
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_parkMutex);
+                m_stop = true;
+            }
+            m_parkCv.notify_all();
+            for (int32_t i = 0; i < m_threadCount; ++i)
+            {
+                m_threads[i].join();
+            }
+            delete[] m_threads;
+            for (task_deque* deque : m_deques)
+            {
+                delete deque;
+            }
+        }
+
+        int32_t size() const
+        {
+            return m_threadCount;
+        }
+
+        void submit(task_item* item)
+        {
+            //The workers push to their own deque, the other threads push to the shared queue.
+            const worker_slot& slot = current_slot();
+            if (slot.scheduler == this)
+            {
+                m_deques[slot.index]->push(item);
+            }
+            else
+            {
+                std::unique_lock<std::mutex> lock(m_sharedMutex);
+                m_shared.push_back(item);
+            }
+            //Wake up a parked worker, the epoch tells the parking worker that new tasks arrived.
+            m_epoch.fetch_add(1);
+            if (m_sleepers.load() > 0)
+            {
+                std::unique_lock<std::mutex> lock(m_parkMutex);
+                m_parkCv.notify_one();
+            }
+        }
+
+        /* Run one available task on the calling worker, returns false when no task is found */
+        bool run_one()
+        {
+            const worker_slot& slot = current_slot();
+            task_item* item = find_task(slot.scheduler == this ? slot.index : -1);
+            if (!item)
+            {
+                return false;
+            }
+            execute(item);
+            return true;
+        }
+
+        bool is_worker() const
+        {
+            return current_slot().scheduler == this;
+        }
+
+    private:
+        struct worker_slot
+        {
+            task_scheduler* scheduler;
+            int32_t index;
+        };
+
+        static worker_slot& current_slot()
+        {
+            static thread_local worker_slot slot{ NULL, -1 };
+            return slot;
+        }
+
+        task_item* find_task(int32_t index)
+        {
+            task_item* item = NULL;
+            if (index >= 0 && (item = m_deques[index]->pop()))
+            {
+                return item;
+            }
+            {
+                std::unique_lock<std::mutex> lock(m_sharedMutex);
+                if (!m_shared.empty())
+                {
+                    item = m_shared.front();
+                    m_shared.pop_front();
+                    return item;
+                }
+            }
+            //Steal from the other workers, starts from the next worker.
+            for (int32_t i = 1; i <= m_threadCount; ++i)
+            {
+                int32_t victim = (index + i + m_threadCount) % m_threadCount;
+                if (victim != index && (item = m_deques[victim]->steal()))
+                {
+                    return item;
+                }
+            }
+            return NULL;
+        }
+
+        static void execute(task_item* item);
+
+        void worker(int32_t index)
+        {
+            worker_slot& slot = current_slot();
+            slot.scheduler = this;
+            slot.index = index;
+            const bool stats = hmr_stats_enabled();
+            double thread_start = stats ? hmr_stats_now() : 0.0, busy = 0.0;
+            while (true)
+            {
+                task_item* item = find_task(index);
+                if (!item)
+                {
+                    //Record the epoch before the last search, a task submitted after it changes the epoch.
+                    uint64_t epoch = m_epoch.load();
+                    item = find_task(index);
+                    if (!item)
+                    {
+                        std::unique_lock<std::mutex> lock(m_parkMutex);
+                        if (m_stop)
+                        {
+                            break;
+                        }
+                        m_sleepers.fetch_add(1);
+                        m_parkCv.wait(lock, [this, epoch] { return m_stop || m_epoch.load() != epoch; });
+                        m_sleepers.fetch_sub(1);
+                        continue;
+                    }
+                }
+                if (stats)
+                {
+                    double task_start = hmr_stats_now();
+                    execute(item);
+                    busy += hmr_stats_now() - task_start;
+                }
+                else
+                {
+                    execute(item);
+                }
+            }
+            if (stats)
+            {
+                hmr_stats_thread("task_scheduler", busy, hmr_stats_now() - thread_start - busy);
+            }
+            slot.scheduler = NULL;
+            slot.index = -1;
+        }
+
+        int32_t m_threadCount;
+        std::thread* m_threads;
+        std::vector<task_deque*> m_deques;
+        std::mutex m_sharedMutex;
+        std::deque<task_item*> m_shared;
+        std::mutex m_parkMutex;
+        std::condition_variable m_parkCv;
+        std::atomic<uint64_t> m_epoch;
+        std::atomic<int32_t> m_sleepers;
+        bool m_stop;
+    };
+
+    /* Group of tasks, wait() returns when all the tasks of the group are finished */
+    class task_group
+    {
+    public:
+        explicit task_group(task_scheduler& scheduler) :
+            m_scheduler(scheduler),
+            m_pending(0),
+            m_waiters(0)
+        {
+        }
+
+        ~task_group()
+        {
+            wait();
+        }
+
+        template<typename F>
+        void run(F&& task)
+        {
+            int64_t pending = m_pending.fetch_add(1) + 1;
+            if (hmr_stats_enabled())
+            {
+                hmr_stats_sample("task_group.pending", static_cast<double>(pending));
+            }
+            m_scheduler.submit(new task_item{ std::function<void()>(std::forward<F>(task)), this });
+        }
+
+        /* Wait until no more than the given number of tasks are pending, it bounds the tasks in memory */
+        void wait_below(int64_t limit)
+        {
+            if (m_scheduler.is_worker())
+            {
+                //A worker helps to run the tasks instead of blocking.
+                while (m_pending.load() > limit)
+                {
+                    if (!m_scheduler.run_one())
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+                //Make sure the finishing task has released the lock.
+                std::unique_lock<std::mutex> lock(m_mutex);
+                return;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            ++m_waiters;
+            m_cv.wait(lock, [this, limit] { return m_pending.load() <= limit; });
+            --m_waiters;
+        }
+
+        void wait()
+        {
+            wait_below(0);
+        }
+
+    private:
+        friend class task_scheduler;
+
+        void finish()
+        {
+            //The counter is changed under the lock, so the group is not destroyed before the notification.
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pending.fetch_sub(1);
+            if (m_waiters > 0)
+            {
+                m_cv.notify_all();
+            }
+        }
+
+        task_scheduler& m_scheduler;
+        std::atomic<int64_t> m_pending;
+        int32_t m_waiters;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+    };
+
+    inline void task_scheduler::execute(task_item* item)
+    {
+        item->run();
+        task_group* group = item->group;
+        delete item;
+        group->finish();
+    }
+}
+
+#endif // HMR_TASK_SCHEDULER_H
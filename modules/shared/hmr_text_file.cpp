@@ -5,6 +5,7 @@
 #include <cassert>
 
 #include "hmr_path.hpp"
+#include "hmr_global.hpp"
 #include "hmr_gz.hpp"
 #include "hmr_bin_queue.hpp"
 #include "hmr_ui.hpp"
@@ -92,99 +93,16 @@ ssize_t text_getline_file(char** line, size_t* line_size, TEXT_LINE_BUF* line_bu
 
 ssize_t text_getline_gz(char** line, size_t* line_size, TEXT_LINE_BUF* line_buf, void* file_handle)
 {
-    //Check whether the buffer has and data rest.
-    if (line_buf->buf_size > line_buf->offset)
-    {
-        //Try to find '\n' inside the buffer.
-        size_t residual = line_buf->buf_size - line_buf->offset;
-        char* buf = line_buf->buf + line_buf->offset,
-            * pos = static_cast<char*>(memchr(buf, '\n', residual));
-        if (pos != NULL)
-        {
-            //We found the '\n'
-            *line = buf;
-            *line_size = pos - buf + 1;
-            //Update the buffer offset.
-            line_buf->offset += *line_size;
-            //Get the line size.
-            return *line_size;
-        }
-        //Move the residual data to the front of the buffer.
-        memcpy(line_buf->buf, buf, residual);
-        //Reset the offset and buffer size.
-        line_buf->buf_size = residual;
-        line_buf->offset = 0;
-    }
-    else
-    {
-        //Free the line buffer.
-        free(line_buf->buf);
-        line_buf->buf = NULL;
-        line_buf->buf_size = 0;
-        line_buf->offset = 0;
-    }
-    //Get the GZ handler.
+    HMR_UNUSED(line_buf)
+    //The lines are taken from the decompressed slices, only the lines across the slices are copied.
     HMR_GZ_HANDLER* gz_handle = reinterpret_cast<HMR_GZ_HANDLER*>(file_handle);
-    auto queue = gz_handle->queue;
-    //Fetch the data from the queue.
-    char* target;
-    for (;;)
-    {
-        HMR_BIN_SLICE bin_slice = hmr_bin_queue_pop(queue);
-        if (bin_slice.data == NULL)
-        {
-            //Reach the end of the data, still cannot fulfill, failed to fetch.
-            break;
-        }
-        //Append the data to the buffer.
-        if (line_buf->buf == NULL)
-        {
-            //Directly assign the slice data as buffer.
-            line_buf->buf = bin_slice.data;
-            line_buf->buf_size = bin_slice.data_size;
-            target = line_buf->buf;
-        }
-        else
-        {
-            //Extend the size of the current buf.
-            size_t expected_size = line_buf->buf_size + bin_slice.data_size;
-            if (line_buf->reserved < expected_size)
-            {
-                char* needed = static_cast<char*>(realloc(line_buf->buf, expected_size));
-                assert(needed);
-                line_buf->buf = needed;
-                line_buf->reserved = expected_size;
-            }
-            //Update the target.
-            target = line_buf->buf + line_buf->buf_size;
-            //Copy the data.
-            memcpy(target, bin_slice.data, bin_slice.data_size);
-            //Update the buffer size.
-            line_buf->buf_size = expected_size;
-            //Free the data slice.
-            free(bin_slice.data);
-        }
-        //Search for '\n'.
-        char* pos = static_cast<char*>(memchr(target, '\n', bin_slice.data_size));
-        if (pos != NULL)
-        {
-            //We found the line end!
-            *line = line_buf->buf;
-            *line_size = pos - line_buf->buf + 1;
-            line_buf->offset = *line_size;
-            return *line_size;
-        }
-    }
-    //Check whether we have any data in the buffer.
-    if (line_buf->buf && line_buf->buf_size > line_buf->offset)
+    char* data = hmr_bin_buf_fetch_line(gz_handle->buffer, gz_handle->queue, line_size);
+    if (data == NULL)
     {
-        //Pass the rest of the data.
-        *line = line_buf->buf;
-        *line_size = line_buf->buf_size;
-        line_buf->offset = *line_size;
-        return *line_size;
+        return -1;
     }
-    return -1;
+    *line = data;
+    return *line_size;
 }
 
 std::string text_open_read(const char *filepath, void **handle)
@@ -31,9 +31,9 @@ def __hana_module(bin_name: str, params: dict, param_arg_map: dict):
                 param_value = validator(param_value)
             # Set the argument.
             if isinstance(param_value, bool):
-                if arg:
+                if param_value and arg:
                     mod_args.append(arg)
-            if isinstance(param_value, list):
+            elif isinstance(param_value, list):
                 mod_args += [arg, *param_value]
             else:
                 mod_args += [arg, str(param_value)]
@@ -82,7 +82,7 @@ def extract(contig_path: str, mapping: List[str], output_prefix: str,
 def draft(hana_nodes: str, hana_reads: str, output_prefix: str,
           allele_table: str = None, reads_buffer: int = 512,
           node_min_links: int = 3, node_min_re: int = 10,
-          node_max_density: float = 2.0, **kwargs):
+          node_max_density: float = 2.0, reads_summary: bool = None, **kwargs):
     __hana_module('hana_draft', locals(), {
         'hana_nodes': ('-n', str, file_exist_validator),
         'hana_reads': ('-r', str, file_exist_validator),
@@ -92,10 +92,13 @@ def draft(hana_nodes: str, hana_reads: str, output_prefix: str,
         'node_min_links': ('--min-links', int, integer_validator),
         'node_min_re': ('--min-re', int, integer_validator),
         'node_max_density': ('--max-link-density', float, float_validator),
+        'reads_summary': ('--summary', bool, None),
     })
     # Check output file exists.
     edges_path = '{}.hmr_edges'.format(output_prefix)
     file_exist_validator(edges_path)
+    if reads_summary:
+        file_exist_validator('{}.hmr_summary'.format(output_prefix))
     return edges_path
 
 
@@ -139,13 +142,40 @@ def ordering(hana_nodes: str, hana_edges: str, hana_group: str, output_path: str
     return output_path
 
 
+def ordering_groups(hana_nodes: str, hana_edges: str, hana_groups: List[str],
+                    threads: int = 1, edges_buffer: int = 512,
+                    ea_seed: int = 806, ea_mutation_rate: float = 0.2, ea_converge_gens: int = 5000,
+                    ea_max_gens: int = 1000000, ea_num_of_populations: int = 100, **kwargs):
+    # Order all the groups in one process, the edges are loaded only once.
+    __hana_module('hana_ordering', locals(), {
+        'hana_nodes': ('-n', str, file_exist_validator),
+        'hana_edges': ('-e', str, file_exist_validator),
+        'hana_groups': ('-g', list, file_list_exist_validator),
+        'threads': ('-t', int, integer_validator),
+        'edges_buffer': ('-b', int, integer_validator),
+        'ea_seed': ('-s', int, integer_validator),
+        'ea_mutation_rate': ('--mutapb', float, float_validator),
+        'ea_converge_gens': ('--ngen', int, integer_validator),
+        'ea_max_gens': ('--max-gen', int, integer_validator),
+        'ea_num_of_populations': ('--npop', int, integer_validator),
+    })
+    # The sequence files are named after the group files.
+    seq_paths = ['{}.hmr_seq'.format(os.path.splitext(group_path)[0]) for group_path in hana_groups]
+    file_list_exist_validator(seq_paths)
+    return seq_paths
+
+
 def orientation(hana_nodes: str, hana_reads: str, hana_seqs: List[str],
-                reads_buffer: int = 512, **kwargs):
+                threads: int = 1, reads_buffer: int = 512, orientation_refine: bool = None,
+                hana_summary: str = None, **kwargs):
     __hana_module('hana_orientation', locals(), {
         'hana_nodes': ('-n', str, file_exist_validator),
         'hana_reads': ('-r', str, file_exist_validator),
+        'hana_summary': ('--summary', str, file_exist_validator),
         'hana_seqs': ('-s', list, file_list_exist_validator),
+        'threads': ('-t', int, integer_validator),
         'reads_buffer': ('-b', int, integer_validator),
+        'orientation_refine': ('--refine', bool, None),
     })
     # Check whether the orientation decided files exist.
     chromo_paths = []
@@ -157,9 +187,20 @@ def orientation(hana_nodes: str, hana_reads: str, hana_seqs: List[str],
     return chromo_paths
 
 
-def build(contig_path: str, hana_chromos: List[str], output_prefix: str, **kwargs):
+def build(contig_path: str, hana_chromos: List[str], output_prefix: str,
+          threads: int = 1, build_stream: bool = None, build_bgzip: bool = None,
+          build_line_width: int = None, build_complete: bool = None, build_gap_length: int = None,
+          build_gap_type: str = None, build_gap_evidence: str = None, **kwargs):
     __hana_module('hana_build', locals(), {
         'contig_path': ('-f', str, file_exist_validator),
         'hana_chromos': ('-c', list, file_list_exist_validator),
         'output_prefix': ('-o', str, None),
+        'threads': ('-t', int, integer_validator),
+        'build_stream': ('--stream', bool, None),
+        'build_bgzip': ('--bgzip', bool, None),
+        'build_line_width': ('-w', int, integer_validator),
+        'build_complete': ('--complete', bool, None),
+        'build_gap_length': ('--gap-length', int, integer_validator),
+        'build_gap_type': ('--gap-type', str, None),
+        'build_gap_evidence': ('--gap-evidence', str, None),
     })
@@ -56,19 +56,18 @@ class DiploidPipeline(Pipeline):
                                                         mapping=mapping_files,
                                                         output_prefix=output_prefix, enzyme=enzyme,
                                                         **self.settings)
+        # The reads summary is opt-in, its pair index is not bounded by the draft sort buffer.
         edges_path = hana_module.draft(hana_nodes=nodes_path, hana_reads=reads_path, output_prefix=output_prefix,
                                        **self.settings)
+        summary_path = '{}.hmr_summary'.format(output_prefix) if self.settings.get('reads_summary') else None
         group_paths = hana_module.partition(hana_nodes=nodes_path, hana_edges=edges_path,
                                             output_prefix=output_prefix, **self.settings)
-        seq_paths = []
-        for group_path in group_paths:
-            seq_path, _ = os.path.splitext(group_path)
-            seq_path = '{}.hmr_seq'.format(seq_path)
-            seq_paths.append(hana_module.ordering(hana_nodes=nodes_path, hana_edges=edges_path, hana_group=group_path,
-                                                  output_path=seq_path, **self.settings))
+        seq_paths = hana_module.ordering_groups(hana_nodes=nodes_path, hana_edges=edges_path, hana_groups=group_paths,
+                                                **self.settings)
         chromo_paths = hana_module.orientation(hana_nodes=nodes_path, hana_reads=reads_path, hana_seqs=seq_paths,
-                                               **self.settings)
-        hana_module.build(contig_path=contig_path, hana_chromos=chromo_paths, output_prefix=output_prefix)
+                                               hana_summary=summary_path, **self.settings)
+        hana_module.build(contig_path=contig_path, hana_chromos=chromo_paths, output_prefix=output_prefix,
+                          **self.settings)
 
 
 class PolyploidPipeline(Pipeline):